@@ -10,6 +10,8 @@
 /* ESP APIs */
 #include "esp_random.h"
 
+#include "th_sensor.h"
+
 /* Defines */
 #define ENGET_TASK_PERIOD (1000 / portTICK_PERIOD_MS)
 
@@ -18,10 +20,11 @@ float GetTemp(void);
 float GetHumi(void);
 float GetVoltage(void);
 float GetBatteryPercentage(void);
-esp_err_t i2c_master_init(void);
-esp_err_t sht40_read_measurement(float *temperature, float *humidity);
+esp_err_t InitTH(void);
+void GetTHSensors(struct th_fused *out);   // 各传感器最近一次读数与一致性
 void InitADC(void);
 void UpDateTH(void);
+void PrimeTH(int16_t temp, uint16_t humi);   // 以 0.01 单位的滤波输出预置滤波器
 void UpDataBattry(void);
 extern float temperature; // 声明全局变量
 extern float humidity;    // 声明全局变量
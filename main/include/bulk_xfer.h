@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef BULK_XFER_H
+#define BULK_XFER_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+/* NimBLE GAP APIs */
+#include "host/ble_gap.h"
+
+/* Defines */
+#define BULK_XFER_LL_OCTETS_MAX 251     // DLE 最大链路层载荷
+#define BULK_XFER_LL_TIME_MAX 2120      // 251 字节在 1M PHY 下的最长发送时间(us)
+#define BULK_XFER_LL_OCTETS_DEFAULT 27  // 默认链路层载荷
+#define BULK_XFER_LL_TIME_DEFAULT 328   // 27 字节在 1M PHY 下的发送时间(us)
+#define BULK_XFER_BENCH_DEFAULT_LEN (32 * 1024)
+
+/* Public function declarations */
+/* 进入批量传输模式: 2M PHY + 251 字节 DLE + 首选 MTU */
+int bulk_xfer_begin(uint16_t conn_handle);
+
+/* 退出批量传输模式并恢复原 PHY，返回本次传输的字节/秒 */
+uint32_t bulk_xfer_end(uint16_t conn_handle);
+
+/* 记录已发出的载荷字节数，用于吞吐量统计 */
+void bulk_xfer_account(size_t bytes);
+
+/* 当前连接单个 ATT 通知可承载的最大载荷 */
+uint16_t bulk_xfer_att_payload(uint16_t conn_handle);
+
+/* 最近一次 GATT 通知吞吐量测试的结果(字节/秒)，用于与其他通道对比 */
+uint32_t bulk_xfer_gatt_rate(void);
+
+/* 处理与批量传输相关的 GAP 事件(PHY 更新、断开) */
+void bulk_xfer_gap_event(struct ble_gap_event *event);
+
+/* 在独立任务中通过 GATT 通知发送测试数据并报告吞吐量 */
+int bulk_xfer_start_benchmark(uint16_t conn_handle, uint16_t attr_handle,
+                              uint32_t total_bytes);
+
+#endif // BULK_XFER_H
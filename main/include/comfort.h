@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef COMFORT_H
+#define COMFORT_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+/* Public function declarations */
+/*
+ * 由温度(0.01 °C)和相对湿度(0.01 %)导出的舒适度指标，
+ * 全部使用查表 + 整数插值计算，不调用 logf/expf。
+ */
+struct comfort_metrics {
+    int16_t dew_point;      // 露点，0.01 °C
+    uint16_t abs_humidity;  // 绝对湿度，0.01 g/m³
+    int16_t heat_index;     // 体感温度(NOAA 酷热指数)，0.01 °C
+};
+
+void comfort_compute(int16_t temp, uint16_t humi, struct comfort_metrics *out);
+
+/* 在传感器量程内与 libm 浮点实现对比，打印最大误差和每次计算的周期数 */
+void comfort_benchmark(void);
+
+#endif // COMFORT_H
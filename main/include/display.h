@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+
+/* Public function declarations */
+/* 上一个整点小时（按 history_now() 划分）内的刷新统计 */
+struct display_report {
+    uint16_t partial_refreshes;
+    uint16_t full_refreshes;
+    uint32_t energy_mj;     // 按面板刷新电流估算的能量
+};
+
+/*
+ * 初始化面板、全刷一帧并启动显示任务，在 history_init 之后调用。
+ * 深睡眠唤醒时面板仍显示着睡前的画面，改为从 flash 日志还原显示模型，不重刷。
+ */
+esp_err_t display_init(void);
+
+/* 采样后调用: 通知显示任务比较显示模型，只刷新变化的区域 */
+void display_update(void);
+
+/* 等待已通知的更新全部处理完（包括排队中的），深睡眠前调用 */
+void display_wait_idle(void);
+
+void display_get_report(struct display_report *report);
+
+#endif // DISPLAY_H
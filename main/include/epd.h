@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef EPD_H
+#define EPD_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+/* Defines */
+#define EPD_WIDTH CONFIG_EPD_WIDTH
+#define EPD_HEIGHT CONFIG_EPD_HEIGHT
+#define EPD_ROW_BYTES ((EPD_WIDTH + 7) / 8)
+
+/* 控制器(SSD1681)的两块图像 RAM */
+enum epd_ram {
+    EPD_RAM_NEW,    // 0x24，下次刷新显示的图像
+    EPD_RAM_OLD,    // 0x26，局部刷新时与新图像比较的上一帧
+};
+
+enum epd_refresh {
+    EPD_REFRESH_FULL,       // 全屏闪烁刷新，清除残影
+    EPD_REFRESH_PARTIAL,    // 只驱动有变化的像素，不闪烁
+};
+
+struct epd_stats {
+    uint32_t full_refreshes;
+    uint32_t partial_refreshes;
+    uint32_t full_busy_ms;      // 全刷累计忙时间
+    uint32_t partial_busy_ms;   // 局刷累计忙时间
+    uint32_t last_busy_ms;
+};
+
+/* Public function declarations */
+esp_err_t epd_init(void);
+
+/*
+ * 选定写入窗口并开始写 RAM。x 和 w 须为 8 的倍数(1bpp 每字节 8 个像素)，
+ * 窗口可覆盖到宽度按字节取整后的最后一列，
+ * 随后以行优先顺序调用 epd_write 写入 w/8*h 字节，1 为白 0 为黑。
+ */
+esp_err_t epd_begin_window(enum epd_ram ram, uint16_t x, uint16_t y, uint16_t w,
+                           uint16_t h);
+
+/* 写入图像数据，经 DMA 队列异步发送；返回时 data 即可复用 */
+esp_err_t epd_write(const uint8_t *data, size_t len);
+
+/* 以同一字节填充 len 字节 */
+esp_err_t epd_fill(uint8_t value, size_t len);
+
+/* 触发刷新并等待忙信号结束(忙引脚中断唤醒) */
+esp_err_t epd_refresh(enum epd_refresh mode);
+
+/* 两块 RAM 写白并全刷 */
+esp_err_t epd_clear(void);
+
+/* 进入深睡眠，之后须重新 epd_init */
+esp_err_t epd_sleep(void);
+
+void epd_get_stats(struct epd_stats *stats);
+
+#endif // EPD_H
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "history.h"
+
+/* Defines */
+#define FLASH_LOG_PARTITION_LABEL "history"
+#define FLASH_LOG_PARTITION_SUBTYPE 0x40
+#define FLASH_LOG_MAGIC 0x5448          // "TH"
+#define FLASH_LOG_VERSION 4             // 4: 块头增加首条记录序号
+#define FLASH_LOG_SECTOR_SIZE 4096
+#define FLASH_LOG_BLOCK_SIZE 256        // 一个 flash 页
+#define FLASH_LOG_BLOCKS_PER_SECTOR (FLASH_LOG_SECTOR_SIZE / FLASH_LOG_BLOCK_SIZE)
+#define FLASH_LOG_PAYLOAD_SIZE (FLASH_LOG_BLOCK_SIZE - sizeof(struct flash_log_block_hdr))
+#define FLASH_LOG_BLOCK_NONE UINT32_MAX
+
+/*
+ * 块头，位于每个页对齐块的开头。
+ * 载荷为 hist_codec 压缩的 count 条记录，每块可独立解码。
+ * crc 覆盖块头中 crc 之前的字段以及整个载荷区。
+ */
+struct flash_log_block_hdr {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t count;          // 块内记录条数
+    uint32_t seq;           // 全局块序号，单调递增
+    uint32_t erase_count;   // 所在扇区的擦除次数
+    uint32_t first_ts;      // 块内第一条记录的时间戳，用于时间索引
+    uint16_t len;           // 载荷有效字节数
+    uint16_t reserved;
+    uint32_t first_seq;     // 块内第一条记录的序号，块内序号连续
+    uint32_t crc;
+};
+
+typedef int (*flash_log_visit_fn)(const struct flash_log_block_hdr *hdr,
+                                  const uint8_t *payload, void *arg);
+typedef void (*flash_log_replay_fn)(const struct history_sample *sample, void *arg);
+typedef uint32_t (*flash_log_correct_fn)(uint32_t seq, uint32_t ts);
+
+/* Public function declarations */
+/* 查找数据分区并从块头恢复写指针 */
+esp_err_t flash_log_init(void);
+
+/* 压缩暂存一条记录，块载荷写满或凑满 CONFIG_FLASH_LOG_BATCH 条后写入一个块 */
+void flash_log_append(const struct history_sample *sample);
+
+/* 立即写出暂存的记录 */
+esp_err_t flash_log_flush(void);
+
+/*
+ * 注册读出时的时间戳修正: 日志中保存记录时的原始时间戳，校时修正在读出时由 fn 施加。
+ * flash_log_seek、flash_log_replay、flash_log_read_block、flash_log_last 和
+ * flash_log_last_ts 返回修正后的时间戳；flash_log_read_raw 和 flash_log_visit_block
+ * 给出原始编码，由调用方修正。fn 须保持时间戳随序号单调不减。
+ */
+void flash_log_set_correct(flash_log_correct_fn fn);
+
+/* 块遍历: 从 first 开始依次 next，直到返回 FLASH_LOG_BLOCK_NONE */
+uint32_t flash_log_first_block(void);
+uint32_t flash_log_next_block(uint32_t block);
+
+/* 读取并校验一个块的记录，返回条数，无效块返回 -1 */
+int flash_log_read_block(uint32_t block, struct flash_log_block_hdr *hdr,
+                         struct history_sample *out, size_t max);
+
+/* 读取并校验一个块，payload 接收未解码的压缩载荷(FLASH_LOG_PAYLOAD_SIZE 字节) */
+int flash_log_read_raw(uint32_t block, struct flash_log_block_hdr *hdr, uint8_t *payload);
+
+/*
+ * 查找可能包含 ts 及之后记录的第一个块: 先在内存中的扇区索引上二分，
+ * 再顺序读取该扇区内至多 16 个块头，flash 读取次数与日志长度无关。
+ */
+uint32_t flash_log_seek(uint32_t ts);
+
+/* 与 flash_log_seek 相同，按记录序号定位 */
+uint32_t flash_log_seek_seq(uint32_t seq);
+
+/*
+ * 按序号顺序对时间戳不早于 from_ts 的已落盘记录逐条调用 fn，返回回放的条数。
+ * 用于重启或深睡眠唤醒后重建 RAM 中的派生状态。
+ */
+size_t flash_log_replay(uint32_t from_ts, flash_log_replay_fn fn, void *arg);
+
+/* 读取最后一条已落盘的记录，空日志返回 -1 */
+int flash_log_last(struct history_sample *sample);
+
+/* 日志中最后一条记录的时间戳，空日志返回 0 */
+uint32_t flash_log_last_ts(void);
+
+/* 最后一条已落盘记录的序号 + 1，空日志返回 0 */
+uint32_t flash_log_end_seq(void);
+
+/* 最旧一条已落盘记录的序号，空日志返回 flash_log_end_seq() */
+uint32_t flash_log_first_seq(void);
+
+/*
+ * 启动时暂存块是否完好: 软件复位等不清 RAM 的重启后为真，暂存的记录已写出，
+ * end_seq 之前没有丢失的记录；上电/掉电复位后为假。
+ */
+bool flash_log_stage_intact(void);
+
+/* 将分区映射到数据地址空间，用于零拷贝流式读取；结束后调用 flash_log_mmap_end */
+esp_err_t flash_log_mmap_begin(void);
+void flash_log_mmap_end(void);
+
+/*
+ * 在映射中校验一个块，并以指向 flash 的块头/载荷指针调用 fn，返回 fn 的返回值；
+ * 无效块返回 -1。fn 在日志锁内执行，应尽快返回。
+ */
+int flash_log_visit_block(uint32_t block, flash_log_visit_fn fn, void *arg);
+
+#endif // FLASH_LOG_H
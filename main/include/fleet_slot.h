@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef FLEET_SLOT_H
+#define FLEET_SLOT_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+/* Defines */
+#define FLEET_SLOT_NVS_NAMESPACE "fleet"
+
+/* 线上格式(小端): 周期秒(2) + 时隙偏移毫秒(4) + 突发广播时长毫秒(2) */
+#define FLEET_SLOT_WIRE_BYTES 8
+
+/*
+ * 采样网格: UTC 时间 k * period_s + offset_ms 为本设备的采样与突发广播时刻。
+ * 网关为每台设备分配互不重叠的偏移，之后只需在各时隙内短暂扫描。
+ */
+struct fleet_slot_cfg {
+    uint16_t period_s;
+    uint32_t offset_ms;     // 小于 period_s * 1000
+    uint16_t burst_ms;      // 每个时隙的广播时长
+};
+
+/* Public function declarations */
+#if CONFIG_FLEET_SLOTS
+/* 读取 NVS 中的时隙；网关未分配时按设备地址散列出默认偏移 */
+void fleet_slot_init(void);
+
+/* 已与网关校时才按网格运行，否则保持连续广播以便被发现 */
+bool fleet_slot_active(void);
+
+void fleet_slot_get(struct fleet_slot_cfg *cfg);
+
+/* 校验并保存网关下发的时隙，非法参数返回 ESP_ERR_INVALID_ARG */
+int fleet_slot_set(const struct fleet_slot_cfg *cfg);
+
+void fleet_slot_encode(const struct fleet_slot_cfg *cfg, uint8_t *buf);
+void fleet_slot_decode(const uint8_t *buf, struct fleet_slot_cfg *cfg);
+
+/* 距下一个时隙起点的毫秒数，始终大于 0 */
+uint32_t fleet_slot_wait_ms(void);
+#endif
+
+#endif // FLEET_SLOT_H
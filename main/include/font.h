@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef FONT_H
+#define FONT_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+/* Defines */
+/*
+ * 位图字体，由 tools/gen_font.py 在构建时生成到 font_data.c。
+ * 每个字形按行存放，每行 (width + 7) / 8 字节，高位在左，1 为墨迹。
+ * 字符集见 chars，其中 '\'' 为度数符号，'*' 为蓝牙图标。
+ */
+struct font_glyph {
+    uint16_t offset;    // 在 bitmap 中的字节偏移
+    uint8_t width;      // 像素宽度
+};
+
+struct font {
+    uint8_t height;
+    uint8_t spacing;    // 字符间距(像素)
+    const char *chars;
+    const struct font_glyph *glyphs;
+    const uint8_t *bitmap;
+};
+
+/* Public function declarations */
+extern const struct font font_small;
+extern const struct font font_large;
+
+#endif // FONT_H
@@ -10,14 +10,59 @@
 /* NimBLE GAP APIs */
 #include "host/ble_gap.h"
 #include "services/gap/ble_svc_gap.h"
+#include "sdkconfig.h"
 
 /* Defines */
 #define BLE_GAP_APPEARANCE_GENERIC_TAG 0x0200
 #define BLE_GAP_URI_PREFIX_HTTPS 0x17
 #define BLE_GAP_LE_ROLE_PERIPHERAL 0x00
+#define BLE_GAP_ESS_UUID16 0x181A
+#define BLE_GAP_READINGS_SVC_DATA_LEN 7
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+/* 扩展广播 API 下各广播集的实例号 */
+#if !CONFIG_LONG_RANGE_ADV || CONFIG_LONG_RANGE_ADV_LEGACY_COMPAT
+#define LEGACY_ADV_INSTANCE 0
+#define LEGACY_ADV_COUNT 1
+#else
+#define LEGACY_ADV_COUNT 0
+#endif
+
+#if CONFIG_LONG_RANGE_ADV
+#define LONG_RANGE_ADV_INSTANCE LEGACY_ADV_COUNT
+#define LONG_RANGE_ADV_COUNT 1
+#else
+#define LONG_RANGE_ADV_COUNT 0
+#endif
+
+#if CONFIG_PERIODIC_READINGS_ADV
+#define PERIODIC_ADV_INSTANCE (LEGACY_ADV_COUNT + LONG_RANGE_ADV_COUNT)
+#define PERIODIC_ADV_COUNT 1
+#else
+#define PERIODIC_ADV_COUNT 0
+#endif
+
+#if LEGACY_ADV_COUNT + LONG_RANGE_ADV_COUNT + PERIODIC_ADV_COUNT > CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES
+#error "CONFIG_BT_NIMBLE_MAX_EXT_ADV_INSTANCES too small for the enabled advertising sets"
+#endif
+#endif
+
+#if CONFIG_LONG_RANGE_ADV
+#if CONFIG_LONG_RANGE_CODED_S2
+#define LONG_RANGE_PHY_OPTS BLE_GAP_LE_PHY_CODED_S2
+#else
+#define LONG_RANGE_PHY_OPTS BLE_GAP_LE_PHY_CODED_S8
+#endif
+#endif
 
 /* Public function declarations */
 void adv_init(void);
+void gap_update_readings(void);
+uint8_t gap_conn_count(void);
+#if CONFIG_FLEET_SLOTS
+/* 在本设备的采样时隙内以短间隔广播，持续时隙配置的突发时长后停止 */
+void gap_adv_burst(void);
+#endif
 int gap_init(void);
 
 #endif // GAP_SVC_H
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef HIST_CODEC_H
+#define HIST_CODEC_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "history.h"
+
+/* Defines */
+/* 单条记录编码后的最大长度: 标志(1) + 时间(5) + 温度(3) + 湿度(3) + 电量(2) */
+#define HIST_CODEC_MAX_SAMPLE_BYTES 14
+
+/*
+ * 编码格式(每个编码块可独立解码):
+ *   每条记录以 1 字节标志开头，标志位为 1 的字段才跟随数据。
+ *   第一条记录的各字段为绝对值，之后时间戳为二阶差分(delta-of-delta)，
+ *   温度/湿度/电量为一阶差分，差分均为 zigzag + varint 编码。
+ */
+#define HIST_CODEC_F_TS 0x01
+#define HIST_CODEC_F_TEMP 0x02
+#define HIST_CODEC_F_HUMI 0x04
+#define HIST_CODEC_F_BATT 0x08
+
+/* 编/解码器状态，保存上一条记录用于差分 */
+struct hist_codec_state {
+    const uint8_t *rd;      // 解码时的输入
+    uint8_t *wr;            // 编码时的输出
+    size_t cap;
+    size_t len;
+    uint16_t count;
+    uint32_t prev_ts;
+    int32_t prev_dts;
+    int16_t prev_temp;
+    uint16_t prev_humi;
+    uint8_t prev_batt;
+};
+
+/* Public function declarations */
+void hist_codec_enc_init(struct hist_codec_state *st, uint8_t *buf, size_t cap);
+
+/* 追加一条记录；放不下时返回 -1 且状态不变 */
+int hist_codec_enc_add(struct hist_codec_state *st, const struct history_sample *sample);
+
+void hist_codec_dec_init(struct hist_codec_state *st, const uint8_t *buf, size_t len);
+
+/* 解码下一条记录；数据结束返回 1，数据损坏返回 -1 */
+int hist_codec_dec_next(struct hist_codec_state *st, struct history_sample *sample);
+
+#endif // HIST_CODEC_H
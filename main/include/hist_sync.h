@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef HIST_SYNC_H
+#define HIST_SYNC_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+#include "rollup.h"
+
+/* Defines */
+/* 通知头: 首条序号(4，小端) + 记录条数(1)，之后为 hist_codec 块 */
+#define HIST_SYNC_HDR_LEN 5
+
+/* Public function declarations */
+/*
+ * 在独立任务中补发序号不小于 since_seq 的记录: 先从 RAM 缓冲区读取，
+ * 已被覆盖的部分从 flash 日志读取。每个通知按当前 MTU 打包一批序号连续的记录，
+ * 最后发送一个记录条数为 0 的通知，其序号为下一条将要产生的记录的序号。
+ */
+int hist_sync_start(uint16_t conn_handle, uint16_t attr_handle, uint32_t since_seq);
+
+/*
+ * 在同一发送任务中下载某分辨率下起始时间不早于 since 的聚合桶，
+ * 每个通知: 分辨率(1) + 桶数(1) + 若干 ROLLUP_WIRE_BYTES 记录，桶数为 0 表示结束。
+ * 补发或下载正在进行时返回 BLE_HS_EBUSY。
+ */
+int hist_sync_rollup_start(uint16_t conn_handle, uint16_t attr_handle,
+                           enum rollup_level level, uint32_t since);
+
+#endif // HIST_SYNC_H
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "sdkconfig.h"
+
+/* Defines */
+/* 每条记录占用: 时间戳(4) + 温度(2) + 湿度(2) + 电量(1) */
+#define HISTORY_SAMPLE_BYTES 9
+#define HISTORY_CAPACITY (CONFIG_HISTORY_RAM_BUDGET / HISTORY_SAMPLE_BYTES)
+#define HISTORY_WIRE_BYTES 9
+#define HISTORY_NVS_NAMESPACE "history"
+
+/* 单条历史记录，温湿度单位均为 0.01 */
+struct history_sample {
+    uint32_t seq;           // 单调递增的记录序号，不参与压缩编码
+    uint32_t ts;
+    int16_t temp;
+    uint16_t humi;
+    uint8_t batt;
+};
+
+/* Public function declarations */
+/* 以 flash 日志中最后的时间戳和序号为基准，在 flash_log_init 之后调用 */
+void history_init(void);
+
+/* 单调时间戳(秒)，重启后从日志中最后的时间戳继续，由 timebase 提供 */
+uint32_t history_now(void);
+
+/*
+ * 校时后修正此前所有记录的时间戳: ramp 为真时 (from, to] 内的记录按线性比例修正，
+ * 晚于 to 的修正 offset；否则全部平移 offset。RAM 缓冲区原地修正；
+ * flash 日志不改写，修正点存入 NVS，读出时由 history_correct_ts 施加。
+ * 回拨量超过区间长度时按区间长度修正，保持单调不减。
+ */
+void history_adjust_ts(uint32_t from, uint32_t to, int32_t offset, bool ramp);
+
+/* 对从 flash 日志读出的原始时间戳施加此后各次校时的修正 */
+uint32_t history_correct_ts(uint32_t seq, uint32_t ts);
+
+/* 追加一条记录，O(1)，写满后覆盖最旧的记录，返回分配的序号 */
+uint32_t history_append(uint32_t ts, int16_t temp, uint16_t humi, uint8_t batt);
+
+/* 用 EnGet 中最新的读数追加一条记录，并写入 flash 日志 */
+void history_record(void);
+
+/* 当前保存的记录条数 */
+size_t history_count(void);
+
+/* 第一条时间戳不早于 ts 的记录的逻辑下标(0 为最旧)，二分查找 */
+size_t history_find(uint32_t ts);
+
+/* 读取逻辑下标 idx 处的记录，越界返回 -1 */
+int history_get(size_t idx, struct history_sample *sample);
+
+/* 按序号读取，返回 0；已被覆盖返回 -1，尚未记录返回 1 */
+int history_get_seq(uint32_t seq, struct history_sample *sample);
+
+/* 最新一条记录，缓冲区为空返回 -1 */
+int history_latest(struct history_sample *sample);
+
+/* 缓冲区中最旧记录的序号 */
+uint32_t history_first_seq(void);
+
+/* 读取 [t_from, t_to] 内的记录，最多 max 条，返回实际条数 */
+size_t history_read_range(uint32_t t_from, uint32_t t_to,
+                          struct history_sample *out, size_t max);
+
+/* 按线上格式(小端)编码一条记录，返回 HISTORY_WIRE_BYTES */
+size_t history_encode(const struct history_sample *sample, uint8_t *buf);
+
+/* 注册 L2CAP 历史数据流 */
+int history_stream_init(void);
+
+#endif // HISTORY_H
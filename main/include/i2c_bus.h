@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "driver/i2c_master.h"
+#include "esp_err.h"
+
+/* Defines */
+#define I2C_BUS_MAX_HZ 400000       // Fast-mode 上限
+#define I2C_BUS_QUEUE_LEN 8
+
+/*
+ * 单个传输: 只有 tx 为写，只有 rx 为读，两者都有时为写后重复起始读。
+ * 同一次 i2c_bus_transfer 中的多个传输在一次总线占用内背靠背执行。
+ */
+struct i2c_bus_op {
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+};
+
+struct i2c_bus_stats {
+    uint32_t transactions;  // 已执行的请求数
+    uint32_t batched;       // 排队后与前一请求连续执行、无需再次唤醒的请求数
+    uint32_t errors;
+    uint32_t recoveries;    // 总线卡死后的复位次数
+};
+
+/* Public function declarations */
+/* 创建总线与事务任务，其他驱动添加设备前调用 */
+esp_err_t i2c_bus_init(void);
+
+/* 在总线上添加设备，scl_hz 超过 I2C_BUS_MAX_HZ 时按上限处理 */
+esp_err_t i2c_bus_add_device(uint8_t addr, uint32_t scl_hz, i2c_master_dev_handle_t *dev);
+
+esp_err_t i2c_bus_remove_device(i2c_master_dev_handle_t dev);
+
+/*
+ * 提交一组传输并等待完成。请求按到达顺序排队，由事务任务独占总线执行；
+ * 超时视为总线卡死，复位总线后重试一次，最坏耗时有上界。
+ */
+esp_err_t i2c_bus_transfer(i2c_master_dev_handle_t dev, const struct i2c_bus_op *ops,
+                           size_t count);
+
+esp_err_t i2c_bus_write(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t len);
+esp_err_t i2c_bus_read(i2c_master_dev_handle_t dev, uint8_t *rx, size_t len);
+esp_err_t i2c_bus_write_read(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len);
+
+/* 探测地址是否有设备应答 */
+esp_err_t i2c_bus_probe(uint8_t addr);
+
+void i2c_bus_get_stats(struct i2c_bus_stats *stats);
+
+#endif // I2C_BUS_H
@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef L2CAP_COC_H
+#define L2CAP_COC_H
+
+/* Includes */
+/* NimBLE L2CAP APIs */
+#include "host/ble_l2cap.h"
+
+/* Defines */
+#define L2CAP_COC_PSM CONFIG_L2CAP_COC_PSM
+#define L2CAP_COC_MTU CONFIG_L2CAP_COC_MTU
+#define L2CAP_COC_MAX_SOURCES 6
+
+/* 客户端在通道上发送的单字节请求 */
+#define L2CAP_COC_REQ_BENCHMARK 0x01
+#define L2CAP_COC_REQ_HISTORY 0x02
+#define L2CAP_COC_REQ_HISTORY_PACKED 0x03    // 同 0x02，SDU 为差分压缩块
+#define L2CAP_COC_REQ_HISTORY_FLASH 0x04     // flash 日志中的压缩块
+
+/* 数据源: 由请求码选择，在流任务中被依次调用 */
+struct l2cap_coc_source {
+    /* 收到请求时调用，params 为请求码之后的字节，返回非 0 拒绝请求 */
+    int (*open)(const uint8_t *params, uint16_t len, void *arg);
+
+    /*
+     * 直接向 sdu 追加不超过 max_len 字节(os_mbuf_append 会从 msys 池
+     * 链接新的 mbuf，无需中间缓冲区)。
+     * 返回 0 表示还有后续数据，BLE_HS_EDONE 表示这是最后一个 SDU。
+     */
+    int (*fill)(struct os_mbuf *sdu, uint16_t max_len, void *arg);
+
+    /* 可选，数据流结束(完成、断开或出错)后调用，释放 open 中申请的资源 */
+    void (*close)(void *arg);
+
+    void *arg;
+};
+
+/* Public function declarations */
+/* 注册 L2CAP CoC 服务端 */
+int l2cap_coc_init(void);
+
+/* 为请求码注册数据源 */
+int l2cap_coc_register_source(uint8_t req,
+                              const struct l2cap_coc_source *src);
+
+#endif // L2CAP_COC_H
@@ -15,10 +15,25 @@
 /* Defines */
 #define BLINK_GPIO CONFIG_BLINK_GPIO
 
+/* 状态指示图案，由外设硬件播放，CPU 睡眠时不需要唤醒 */
+enum led_pattern {
+    LED_PATTERN_OFF,
+    LED_PATTERN_ON,
+    LED_PATTERN_ADVERTISING,
+    LED_PATTERN_CONNECTED,
+    LED_PATTERN_LOW_BATTERY,
+    LED_PATTERN_SENSOR_ERROR,
+    LED_PATTERN_MAX,
+};
+
 /* Public function declarations */
 uint8_t get_led_state(void);
 void led_on(void);
 void led_off(void);
 void led_init(void);
 
+/* 切换状态图案，与当前图案相同时不做任何操作 */
+void led_set_pattern(enum led_pattern pattern);
+enum led_pattern led_get_pattern(void);
+
 #endif // LED_H
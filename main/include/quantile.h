@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef QUANTILE_H
+#define QUANTILE_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+/* Defines */
+#define QUANTILE_P(p) ((uint16_t)((p) * 65535))   // 分位点，Q16 定点
+#define QUANTILE_MARKERS 5
+#define QUANTILE_FRAC_BITS 8                      // 标记高度的小数位
+
+/*
+ * P² 流式分位数估计 (Jain & Chlamtac)，全部使用定点运算。
+ * 只保存 5 个标记的高度和位置，内存固定为 44 字节，每个样本 O(1) 更新。
+ */
+struct quantile_p2 {
+    int32_t q[QUANTILE_MARKERS];    // 标记高度，Q8
+    int32_t n[QUANTILE_MARKERS];    // 标记位置(从 1 开始)
+    uint16_t p;                     // 目标分位点，Q16
+    uint16_t count;                 // 达到 5 之前为已收到的样本数
+};
+
+/* Public function declarations */
+void quantile_init(struct quantile_p2 *est, uint16_t p);
+
+void quantile_add(struct quantile_p2 *est, int32_t x);
+
+/* 当前估计值，没有样本时返回 0 */
+int32_t quantile_value(const struct quantile_p2 *est);
+
+#endif // QUANTILE_H
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef RENDER_H
+#define RENDER_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+
+#include "epd.h"
+#include "font.h"
+
+/* Defines */
+#define RENDER_MAX_ITEMS 12
+#define RENDER_TEXT_MAX 8
+#define RENDER_BAND_BYTES 128   // 条带缓冲区大小，与面板尺寸无关
+
+/*
+ * 条带渲染: 不保留整帧缓冲，而是保存一份很小的显示列表，
+ * 按窗口逐条带(若干行)栅格化后直接推送给墨水屏。
+ */
+enum render_type {
+    RENDER_TEXT,
+    RENDER_RECT,
+};
+
+struct render_item {
+    uint8_t type;
+    bool black;
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    const struct font *font;
+    char text[RENDER_TEXT_MAX];
+};
+
+struct render_scene {
+    struct render_item items[RENDER_MAX_ITEMS];
+    uint8_t count;
+};
+
+/* Public function declarations */
+void render_clear(struct render_scene *scene);
+
+/* 添加文本，超出 RENDER_TEXT_MAX - 1 的字符被截断；列表已满返回 -1 */
+int render_text(struct render_scene *scene, uint16_t x, uint16_t y,
+                const struct font *font, bool black, const char *text);
+
+int render_rect(struct render_scene *scene, uint16_t x, uint16_t y, uint16_t w,
+                uint16_t h, bool black);
+
+uint16_t render_text_width(const struct font *font, const char *text);
+
+/*
+ * 栅格化窗口 [x, x+w) 内第 y 行起的 rows 行到 buf，x、w 为 8 的倍数，
+ * 每行 w/8 字节，1 为白 0 为黑，与墨水屏 RAM 格式一致。
+ */
+void render_band(const struct render_scene *scene, uint16_t x, uint16_t y,
+                 uint16_t w, uint16_t rows, uint8_t *buf);
+
+/* 逐条带渲染窗口并写入墨水屏指定 RAM */
+esp_err_t render_window(const struct render_scene *scene, enum epd_ram ram,
+                        uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+#endif // RENDER_H
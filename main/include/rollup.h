@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "history.h"
+
+/* Defines */
+#define ROLLUP_MINUTES 60       // 保留最近 60 分钟
+#define ROLLUP_HOURS 48         // 保留最近 48 小时
+#define ROLLUP_DAYS 31          // 保留最近 31 天
+#define ROLLUP_NVS_NAMESPACE "rollup"
+
+/*
+ * 线上格式(小端): 起始时间(4) + 条数(4) + 温度最小/最大/均值(6) + 湿度最小/最大/均值(6)
+ *                 + 温度中位数/P95(4) + 湿度中位数/P95(4)
+ */
+#define ROLLUP_WIRE_BYTES 28
+
+enum rollup_level {
+    ROLLUP_MINUTE = 0,
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_LEVELS,
+};
+
+/* 一个时间桶的聚合值，温湿度单位均为 0.01 */
+struct rollup_bucket {
+    uint32_t start;         // 桶起始时间戳，按分辨率对齐
+    uint32_t count;
+    int16_t temp_min;
+    int16_t temp_max;
+    uint16_t humi_min;
+    uint16_t humi_max;
+    int32_t temp_sum;       // 传感器量程内一天 1 Hz 采样也不会溢出
+    uint32_t humi_sum;
+    int16_t temp_p50;       // 分位数为 P² 流式估计值
+    int16_t temp_p95;
+    uint16_t humi_p50;
+    uint16_t humi_p95;
+};
+
+/* Public function declarations */
+/* 从 NVS 恢复已完成的小时/天聚合，并从 flash 日志回放正在累计的当前桶，在 history_init 之后调用 */
+void rollup_init(void);
+
+/* 用一条新记录更新各分辨率的聚合，O(1) */
+void rollup_add(const struct history_sample *sample);
+
+/* 某分辨率下的桶数，包括正在累计的当前桶 */
+size_t rollup_count(enum rollup_level level);
+
+/* 读取第 idx 个桶(0 为最旧，最后一个是当前桶)，越界返回 -1 */
+int rollup_get(enum rollup_level level, size_t idx, struct rollup_bucket *bucket);
+
+/* 按线上格式编码一个桶，返回 ROLLUP_WIRE_BYTES */
+size_t rollup_encode(const struct rollup_bucket *bucket, uint8_t *buf);
+
+#endif // ROLLUP_H
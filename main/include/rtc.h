@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef RTC_H
+#define RTC_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+
+/* Defines */
+#define RTC_PCF8563_ADDR 0x51
+#define RTC_TIMER_MAX_S 255     // 1 Hz 倒计时器的最大计数
+
+/* Public function declarations */
+/* 探测外部 RTC 并清除上次的唤醒标志，须在 i2c_bus_init 之后调用 */
+esp_err_t rtc_init(void);
+
+/* 读取 UTC Unix 时间；RTC 掉电后时间无效时返回 ESP_ERR_INVALID_STATE */
+esp_err_t rtc_get_time(uint32_t *now);
+
+esp_err_t rtc_set_time(uint32_t now);
+
+/* RTC 中是否有有效时间 */
+bool rtc_time_valid(void);
+
+/*
+ * 在 at 时刻拉低 INT。255 s 以内用 1 Hz 倒计时器，
+ * 更远的目标用分钟闹钟，在目标所在分钟的 0 秒触发。
+ */
+esp_err_t rtc_set_wakeup(uint32_t at);
+
+/* 设置唤醒后关闭 SoC，由 RTC 的 INT 引脚唤醒；只在出错时返回 */
+void rtc_deep_sleep_until(uint32_t at);
+
+#endif // RTC_H
@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef SIG_FILTER_H
+#define SIG_FILTER_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Defines */
+#define SIG_FILTER_MEDIAN_MAX 7
+
+/*
+ * 整数信号调理: 中值滤波(剔除尖峰) + 指数滑动平均。
+ * 输入输出单位相同(如 0.01 °C)，EMA 内部状态为 Q8。
+ */
+struct sig_filter {
+    int32_t window[SIG_FILTER_MEDIAN_MAX];  // 最近的原始值，循环存放
+    uint8_t median_n;       // 中值窗口长度，1 表示不做中值滤波
+    uint8_t fill;
+    uint8_t pos;
+    bool primed;            // EMA 是否已用第一个值初始化
+    uint16_t alpha;         // EMA 系数，Q16；65535 表示不平滑
+    int32_t ema;            // Q8
+};
+
+/* Public function declarations */
+/* median_n 取奇数(1..SIG_FILTER_MEDIAN_MAX)，tau_samples 为 EMA 时间常数(采样数)，0 表示关闭 */
+void sig_filter_init(struct sig_filter *f, uint8_t median_n, uint16_t tau_samples);
+
+/* 以一个已滤波的值预置中值窗口和 EMA，如深睡眠前最后的输出 */
+void sig_filter_prime(struct sig_filter *f, int32_t x);
+
+/* 输入一个原始值，返回滤波后的值 */
+int32_t sig_filter_update(struct sig_filter *f, int32_t x);
+
+#endif // SIG_FILTER_H
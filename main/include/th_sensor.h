@@ -0,0 +1,166 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef TH_SENSOR_H
+#define TH_SENSOR_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ESP APIs */
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "i2c_bus.h"
+
+/* Defines */
+#define TH_SENSOR_MAX 2         // 同一总线上最多同时使用的传感器，如 0x44/0x45 两个 SHT4x
+
+/* 各驱动的最长转换时间(ms)，固定驱动时直接作为常量使用 */
+#define SHT4X_CONV_MS 9         // 高重复性 8.3 ms
+#define SHT3X_CONV_MS 16        // 高重复性 15 ms
+#define AHT20_CONV_MS 80
+#define BME280_CONV_MS 10       // 温度、湿度各 1 倍过采样，不测气压
+
+#define TH_SENSOR_HAS_SHT4X (CONFIG_TH_SENSOR_AUTO || CONFIG_TH_SENSOR_SHT4X)
+#define TH_SENSOR_HAS_SHT3X (CONFIG_TH_SENSOR_AUTO || CONFIG_TH_SENSOR_SHT3X)
+#define TH_SENSOR_HAS_AHT20 (CONFIG_TH_SENSOR_AUTO || CONFIG_TH_SENSOR_AHT20)
+#define TH_SENSOR_HAS_BME280 (CONFIG_TH_SENSOR_AUTO || CONFIG_TH_SENSOR_BME280)
+
+/* 构建时固定了驱动则直接调用，省去函数指针 */
+#if CONFIG_TH_SENSOR_SHT4X
+#define TH_SENSOR_FIXED(fn) sht4x_##fn
+#define TH_SENSOR_FIXED_CONV_MS SHT4X_CONV_MS
+#elif CONFIG_TH_SENSOR_SHT3X
+#define TH_SENSOR_FIXED(fn) sht3x_##fn
+#define TH_SENSOR_FIXED_CONV_MS SHT3X_CONV_MS
+#elif CONFIG_TH_SENSOR_AHT20
+#define TH_SENSOR_FIXED(fn) aht20_##fn
+#define TH_SENSOR_FIXED_CONV_MS AHT20_CONV_MS
+#elif CONFIG_TH_SENSOR_BME280
+#define TH_SENSOR_FIXED(fn) bme280_##fn
+#define TH_SENSOR_FIXED_CONV_MS BME280_CONV_MS
+#endif
+
+/* 温度 0.01 °C，湿度 0.01 %RH */
+struct th_reading {
+    int16_t temp;
+    uint16_t humi;
+};
+
+/* 多个传感器融合后的结果，value 为有效读数的平均值 */
+struct th_fused {
+    struct th_reading value;
+    struct th_reading each[TH_SENSOR_MAX];
+    uint8_t count;          // 检测到的传感器数量
+    uint8_t valid_mask;     // 本次读数成功的传感器
+    bool disagree;          // 两个读数之差超过阈值
+};
+
+struct th_sensor;
+
+/*
+ * 传感器驱动: init 负责确认器件身份并完成配置，trigger 发起一次测量后立即返回，
+ * 至少 conv_ms 之后再 collect，两者之间不占用总线。
+ */
+struct th_sensor_driver {
+    const char *name;
+    uint8_t addrs[2];       // 候选地址，0 表示未使用
+    uint32_t scl_hz;
+    uint16_t conv_ms;
+    uint16_t active_ua;     // 测量期间的典型电流
+    uint16_t sleep_na;      // 空闲电流
+    esp_err_t (*init)(struct th_sensor *s);
+    esp_err_t (*trigger)(struct th_sensor *s);
+    esp_err_t (*collect)(struct th_sensor *s, struct th_reading *out);
+};
+
+struct bme280_calib {
+    uint16_t t1;
+    int16_t t2, t3;
+    uint8_t h1, h3;
+    int16_t h2, h4, h5;
+    int8_t h6;
+};
+
+struct th_sensor {
+    const struct th_sensor_driver *drv;
+    i2c_master_dev_handle_t dev;
+    uint8_t addr;
+    union {
+        struct bme280_calib bme280;
+    } priv;
+};
+
+/* Public function declarations */
+/* 按驱动表探测总线，最多识别 max 个传感器，返回识别出的数量 */
+size_t th_sensor_detect(struct th_sensor *s, size_t max);
+
+/*
+ * 先依次触发全部传感器，只等待最长的一个转换时间，再依次读取并融合，
+ * 第二个传感器不增加采样耗时。全部失败时返回最后一个错误码。
+ * out 总会被完整填写: 读取失败的传感器不置 valid_mask 位，each[i] 为 0。
+ */
+esp_err_t th_sensor_sample(struct th_sensor *s, size_t n, struct th_fused *out);
+
+/* Sensirion 与 AHT20 共用的 CRC-8 (多项式 0x31，初值 0xFF) */
+uint8_t th_sensor_crc8(const uint8_t *data, size_t len);
+
+/* 把毫秒换算成至少这么长的延时节拍数 */
+uint32_t th_sensor_delay_ticks(uint16_t ms);
+
+#if TH_SENSOR_HAS_SHT4X
+extern const struct th_sensor_driver th_sensor_sht4x;
+esp_err_t sht4x_init(struct th_sensor *s);
+esp_err_t sht4x_trigger(struct th_sensor *s);
+esp_err_t sht4x_collect(struct th_sensor *s, struct th_reading *out);
+#endif
+#if TH_SENSOR_HAS_SHT3X
+extern const struct th_sensor_driver th_sensor_sht3x;
+esp_err_t sht3x_init(struct th_sensor *s);
+esp_err_t sht3x_trigger(struct th_sensor *s);
+esp_err_t sht3x_collect(struct th_sensor *s, struct th_reading *out);
+#endif
+#if TH_SENSOR_HAS_AHT20
+extern const struct th_sensor_driver th_sensor_aht20;
+esp_err_t aht20_init(struct th_sensor *s);
+esp_err_t aht20_trigger(struct th_sensor *s);
+esp_err_t aht20_collect(struct th_sensor *s, struct th_reading *out);
+#endif
+#if TH_SENSOR_HAS_BME280
+extern const struct th_sensor_driver th_sensor_bme280;
+esp_err_t bme280_init(struct th_sensor *s);
+esp_err_t bme280_trigger(struct th_sensor *s);
+esp_err_t bme280_collect(struct th_sensor *s, struct th_reading *out);
+#endif
+
+static inline esp_err_t th_sensor_trigger(struct th_sensor *s) {
+#ifdef TH_SENSOR_FIXED
+    return TH_SENSOR_FIXED(trigger)(s);
+#else
+    return s->drv->trigger(s);
+#endif
+}
+
+static inline esp_err_t th_sensor_collect(struct th_sensor *s, struct th_reading *out) {
+#ifdef TH_SENSOR_FIXED
+    return TH_SENSOR_FIXED(collect)(s, out);
+#else
+    return s->drv->collect(s, out);
+#endif
+}
+
+static inline uint16_t th_sensor_conv_ms(const struct th_sensor *s) {
+#ifdef TH_SENSOR_FIXED
+    return TH_SENSOR_FIXED_CONV_MS;
+#else
+    return s->drv->conv_ms;
+#endif
+}
+
+#endif // TH_SENSOR_H
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+/* Includes */
+/* STD APIs */
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Defines */
+#define TIMEBASE_MIN_DRIFT_INTERVAL_S 600   // 两次同步间隔短于此不更新漂移估计
+#define TIMEBASE_MAX_DRIFT_PPB 500000       // 漂移估计限幅 ±500 ppm
+#define TIMEBASE_YEAR_MAX 2105             // uint32 秒数在 2106-02-07 溢出
+#define TIMEBASE_SLEW_DIV 16                // 倒退的偏差以 1/16 的速率减慢时钟来消化
+
+struct timebase_civil {
+    uint16_t year;
+    uint8_t month;      // 1..12
+    uint8_t day;        // 1..31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;    // 1 = 星期一 .. 7 = 星期日
+};
+
+struct timebase_status {
+    bool synced;            // 是否收到过网关校时
+    uint32_t sync_count;
+    int32_t last_offset_ms; // 最近一次校时的偏差(参考 - 本地，毫秒)
+    int32_t drift_ppb;      // 本地时钟相对参考的漂移估计，正值表示偏慢
+};
+
+/* Public function declarations */
+/* 以 floor 为起点开始计时，时间戳不会小于 floor */
+void timebase_init(uint32_t floor);
+
+/* 经漂移补偿的当前时间(秒)，单调不减 */
+uint32_t timebase_now(void);
+
+/* 毫秒精度的当前时间，用于对齐时隙，不做单调保护 */
+uint64_t timebase_now_ms(void);
+
+/* 用可信时间(如 RTC)前移时钟，不允许倒退 */
+void timebase_set(uint32_t now);
+
+/*
+ * 网关校时: 用两次校时间的累计偏差更新漂移估计，
+ * 按线性插值修正这期间缓存的记录时间戳，然后把时钟对齐到 ref + frac256/256 秒。
+ * 本地时钟偏快时不倒退，而是以 1/TIMEBASE_SLEW_DIV 的速率放慢直到追平，
+ * 时间戳始终单调不减。返回本次偏差(秒，四舍五入)。
+ */
+int32_t timebase_sync(uint32_t ref, uint8_t frac256);
+
+void timebase_get_status(struct timebase_status *status);
+
+/* 日期时间各字段是否合法(含闰年的月份天数)，年份须在 1970..TIMEBASE_YEAR_MAX */
+bool timebase_civil_valid(const struct timebase_civil *civil);
+
+/* UTC Unix 时间与公历互转，适用于 1970..TIMEBASE_YEAR_MAX */
+void timebase_to_civil(uint32_t t, struct timebase_civil *civil);
+uint32_t timebase_from_civil(const struct timebase_civil *civil);
+
+#endif // TIMEBASE_H
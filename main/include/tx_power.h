@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef TX_POWER_H
+#define TX_POWER_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+
+/* ESP APIs */
+#include "sdkconfig.h"
+
+/* Defines */
+#define TX_POWER_RX_SENSITIVITY_DBM (-94)   // 1M PHY 典型接收灵敏度
+#define TX_POWER_HYSTERESIS_DB 6            // 降功率前需额外超出的余量
+
+/* 诊断信息 */
+struct tx_power_diag {
+    int8_t conn_dbm;        // 当前连接发射功率
+    int8_t adv_dbm;         // 广播发射功率
+    int8_t last_rssi;       // 最近一次读取的对端 RSSI
+    uint16_t adjustments;   // 累计调整次数
+};
+
+/* Public function declarations */
+/* 设置广播发射功率(CONFIG_TX_POWER_ADV_DBM) */
+void tx_power_adv_init(void);
+
+/* 连接建立/断开时调用 */
+void tx_power_conn_start(uint16_t conn_handle);
+void tx_power_conn_stop(uint16_t conn_handle);
+
+/* 周期调用: 读取 RSSI 并按链路余量调整发射功率 */
+void tx_power_update(void);
+
+/* 通知/指示发送失败时调用，立即提高发射功率 */
+void tx_power_on_tx_error(uint16_t conn_handle);
+
+void tx_power_get_diag(struct tx_power_diag *diag);
+
+#endif // TX_POWER_H
@@ -8,6 +8,20 @@
 #include "gap.h"
 #include "gatt_svc.h"
 #include "EnGet.h"
+#include "i2c_bus.h"
+#include "l2cap_coc.h"
+#include "tx_power.h"
+#include "history.h"
+#include "flash_log.h"
+#include "rollup.h"
+#include "comfort.h"
+#include "display.h"
+#include "rtc.h"
+#include "timebase.h"
+#include "fleet_slot.h"
+#include "led.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 
 /* Library function declarations */
 void ble_store_config_init(void);
@@ -17,6 +31,11 @@ static void on_stack_reset(int reason);
 static void on_stack_sync(void);
 static void nimble_host_config_init(void);
 static void nimble_host_task(void *param);
+static void update_status_led(void);
+#if CONFIG_RTC_DEEP_SLEEP
+static uint32_t next_sample_instant(uint32_t now);
+static void sleep_until_next_sample(void);
+#endif
 
 /* Private functions */
 /*
@@ -56,7 +75,48 @@ static void nimble_host_task(void *param) {
     vTaskDelete(NULL);
 }
 
+#if CONFIG_RTC_DEEP_SLEEP
+/* 采样时刻对齐到 CONFIG_RTC_SAMPLE_PERIOD_S 的整数倍 */
+static uint32_t next_sample_instant(uint32_t now) {
+    return (now / CONFIG_RTC_SAMPLE_PERIOD_S + 1) * CONFIG_RTC_SAMPLE_PERIOD_S;
+}
+
+static void sleep_until_next_sample(void) {
+    /* Without a valid RTC time there is no wake-up alarm, stay awake */
+    if (!rtc_time_valid()) {
+        return;
+    }
+
+    /* 深睡眠会清空 RAM，先写出暂存的记录并等待屏幕刷完 */
+    flash_log_flush();
+#if CONFIG_EPD_DISPLAY
+    display_wait_idle();
+#endif
+    rtc_deep_sleep_until(next_sample_instant(history_now()));
+}
+#endif
+
+/* Most severe condition wins; the LED hardware plays the pattern on its own */
+static void update_status_led(void) {
+    struct th_fused th;
+
+    GetTHSensors(&th);
+    if (th.valid_mask == 0) {
+        led_set_pattern(LED_PATTERN_SENSOR_ERROR);
+    } else if (GetBatteryPercentage() < CONFIG_LED_LOW_BATTERY_PERCENT) {
+        led_set_pattern(LED_PATTERN_LOW_BATTERY);
+    } else if (gap_conn_count() > 0) {
+        led_set_pattern(LED_PATTERN_CONNECTED);
+    } else {
+        led_set_pattern(LED_PATTERN_ADVERTISING);
+    }
+}
+
 static void heart_rate_task(void *param) {
+#if CONFIG_RTC_DEEP_SLEEP
+    int64_t sleep_after_us = CONFIG_RTC_AWAKE_WINDOW_S * 1000000LL;
+#endif
+
     /* Task entry log */
     ESP_LOGI(TAG, "heart rate task has been started!");
 
@@ -67,7 +127,34 @@ static void heart_rate_task(void *param) {
 
         UpDateTH();
         UpDataBattry();
+        history_record();
+        gap_update_readings();
+#if CONFIG_FLEET_SLOTS
+        gap_adv_burst();
+#endif
         send_indication();
+        tx_power_update();
+        update_status_led();
+#if CONFIG_EPD_DISPLAY
+        display_update();
+#endif
+
+#if CONFIG_RTC_DEEP_SLEEP
+        /* No central connected and the advertising window has passed */
+        if (gap_conn_count() == 0 && esp_timer_get_time() >= sleep_after_us) {
+            sleep_until_next_sample();
+            /* Only returns when deep sleep is unavailable, retry after another window */
+            sleep_after_us = esp_timer_get_time() + CONFIG_RTC_AWAKE_WINDOW_S * 1000000LL;
+        }
+#endif
+
+#if CONFIG_FLEET_SLOTS
+        /* Without a connection, sample only at this device's slot of the grid */
+        if (gap_conn_count() == 0 && fleet_slot_active()) {
+            vTaskDelay(pdMS_TO_TICKS(fleet_slot_wait_ms()));
+            continue;
+        }
+#endif
 
         /* Sleep */
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -82,9 +169,28 @@ void app_main(void) {
     int rc;
     esp_err_t ret;
 
+    led_init();
     InitADC();
-    ESP_ERROR_CHECK(i2c_master_init());
+    /* Shared I2C bus, the sensor and RTC drivers add their devices to it */
+    ESP_ERROR_CHECK(i2c_bus_init());
     ESP_LOGI(TAG, "I2C initialized successfully");
+    /* Probe for the temperature/humidity sensor, readings stay at zero without one */
+    InitTH();
+
+#if CONFIG_RTC_PCF8563
+    /* External RTC provides wall-clock time and the deep sleep wake-up */
+    uint32_t rtc_now = 0;
+    bool rtc_ok = rtc_init() == ESP_OK && rtc_get_time(&rtc_now) == ESP_OK;
+#if CONFIG_RTC_DEEP_SLEEP
+    /* A minute alarm fires at second 0, sleep on for the rest of the period */
+    if (rtc_ok && esp_reset_reason() == ESP_RST_DEEPSLEEP) {
+        uint32_t phase = rtc_now % CONFIG_RTC_SAMPLE_PERIOD_S;
+        if (phase > 1 && phase < CONFIG_RTC_SAMPLE_PERIOD_S - 1) {
+            rtc_deep_sleep_until(next_sample_instant(rtc_now));
+        }
+    }
+#endif
+#endif
 
     /*
      * NVS flash initialization
@@ -101,6 +207,40 @@ void app_main(void) {
         return;
     }
 
+    /* Persistent history log, readings are still served from RAM without it */
+    ret = flash_log_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "history flash log unavailable, error code: %d", ret);
+    }
+    history_init();
+#if CONFIG_RTC_PCF8563
+    if (rtc_ok) {
+        timebase_set(rtc_now);
+    }
+#endif
+    rollup_init();
+#if CONFIG_RTC_DEEP_SLEEP
+    /* Deep sleep cleared the filters, continue from the last logged reading */
+    struct history_sample last;
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP && flash_log_last(&last) == 0) {
+        PrimeTH(last.temp, last.humi);
+    }
+#endif
+#if CONFIG_FLEET_SLOTS
+    fleet_slot_init();
+#endif
+#if CONFIG_COMFORT_BENCHMARK
+    comfort_benchmark();
+#endif
+
+#if CONFIG_EPD_DISPLAY
+    /* E-paper panel, the device keeps running headless without it */
+    ret = display_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "e-paper display unavailable, error code: %d", ret);
+    }
+#endif
+
     /* NimBLE stack initialization */
     ret = nimble_port_init();
     if (ret != ESP_OK) {
@@ -123,6 +263,21 @@ void app_main(void) {
         return;
     }
 
+    /* L2CAP connection-oriented channel initialization */
+    rc = l2cap_coc_init();
+    if (rc != 0) {
+        ESP_LOGE(TAG, "failed to initialize L2CAP CoC server, error code: %d",
+                 rc);
+        return;
+    }
+
+    /* History streaming over L2CAP */
+    rc = history_stream_init();
+    if (rc != 0) {
+        ESP_LOGE(TAG, "failed to register history stream, error code: %d", rc);
+        return;
+    }
+
     /* NimBLE host configuration initialization */
     nimble_host_config_init();
 
@@ -6,76 +6,76 @@
 /* Includes */
 #include "common.h"
 #include "EnGet.h"
+#include "sig_filter.h"
 #include <stdio.h>
-#include "driver/i2c.h"
+#include "th_sensor.h"
 #include "esp_log.h"
 #include "esp_adc/adc_oneshot.h"
 
-#define I2C_MASTER_SCL_IO           5         // SCL引脚
-#define I2C_MASTER_SDA_IO           4         // SDA引脚
-#define I2C_MASTER_NUM              I2C_NUM_0  // I2C端口号
-#define I2C_MASTER_FREQ_HZ          100000     // I2C时钟频率
-#define I2C_MASTER_TX_BUF_DISABLE   0          // 禁用TX缓冲区
-#define I2C_MASTER_RX_BUF_DISABLE   0          // 禁用RX缓冲区
-#define SHT40_SENSOR_ADDR           0x44       // SHT40默认I2C地址
-#define SHT40_MEASURE_CMD           0xFD       // 测量命令
 float temperature,humidity,batteryVoltage,batteryPercentage;
 float ftem,fhum;
 adc_oneshot_unit_handle_t adc1_handle;
 static int adc_raw_value;
-
-esp_err_t i2c_master_init(void) {
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
-    };
-    ESP_ERROR_CHECK(i2c_param_config(I2C_MASTER_NUM, &conf));
-    return i2c_driver_install(I2C_MASTER_NUM, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0);
+static struct sig_filter temp_filter, humi_filter;
+static bool th_filter_ready = false;
+static struct th_sensor th_sensors[TH_SENSOR_MAX];
+static size_t th_sensor_count;
+static struct th_fused th_last;
+
+esp_err_t InitTH(void) {
+    th_sensor_count = th_sensor_detect(th_sensors, TH_SENSOR_MAX);
+    th_last.count = th_sensor_count;
+    return th_sensor_count > 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t sht40_read_measurement(float *temperature, float *humidity) {
-    uint8_t data[6];
-    uint8_t cmd = SHT40_MEASURE_CMD;
-
-    // 发送测量命令
-    int rc1 = i2c_master_write_to_device(I2C_MASTER_NUM, SHT40_SENSOR_ADDR, &cmd, 1, pdMS_TO_TICKS(100));
-    if (rc1 != ESP_OK){
-        ESP_LOGE(TAG, "试图测量I2C时出错: %d ", rc1);
-        return rc1;
-    }
-
-    // 延时等待测量完成
-    vTaskDelay(pdMS_TO_TICKS(10));
-
-    // 读取传感器数据
-    int rc2 = i2c_master_read_from_device(I2C_MASTER_NUM, SHT40_SENSOR_ADDR, data, 6, pdMS_TO_TICKS(100));
-    if (rc2 != ESP_OK){
-        ESP_LOGE(TAG, "试图读取I2C时出错: %d ", rc2);
-        return rc2;
+static void init_filters(void) {
+    if (!th_filter_ready) {
+        sig_filter_init(&temp_filter, CONFIG_SIGNAL_FILTER_MEDIAN_N,
+                        CONFIG_SIGNAL_FILTER_EMA_TAU);
+        sig_filter_init(&humi_filter, CONFIG_SIGNAL_FILTER_MEDIAN_N,
+                        CONFIG_SIGNAL_FILTER_EMA_TAU);
+        th_filter_ready = true;
     }
+}
 
-    // 数据解码
-    uint16_t raw_temp = (data[0] << 8) | data[1];
-    uint16_t raw_humi = (data[3] << 8) | data[4];
-
-    // 转换为实际值
-    *temperature = -45 + 175 * ((float)raw_temp / 65535.0f);
-    *humidity = 100 * ((float)raw_humi / 65535.0f);
-
-    return ESP_OK;
+void PrimeTH(int16_t temp, uint16_t humi){
+    // 深睡眠清空了滤波状态，以睡前最后的输出接续，避免每次唤醒都从头收敛
+    init_filters();
+    sig_filter_prime(&temp_filter, temp);
+    sig_filter_prime(&humi_filter, humi);
+    temperature = temp / 100.0f;
+    humidity = humi / 100.0f;
 }
 
 void UpDateTH(void){
-    if (sht40_read_measurement(&ftem, &fhum) == ESP_OK) {
-        ESP_LOGI(TAG, "温度: %f °C, 湿度: %f %%", ftem, fhum);
-        temperature = ftem;
-        humidity = fhum;
+    init_filters();
+
+    struct th_fused fused = {0};
+    bool was_disagree = th_last.disagree;
+    esp_err_t rc = th_sensor_sample(th_sensors, th_sensor_count, &fused);
+    if (rc == ESP_OK) {
+        th_last = fused;
+        if (fused.disagree && !was_disagree) {
+            ESP_LOGW(TAG, "两个传感器读数不一致: %d/%u 与 %d/%u", fused.each[0].temp,
+                     fused.each[0].humi, fused.each[1].temp, fused.each[1].humi);
+        }
+
+        // 以 0.01 为单位做整数滤波，之后的发布/记录都使用滤波后的值
+        ftem = fused.value.temp / 100.0f;
+        fhum = fused.value.humi / 100.0f;
+        int32_t t = sig_filter_update(&temp_filter, fused.value.temp);
+        int32_t h = sig_filter_update(&humi_filter, fused.value.humi);
+        ESP_LOGI(TAG, "温度: %f °C, 湿度: %f %% (滤波后 %ld / %ld)", ftem, fhum,
+                 (long)t, (long)h);
+        temperature = t / 100.0f;
+        humidity = h / 100.0f;
     } else {
-        ESP_LOGE(TAG, "Failed to read from SHT40");
+        // 全部失败: 保留上次的融合值继续发布，各传感器读数与有效位按本次结果更新，
+        // 供状态灯与特征值反映故障
+        memcpy(th_last.each, fused.each, sizeof(th_last.each));
+        th_last.valid_mask = fused.valid_mask;
+        th_last.disagree = false;
+        ESP_LOGE(TAG, "读取温湿度传感器失败: %d", rc);
     }
 }
 
@@ -101,6 +101,10 @@ void UpDataBattry(void){
     ESP_LOGI("Battery", "电压: %f 电量: %f",batteryVoltage,batteryPercentage);
 }
 
+void GetTHSensors(struct th_fused *out){
+    *out = th_last;
+}
+
 float GetTemp(void){
     return temperature;
 }
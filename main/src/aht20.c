@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include "common.h"
+
+#if TH_SENSOR_HAS_AHT20
+
+/* Defines */
+#define AHT20_CMD_STATUS 0x71
+#define AHT20_STATUS_BUSY 0x80
+#define AHT20_STATUS_CAL 0x08
+
+/* Public functions */
+esp_err_t aht20_init(struct th_sensor *s) {
+    static const uint8_t calibrate[3] = {0xBE, 0x08, 0x00};
+    uint8_t cmd = AHT20_CMD_STATUS;
+    uint8_t status;
+    esp_err_t rc;
+
+    rc = i2c_bus_write_read(s->dev, &cmd, 1, &status, 1);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* 上电后校准位未置位时需要先初始化 */
+    if (!(status & AHT20_STATUS_CAL)) {
+        rc = i2c_bus_write(s->dev, calibrate, sizeof(calibrate));
+        vTaskDelay(th_sensor_delay_ticks(10));
+    }
+    return rc;
+}
+
+esp_err_t aht20_trigger(struct th_sensor *s) {
+    static const uint8_t measure[3] = {0xAC, 0x33, 0x00};
+
+    return i2c_bus_write(s->dev, measure, sizeof(measure));
+}
+
+esp_err_t aht20_collect(struct th_sensor *s, struct th_reading *out) {
+    uint8_t data[7];
+    esp_err_t rc;
+
+    rc = i2c_bus_read(s->dev, data, sizeof(data));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (data[0] & AHT20_STATUS_BUSY) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (th_sensor_crc8(data, 6) != data[6]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    /* 湿度与温度各 20 位: RH = S / 2^20 * 100，T = S / 2^20 * 200 - 50 */
+    uint32_t raw_h = ((uint32_t)data[1] << 12) | (data[2] << 4) | (data[3] >> 4);
+    uint32_t raw_t = ((uint32_t)(data[3] & 0x0F) << 16) | (data[4] << 8) | data[5];
+    out->humi = (uint16_t)(((uint64_t)raw_h * 10000) >> 20);
+    out->temp = (int16_t)((int32_t)(((uint64_t)raw_t * 20000) >> 20) - 5000);
+    return ESP_OK;
+}
+
+const struct th_sensor_driver th_sensor_aht20 = {
+    .name = "AHT20",
+    .addrs = {0x38},
+    .scl_hz = 400000,
+    .conv_ms = AHT20_CONV_MS,
+    .active_ua = 980,
+    .sleep_na = 250,
+    .init = aht20_init,
+    .trigger = aht20_trigger,
+    .collect = aht20_collect,
+};
+
+#endif // TH_SENSOR_HAS_AHT20
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include "common.h"
+
+#if TH_SENSOR_HAS_BME280
+
+/* Defines */
+#define REG_CALIB_T 0x88
+#define REG_CHIP_ID 0xD0
+#define REG_CALIB_H 0xE1
+#define REG_CTRL_HUM 0xF2
+#define REG_CTRL_MEAS 0xF4
+#define REG_TEMP_MSB 0xFA
+
+#define BME280_CHIP_ID 0x60     // BMP280 为 0x58，没有湿度
+#define CTRL_HUM_OSRS_1 0x01
+#define CTRL_MEAS_FORCED 0x21   // 温度 1 倍过采样，跳过气压，强制模式
+
+/* Private function declarations */
+static esp_err_t reg_read(struct th_sensor *s, uint8_t reg, uint8_t *buf, size_t len);
+
+/* Private functions */
+static esp_err_t reg_read(struct th_sensor *s, uint8_t reg, uint8_t *buf, size_t len) {
+    return i2c_bus_write_read(s->dev, &reg, 1, buf, len);
+}
+
+/* Public functions */
+esp_err_t bme280_init(struct th_sensor *s) {
+    struct bme280_calib *c = &s->priv.bme280;
+    uint8_t id;
+    uint8_t t[26];
+    uint8_t h[7];
+    esp_err_t rc;
+
+    rc = reg_read(s, REG_CHIP_ID, &id, 1);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (id != BME280_CHIP_ID) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    rc = reg_read(s, REG_CALIB_T, t, sizeof(t));
+    if (rc == ESP_OK) {
+        rc = reg_read(s, REG_CALIB_H, h, sizeof(h));
+    }
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    c->t1 = t[0] | (t[1] << 8);
+    c->t2 = (int16_t)(t[2] | (t[3] << 8));
+    c->t3 = (int16_t)(t[4] | (t[5] << 8));
+    c->h1 = t[25];
+    c->h2 = (int16_t)(h[0] | (h[1] << 8));
+    c->h3 = h[2];
+    c->h4 = (int16_t)((int8_t)h[3] * 16 + (h[4] & 0x0F));  // 有符号 12 位
+    c->h5 = (int16_t)((int8_t)h[5] * 16 + (h[4] >> 4));
+    c->h6 = (int8_t)h[6];
+    return ESP_OK;
+}
+
+esp_err_t bme280_trigger(struct th_sensor *s) {
+    /* ctrl_hum 要在写 ctrl_meas 之后才生效，两次写入放在同一请求中 */
+    uint8_t hum[2] = {REG_CTRL_HUM, CTRL_HUM_OSRS_1};
+    uint8_t meas[2] = {REG_CTRL_MEAS, CTRL_MEAS_FORCED};
+    const struct i2c_bus_op ops[] = {
+        {.tx = hum, .tx_len = sizeof(hum)},
+        {.tx = meas, .tx_len = sizeof(meas)},
+    };
+
+    return i2c_bus_transfer(s->dev, ops, sizeof(ops) / sizeof(ops[0]));
+}
+
+/* 数据手册中的 32 位整数补偿公式 */
+esp_err_t bme280_collect(struct th_sensor *s, struct th_reading *out) {
+    const struct bme280_calib *c = &s->priv.bme280;
+    uint8_t d[5];
+    esp_err_t rc;
+
+    rc = reg_read(s, REG_TEMP_MSB, d, sizeof(d));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    int32_t adc_t = ((int32_t)d[0] << 12) | (d[1] << 4) | (d[2] >> 4);
+    int32_t adc_h = (d[3] << 8) | d[4];
+    int32_t var1 = ((((adc_t >> 3) - ((int32_t)c->t1 << 1))) * c->t2) >> 11;
+    int32_t var2 = (((((adc_t >> 4) - c->t1) * ((adc_t >> 4) - c->t1)) >> 12) * c->t3) >> 14;
+    int32_t t_fine = var1 + var2;
+    int32_t v = t_fine - 76800;
+
+    v = (((((adc_h << 14) - ((int32_t)c->h4 << 20) - (c->h5 * v)) + 16384) >> 15) *
+         (((((((v * c->h6) >> 10) * (((v * c->h3) >> 11) + 32768)) >> 10) + 2097152) *
+               c->h2 + 8192) >> 14));
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * c->h1) >> 4);
+    v = v < 0 ? 0 : v > 419430400 ? 419430400 : v;
+
+    out->temp = (int16_t)((t_fine * 5 + 128) >> 8);
+    out->humi = (uint16_t)(((uint32_t)v >> 12) * 100 >> 10);   // Q22.10 %RH
+    return ESP_OK;
+}
+
+const struct th_sensor_driver th_sensor_bme280 = {
+    .name = "BME280",
+    .addrs = {0x76, 0x77},
+    .scl_hz = 400000,
+    .conv_ms = BME280_CONV_MS,
+    .active_ua = 340,
+    .sleep_na = 100,
+    .init = bme280_init,
+    .trigger = bme280_trigger,
+    .collect = bme280_collect,
+};
+
+#endif // TH_SENSOR_HAS_BME280
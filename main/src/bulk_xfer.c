@@ -0,0 +1,216 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "bulk_xfer.h"
+#include "common.h"
+#include "esp_timer.h"
+
+/* 私有函数声明 */
+static int mtu_exchange_cb(uint16_t conn_handle, const struct ble_gatt_error *error,
+                           uint16_t mtu, void *arg);
+static void benchmark_task(void *param);
+
+/* 私有变量 */
+static uint16_t bulk_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static int64_t bulk_start_us;
+static uint32_t bulk_bytes;
+static uint8_t bulk_prev_phy_mask = BLE_GAP_LE_PHY_1M_MASK;
+
+static struct {
+    uint16_t conn_handle;
+    uint16_t attr_handle;
+    uint32_t total_bytes;
+} bench_args;
+static volatile bool bench_running = false;
+static uint32_t bench_last_rate;
+
+/* 私有函数 */
+static int mtu_exchange_cb(uint16_t conn_handle, const struct ble_gatt_error *error,
+                           uint16_t mtu, void *arg) {
+    ESP_LOGI(TAG, "批量传输 MTU 交换完成；conn_handle=%d 状态=%d mtu=%d",
+             conn_handle, error->status, mtu);
+    return 0;
+}
+
+static void benchmark_task(void *param) {
+    uint16_t conn_handle = bench_args.conn_handle;
+    uint16_t attr_handle = bench_args.attr_handle;
+    uint32_t remaining = bench_args.total_bytes;
+    uint8_t chunk[BULK_XFER_LL_OCTETS_MAX];
+    uint32_t rate;
+    int rc;
+
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = (uint8_t)i;
+    }
+
+    rc = bulk_xfer_begin(conn_handle);
+    if (rc != 0) {
+        goto done;
+    }
+
+    /* 等待 PHY/DLE 协商生效 */
+    vTaskDelay(pdMS_TO_TICKS(300));
+
+    bulk_start_us = esp_timer_get_time();
+    while (remaining > 0 && bulk_conn_handle == conn_handle) {
+        uint16_t len = bulk_xfer_att_payload(conn_handle);
+        if (len > sizeof(chunk)) {
+            len = sizeof(chunk);
+        }
+        if (len > remaining) {
+            len = remaining;
+        }
+
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(chunk, len);
+        if (om == NULL) {
+            /* mbuf 用尽，等待控制器发送完成后再试 */
+            vTaskDelay(1);
+            continue;
+        }
+
+        rc = ble_gatts_notify_custom(conn_handle, attr_handle, om);
+        if (rc == BLE_HS_ENOMEM) {
+            vTaskDelay(1);
+            continue;
+        } else if (rc != 0) {
+            ESP_LOGE(TAG, "批量通知发送失败，错误码=%d", rc);
+            break;
+        }
+
+        bulk_xfer_account(len);
+        remaining -= len;
+    }
+
+    rate = bulk_xfer_end(conn_handle);
+    bench_last_rate = rate;
+    ESP_LOGI(TAG, "GATT 通知吞吐量测试：%lu 字节，%lu 字节/秒",
+             (unsigned long)(bench_args.total_bytes - remaining),
+             (unsigned long)rate);
+
+done:
+    bench_running = false;
+    vTaskDelete(NULL);
+}
+
+/* 公有函数 */
+int bulk_xfer_begin(uint16_t conn_handle) {
+    int rc;
+
+    bulk_conn_handle = conn_handle;
+    bulk_bytes = 0;
+    bulk_start_us = esp_timer_get_time();
+
+#if CONFIG_BT_NIMBLE_50_FEATURE_SUPPORT
+    uint8_t tx_phy = BLE_GAP_LE_PHY_1M;
+    uint8_t rx_phy = BLE_GAP_LE_PHY_1M;
+
+    /* 记录当前 PHY，传输结束后恢复 */
+    ble_gap_read_le_phy(conn_handle, &tx_phy, &rx_phy);
+    bulk_prev_phy_mask = 1 << (tx_phy - 1);
+
+    /* Coded PHY 连接说明链路余量不足，保持原 PHY；否则请求切换到 2M PHY */
+    if (tx_phy != BLE_GAP_LE_PHY_CODED) {
+        rc = ble_gap_set_prefered_le_phy(conn_handle, BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_2M_MASK,
+                                         BLE_GAP_LE_PHY_CODED_ANY);
+        if (rc != 0) {
+            ESP_LOGW(TAG, "切换 2M PHY 失败，错误码: %d", rc);
+        }
+    }
+#endif
+
+    /* 启用 251 字节链路层载荷 */
+    rc = ble_gap_set_data_len(conn_handle, BULK_XFER_LL_OCTETS_MAX,
+                              BULK_XFER_LL_TIME_MAX);
+    if (rc != 0) {
+        ESP_LOGW(TAG, "设置数据长度扩展失败，错误码: %d", rc);
+    }
+
+    /* 使用 CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU，若对端已交换过则忽略 */
+    rc = ble_gattc_exchange_mtu(conn_handle, mtu_exchange_cb, NULL);
+    if (rc != 0 && rc != BLE_HS_EALREADY) {
+        ESP_LOGW(TAG, "发起 MTU 交换失败，错误码: %d", rc);
+    }
+
+    ESP_LOGI(TAG, "进入批量传输模式；conn_handle=%d", conn_handle);
+    return 0;
+}
+
+uint32_t bulk_xfer_end(uint16_t conn_handle) {
+    int64_t elapsed_us = esp_timer_get_time() - bulk_start_us;
+    uint32_t rate = 0;
+
+    if (elapsed_us > 0) {
+        rate = (uint32_t)((int64_t)bulk_bytes * 1000000 / elapsed_us);
+    }
+
+    if (bulk_conn_handle == conn_handle) {
+#if CONFIG_BT_NIMBLE_50_FEATURE_SUPPORT
+        ble_gap_set_prefered_le_phy(conn_handle, bulk_prev_phy_mask,
+                                    bulk_prev_phy_mask,
+                                    BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+        ble_gap_set_data_len(conn_handle, BULK_XFER_LL_OCTETS_DEFAULT,
+                             BULK_XFER_LL_TIME_DEFAULT);
+        ESP_LOGI(TAG, "退出批量传输模式；conn_handle=%d", conn_handle);
+    }
+
+    bulk_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    return rate;
+}
+
+void bulk_xfer_account(size_t bytes) { bulk_bytes += bytes; }
+
+uint32_t bulk_xfer_gatt_rate(void) { return bench_last_rate; }
+
+uint16_t bulk_xfer_att_payload(uint16_t conn_handle) {
+    uint16_t mtu = ble_att_mtu(conn_handle);
+
+    /* 扣除 3 字节 ATT 通知头 */
+    return mtu > 3 ? mtu - 3 : 0;
+}
+
+void bulk_xfer_gap_event(struct ble_gap_event *event) {
+    switch (event->type) {
+#if CONFIG_BT_NIMBLE_50_FEATURE_SUPPORT
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+        ESP_LOGI(TAG, "PHY 更新；conn_handle=%d 状态=%d tx_phy=%d rx_phy=%d",
+                 event->phy_updated.conn_handle, event->phy_updated.status,
+                 event->phy_updated.tx_phy, event->phy_updated.rx_phy);
+        break;
+#endif
+
+    case BLE_GAP_EVENT_DISCONNECT:
+        if (event->disconnect.conn.conn_handle == bulk_conn_handle) {
+            bulk_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+int bulk_xfer_start_benchmark(uint16_t conn_handle, uint16_t attr_handle,
+                              uint32_t total_bytes) {
+    if (bench_running) {
+        return BLE_HS_EBUSY;
+    }
+
+    bench_args.conn_handle = conn_handle;
+    bench_args.attr_handle = attr_handle;
+    bench_args.total_bytes =
+        total_bytes != 0 ? total_bytes : BULK_XFER_BENCH_DEFAULT_LEN;
+    bench_running = true;
+
+    if (xTaskCreate(benchmark_task, "Bulk Bench", 3 * 1024, NULL, 4, NULL) !=
+        pdPASS) {
+        bench_running = false;
+        return BLE_HS_ENOMEM;
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "comfort.h"
+#include "common.h"
+#include "esp_cpu.h"
+#include <math.h>
+#include <stdlib.h>
+
+/* Defines */
+/* Magnus 公式系数 (Sonntag 1990): b = 17.62, c = 243.12 °C */
+#define MAGNUS_B_CENTI 1762
+#define MAGNUS_C_CENTI 24312
+#define LN2_Q16 45426       // ln(2)
+#define LOG2E_Q16 94548     // log2(e)
+#define LOG2_10000_Q16 870824   // log2(10000)，湿度以 0.01 % 为单位
+
+/* Private function declarations */
+static int32_t log2_q16(uint32_t x);
+static int32_t exp2_q16(int32_t y);
+static uint32_t isqrt(uint32_t x);
+static int32_t heat_index_centi_f(int32_t tf, int32_t rh);
+
+/* Private variables */
+/* log2(1 + i/32)，Q16，放在 flash 中 */
+static const uint16_t log2_tab[32] = {
+    0,     2909,  5732,  8473,  11136, 13727, 16248, 18704, 21098,
+    23433, 25711, 27936, 30109, 32234, 34312, 36346, 38336, 40286,
+    42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229,
+    57845, 59434, 60997, 62534, 64047,
+};
+
+/* 2^(i/32)，Q16 */
+static const uint32_t exp2_tab[33] = {
+    65536,  66971,  68438,  69936,  71468,  73032,  74632,  76266,  77936,
+    79642,  81386,  83169,  84990,  86851,  88752,  90696,  92682,  94711,
+    96785,  98905,  101070, 103283, 105545, 107856, 110218, 112631, 115098,
+    117618, 120194, 122825, 125515, 128263, 131072,
+};
+
+/* Private functions */
+/* x 为 Q16 正数，返回 log2(x) 的 Q16 值；32 段线性插值，误差约 2e-4 */
+static int32_t log2_q16(uint32_t x) {
+    int n = 31 - __builtin_clz(x);
+    uint32_t m = x << (31 - n);     // 归一化到 [2^31, 2^32)
+    uint32_t i = (m >> 26) & 31;
+    uint32_t rem = (m >> 10) & 0xFFFF;
+    int32_t lo = log2_tab[i];
+    int32_t hi = i == 31 ? 65536 : log2_tab[i + 1];
+
+    return ((n - 16) << 16) + lo + (int32_t)(((hi - lo) * rem) >> 16);
+}
+
+/* y 为 Q16，返回 2^y 的 Q16 值，结果需小于 2^15 */
+static int32_t exp2_q16(int32_t y) {
+    int32_t n = y >> 16;            // 向下取整
+    uint32_t f = y & 0xFFFF;
+    uint32_t i = f >> 11;
+    uint32_t rem = f & 0x7FF;
+    uint32_t v = exp2_tab[i] + (((exp2_tab[i + 1] - exp2_tab[i]) * rem) >> 11);
+
+    return n >= 0 ? (int32_t)(v << n) : (int32_t)(v >> -n);
+}
+
+static uint32_t isqrt(uint32_t x) {
+    uint32_t r = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+/*
+ * NOAA 酷热指数，输入 0.01 °F / 0.01 %，输出 0.01 °F。
+ * Rothfusz 回归按湿度整理成 a + b*T + c*T^2，系数以 1e-9 为单位。
+ */
+static int32_t heat_index_centi_f(int32_t tf, int32_t rh) {
+    int64_t r = rh;
+    int64_t t = tf;
+    int32_t hi;
+
+    /* Steadman 简化公式，结果低于 80 °F 时直接使用 */
+    hi = (tf + 6100 + (tf - 6800) * 12 / 10 + rh * 94 / 1000) / 2;
+    if ((hi + tf) / 2 < 8000) {
+        return hi;
+    }
+
+    int64_t a = -42379000000LL + 10143331270LL * r / 100 - 54817170LL * r * r / 10000;
+    int64_t b = 2049015230LL - 224755410LL * r / 100 + 852820LL * r * r / 10000;
+    int64_t c = -6837830LL + 1228740LL * r / 100 - 1990LL * r * r / 10000;
+    hi = (int32_t)((a + b * t / 100 + c * t * t / 10000) / 10000000);
+
+    if (rh < 1300 && tf >= 8000 && tf <= 11200) {
+        /* 干燥修正: ((13 - RH) / 4) * sqrt((17 - |T - 95|) / 17) */
+        uint32_t s = isqrt(((uint32_t)(1700 - abs(tf - 9500)) << 16) / 1700);
+        hi -= (1300 - rh) * (int32_t)s / (4 * 256);
+    } else if (rh > 8500 && tf >= 8000 && tf <= 8700) {
+        /* 潮湿修正: ((RH - 85) / 10) * ((87 - T) / 5) */
+        hi += (rh - 8500) * (8700 - tf) / 5000;
+    }
+    return hi;
+}
+
+/* Public functions */
+void comfort_compute(int16_t temp, uint16_t humi, struct comfort_metrics *out) {
+    int32_t rh = humi < 1 ? 1 : humi > 10000 ? 10000 : humi;
+    int32_t t = temp;
+    int32_t term, gamma, es, hi;
+    int64_t ah;
+
+    /* b*T/(c+T)，Q16 */
+    term = (int32_t)((int64_t)MAGNUS_B_CENTI * t * 65536 /
+                     ((int64_t)100 * (MAGNUS_C_CENTI + t)));
+
+    /* 露点: gamma = ln(RH) + b*T/(c+T)，Td = c*gamma / (b - gamma) */
+    gamma = (int32_t)(((int64_t)(log2_q16((uint32_t)rh << 16) - LOG2_10000_Q16) * LN2_Q16) >> 16) +
+            term;
+    out->dew_point = (int16_t)((int64_t)MAGNUS_C_CENTI * gamma /
+                               (((int64_t)MAGNUS_B_CENTI << 16) / 100 - gamma));
+
+    /* 绝对湿度: 216.7 * RH * 6.112 * exp(term) / (273.15 + T) g/m³ */
+    es = exp2_q16((int32_t)(((int64_t)term * LOG2E_Q16) >> 16));
+    ah = 13244704LL * rh * es / (10000LL * 65536 * (27315 + t));
+    out->abs_humidity = ah > UINT16_MAX ? UINT16_MAX : (uint16_t)ah;
+
+    /* 酷热指数在华氏度下定义，高温高湿时回归式超出 int16 范围需限幅 */
+    hi = (heat_index_centi_f(t * 9 / 5 + 3200, rh) - 3200) * 5 / 9;
+    out->heat_index = hi > INT16_MAX ? INT16_MAX : (int16_t)hi;
+}
+
+void comfort_benchmark(void) {
+    struct comfort_metrics m;
+    int32_t err_dp = 0, err_ah = 0, err_hi = 0;
+    uint32_t lut_cycles = 0, ref_cycles = 0, evals = 0;
+    volatile float sink = 0;
+
+    for (int32_t t = -4000; t <= 8500; t += 50) {
+        for (int32_t rh = 100; rh <= 10000; rh += 100) {
+            uint32_t start = esp_cpu_get_cycle_count();
+            comfort_compute(t, rh, &m);
+            lut_cycles += esp_cpu_get_cycle_count() - start;
+
+            start = esp_cpu_get_cycle_count();
+            float tc = t / 100.0f, r = rh / 100.0f;
+            float g = logf(r / 100) + 17.62f * tc / (243.12f + tc);
+            float dp = 243.12f * g / (17.62f - g);
+            float ah = 216.7f * (r / 100 * 6.112f * expf(17.62f * tc / (243.12f + tc))) /
+                       (273.15f + tc);
+            sink = dp + ah;
+            ref_cycles += esp_cpu_get_cycle_count() - start;
+
+            float tf = tc * 1.8f + 32;
+            float hi = 0.5f * (tf + 61 + (tf - 68) * 1.2f + r * 0.094f);
+            if ((hi + tf) / 2 >= 80) {
+                hi = -42.379f + 2.04901523f * tf + 10.14333127f * r -
+                     0.22475541f * tf * r - 6.83783e-3f * tf * tf -
+                     5.481717e-2f * r * r + 1.22874e-3f * tf * tf * r +
+                     8.5282e-4f * tf * r * r - 1.99e-6f * tf * tf * r * r;
+                if (r < 13 && tf >= 80 && tf <= 112) {
+                    hi -= (13 - r) / 4 * sqrtf((17 - fabsf(tf - 95)) / 17);
+                } else if (r > 85 && tf >= 80 && tf <= 87) {
+                    hi += (r - 85) / 10 * (87 - tf) / 5;
+                }
+            }
+
+            int32_t e = abs(m.dew_point - (int32_t)lroundf(dp * 100));
+            err_dp = e > err_dp ? e : err_dp;
+            e = abs(m.abs_humidity - (int32_t)lroundf(ah * 100));
+            err_ah = e > err_ah ? e : err_ah;
+            /* 酷热指数只在常见室外气温范围内有意义 */
+            if (t <= 5000) {
+                e = abs(m.heat_index - (int32_t)lroundf((hi - 32) / 1.8f * 100));
+                err_hi = e > err_hi ? e : err_hi;
+            }
+            evals++;
+        }
+    }
+    (void)sink;
+
+    ESP_LOGI(TAG, "舒适度指标: %lu 次计算，查表 %lu 周期/次，libm %lu 周期/次",
+             (unsigned long)evals, (unsigned long)(lut_cycles / evals),
+             (unsigned long)(ref_cycles / evals));
+    ESP_LOGI(TAG, "最大误差: 露点 %ld.%02ld °C，绝对湿度 %ld.%02ld g/m³，酷热指数 %ld.%02ld °C",
+             (long)(err_dp / 100), (long)(err_dp % 100), (long)(err_ah / 100),
+             (long)(err_ah % 100), (long)(err_hi / 100), (long)(err_hi % 100));
+}
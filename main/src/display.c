@@ -0,0 +1,393 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "display.h"
+#include "common.h"
+#include "EnGet.h"
+#include "epd.h"
+#include "gap.h"
+#include "history.h"
+#include "render.h"
+#if CONFIG_RTC_DEEP_SLEEP
+#include "esp_system.h"
+#include "flash_log.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#if CONFIG_EPD_DISPLAY
+
+/* Defines */
+#define DISPLAY_REPORT_PERIOD_S 3600
+#define DISPLAY_FULL_REFRESH_S ((uint32_t)CONFIG_DISPLAY_FULL_REFRESH_MINUTES * 60)
+/* 重演出的刷新没有实测忙时间，按 SSD1681 的典型值估算能量 */
+#define DISPLAY_FULL_BUSY_MS_TYP 2000
+#define DISPLAY_PARTIAL_BUSY_MS_TYP 500
+
+/* 显示模型中的字段，各自对应屏幕上的一个区域 */
+enum display_field {
+    FIELD_TEMP,
+    FIELD_HUMI,
+    FIELD_BATT,
+    FIELD_LINK,
+    FIELD_COUNT,
+};
+
+/* 显示模型: 只保存屏幕上实际可见的取整值，变化才需要刷新 */
+struct display_model {
+    int16_t temp_tenths;    // 0.1 °C
+    uint8_t humi;           // 1 %
+    uint8_t batt_bars;      // 0..4 格
+    uint8_t connected;
+};
+
+struct display_region {
+    uint16_t x, y, w, h;
+};
+
+/* Private function declarations */
+static void model_from_centi(struct display_model *model, int16_t temp, uint16_t humi,
+                             float batt, bool connected);
+static void read_model(struct display_model *model);
+static uint32_t diff_model(const struct display_model *a, const struct display_model *b);
+static void build_scene(const struct display_model *model);
+static esp_err_t draw_full(void);
+static esp_err_t draw_partial(uint32_t dirty);
+static bool plan_refresh(uint32_t now, uint32_t dirty, bool *full);
+static void note_refresh(uint32_t now, bool full, uint32_t busy_ms);
+#if CONFIG_RTC_DEEP_SLEEP
+static void replay_sample(const struct history_sample *sample, void *arg);
+static bool restore_shown(void);
+#endif
+static bool account(uint32_t now);
+static void display_task(void *param);
+
+/* Private variables */
+/* 200x200 布局，x 和 w 按字节对齐 */
+_Static_assert(EPD_WIDTH >= 200 && EPD_HEIGHT >= 200, "显示布局按 200x200 面板设计");
+
+static const struct display_region regions[FIELD_COUNT] = {
+    [FIELD_TEMP] = {0, 48, 200, 48},
+    [FIELD_HUMI] = {0, 120, 200, 48},
+    [FIELD_BATT] = {152, 8, 40, 16},
+    [FIELD_LINK] = {128, 8, 16, 16},
+};
+
+static struct render_scene scene;
+static struct display_model shown;
+static uint16_t partials_since_full;
+static uint32_t last_full_s;     // history_now() 时间，深睡眠唤醒后仍连续
+static TaskHandle_t display_task_handle;
+/* 已通知但尚未处理完的更新数，为 0 时才可以进入深睡眠 */
+static volatile uint32_t display_pending = 0;
+static portMUX_TYPE display_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+ * 小时统计: 按 history_now() 的整点划分，深睡眠唤醒后由日志重演补回本小时
+ * 和上一小时的计数
+ */
+static struct display_report last_report;
+static struct display_report hour_acc;
+static uint32_t hour_busy_ms;
+static uint32_t hour_start_s;
+
+/* Private functions */
+/* 与 history_record 使用相同的 0.01 单位取值，日志中的记录可以还原出同一个模型 */
+static void model_from_centi(struct display_model *model, int16_t temp, uint16_t humi,
+                             float batt, bool connected) {
+    model->temp_tenths = (int16_t)((temp + (temp >= 0 ? 5 : -5)) / 10);
+    model->humi = (uint8_t)((humi + 50) / 100);
+    batt = batt < 0 ? 0 : batt > 100 ? 100 : batt;
+    model->batt_bars = (uint8_t)((batt + 12) / 25);
+    model->connected = connected;
+}
+
+static void read_model(struct display_model *model) {
+    model_from_centi(model, (int16_t)(GetTemp() * 100), (uint16_t)(GetHumi() * 100),
+                     GetBatteryPercentage(), gap_conn_count() > 0);
+}
+
+static uint32_t diff_model(const struct display_model *a, const struct display_model *b) {
+    uint32_t dirty = 0;
+
+    if (a->temp_tenths != b->temp_tenths) {
+        dirty |= 1 << FIELD_TEMP;
+    }
+    if (a->humi != b->humi) {
+        dirty |= 1 << FIELD_HUMI;
+    }
+    if (a->batt_bars != b->batt_bars) {
+        dirty |= 1 << FIELD_BATT;
+    }
+    if (a->connected != b->connected) {
+        dirty |= 1 << FIELD_LINK;
+    }
+    return dirty;
+}
+
+static void build_scene(const struct display_model *model) {
+    const struct display_region *batt = &regions[FIELD_BATT];
+    char text[RENDER_TEXT_MAX];
+    int t = model->temp_tenths;
+
+    render_clear(&scene);
+
+    snprintf(text, sizeof(text), "%s%d.%d'C", t < 0 ? "-" : "", abs(t) / 10, abs(t) % 10);
+    render_text(&scene, 8, regions[FIELD_TEMP].y + 4, &font_large, true, text);
+
+    snprintf(text, sizeof(text), "%d%%", model->humi);
+    render_text(&scene, 8, regions[FIELD_HUMI].y + 4, &font_large, true, text);
+
+    /* 电池图标: 外框 + 正极 + 电量格 */
+    render_rect(&scene, batt->x, batt->y + 2, 34, 12, true);
+    render_rect(&scene, batt->x + 2, batt->y + 4, 30, 8, false);
+    render_rect(&scene, batt->x + 34, batt->y + 5, 3, 6, true);
+    for (int i = 0; i < model->batt_bars; i++) {
+        render_rect(&scene, batt->x + 3 + i * 7, batt->y + 5, 6, 6, true);
+    }
+
+    if (model->connected) {
+        render_text(&scene, regions[FIELD_LINK].x + 4, regions[FIELD_LINK].y, &font_small,
+                    true, "*");
+    }
+}
+
+/* 整屏写入两块 RAM 后全刷，清除局刷累积的残影 */
+static esp_err_t draw_full(void) {
+    esp_err_t rc = ESP_OK;
+
+    for (int ram = EPD_RAM_NEW; ram <= EPD_RAM_OLD && rc == ESP_OK; ram++) {
+        rc = render_window(&scene, ram, 0, 0, EPD_ROW_BYTES * 8, EPD_HEIGHT);
+    }
+    if (rc == ESP_OK) {
+        rc = epd_refresh(EPD_REFRESH_FULL);
+    }
+    return rc;
+}
+
+/*
+ * 只重绘变化的区域: 写入新图像后局刷一次，
+ * 再把相同内容写入旧图像 RAM，作为下次局刷的比较基准。
+ */
+static esp_err_t draw_partial(uint32_t dirty) {
+    esp_err_t rc = ESP_OK;
+
+    for (int i = 0; i < FIELD_COUNT && rc == ESP_OK; i++) {
+        if (dirty & (1 << i)) {
+            const struct display_region *r = &regions[i];
+            rc = render_window(&scene, EPD_RAM_NEW, r->x, r->y, r->w, r->h);
+        }
+    }
+    if (rc == ESP_OK) {
+        rc = epd_refresh(EPD_REFRESH_PARTIAL);
+    }
+    for (int i = 0; i < FIELD_COUNT && rc == ESP_OK; i++) {
+        if (dirty & (1 << i)) {
+            const struct display_region *r = &regions[i];
+            rc = render_window(&scene, EPD_RAM_OLD, r->x, r->y, r->w, r->h);
+        }
+    }
+    return rc;
+}
+
+/*
+ * 是否需要刷新及刷新方式: 局刷次数到上限，或距上次全刷超时且期间有过局刷，
+ * 则全刷去残影；超时本身也会触发一次刷新。
+ */
+static bool plan_refresh(uint32_t now, uint32_t dirty, bool *full) {
+    bool timed_out = partials_since_full > 0 && now - last_full_s >= DISPLAY_FULL_REFRESH_S;
+
+    *full = timed_out || partials_since_full >= CONFIG_DISPLAY_FULL_REFRESH_EVERY;
+    return dirty != 0 || timed_out;
+}
+
+static void note_refresh(uint32_t now, bool full, uint32_t busy_ms) {
+    if (full) {
+        partials_since_full = 0;
+        last_full_s = now;
+        hour_acc.full_refreshes++;
+    } else {
+        partials_since_full++;
+        hour_acc.partial_refreshes++;
+    }
+    hour_busy_ms += busy_ms;
+}
+
+#if CONFIG_RTC_DEEP_SLEEP
+/* 按显示任务的规则重演一条记录，arg 指向是否已有基准画面 */
+static void replay_sample(const struct history_sample *sample, void *arg) {
+    bool *have_shown = arg;
+    struct display_model model;
+    bool full;
+
+    /* 只在没有连接时进入深睡眠，睡前画面不带连接标记 */
+    model_from_centi(&model, sample->temp, sample->humi, sample->batt, false);
+    account(sample->ts);
+    if (!*have_shown) {
+        shown = model;
+        last_full_s = sample->ts;
+        *have_shown = true;
+        return;
+    }
+    if (plan_refresh(sample->ts, diff_model(&model, &shown), &full)) {
+        note_refresh(sample->ts, full,
+                     full ? DISPLAY_FULL_BUSY_MS_TYP : DISPLAY_PARTIAL_BUSY_MS_TYP);
+        shown = model;
+    }
+}
+
+/*
+ * 深睡眠唤醒后面板仍保持着睡前的画面，而 RAM 已被清空。
+ * 从 flash 日志重演最近一个全刷周期和上一整点以来的记录，还原 shown、
+ * 全刷计划以及小时统计，日志为空时返回 false。
+ */
+static bool restore_shown(void) {
+    uint32_t last_ts = flash_log_last_ts();
+    uint32_t from;
+    bool have_shown = false;
+
+    if (last_ts == 0) {
+        return false;
+    }
+    from = last_ts > DISPLAY_FULL_REFRESH_S ? last_ts - DISPLAY_FULL_REFRESH_S : 0;
+    hour_start_s = last_ts - last_ts % DISPLAY_REPORT_PERIOD_S;
+    if (hour_start_s >= DISPLAY_REPORT_PERIOD_S) {
+        hour_start_s -= DISPLAY_REPORT_PERIOD_S;
+    }
+    if (from > hour_start_s) {
+        from = hour_start_s;
+    }
+    flash_log_replay(from, replay_sample, &have_shown);
+    return have_shown;
+}
+#endif
+
+/*
+ * 跨过整点时结算上一小时的刷新次数和能量: E = U * I * t。
+ * 中间跳过了整小时（例如校时）则上一小时没有刷新。有结算时返回 true。
+ */
+static bool account(uint32_t now) {
+    uint32_t hour = now - now % DISPLAY_REPORT_PERIOD_S;
+
+    if (hour == hour_start_s) {
+        return false;
+    }
+
+    if (hour - hour_start_s == DISPLAY_REPORT_PERIOD_S) {
+        last_report = hour_acc;
+        last_report.energy_mj =
+            (uint32_t)((uint64_t)hour_busy_ms * CONFIG_DISPLAY_REFRESH_CURRENT_UA *
+                       CONFIG_DISPLAY_SUPPLY_MV / 1000000000ULL);
+    } else {
+        memset(&last_report, 0, sizeof(last_report));
+    }
+    memset(&hour_acc, 0, sizeof(hour_acc));
+    hour_busy_ms = 0;
+    hour_start_s = hour;
+    return true;
+}
+
+static void log_report(void) {
+    ESP_LOGI(TAG, "显示刷新统计(1 小时): 局刷 %u 次，全刷 %u 次，约 %lu mJ",
+             last_report.partial_refreshes, last_report.full_refreshes,
+             (unsigned long)last_report.energy_mj);
+}
+
+static void display_task(void *param) {
+    struct display_model model;
+    struct epd_stats stats;
+
+    while (1) {
+        /* 一次取走所有累积的通知，处理完后按取走的数量扣减 */
+        uint32_t taken = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        read_model(&model);
+        uint32_t dirty = diff_model(&model, &shown);
+        uint32_t now = history_now();
+        bool full;
+
+        if (account(now)) {
+            log_report();
+        }
+        if (plan_refresh(now, dirty, &full)) {
+            build_scene(&model);
+            esp_err_t rc = epd_init();
+            if (rc == ESP_OK) {
+                rc = full ? draw_full() : draw_partial(dirty);
+            }
+            epd_sleep();
+            if (rc == ESP_OK) {
+                epd_get_stats(&stats);
+                note_refresh(now, full, stats.last_busy_ms);
+                shown = model;
+            } else {
+                ESP_LOGE(TAG, "显示刷新失败，错误码: %d", rc);
+            }
+        }
+        taskENTER_CRITICAL(&display_lock);
+        display_pending -= taken;
+        taskEXIT_CRITICAL(&display_lock);
+    }
+}
+
+/* Public functions */
+esp_err_t display_init(void) {
+    struct epd_stats stats;
+    uint32_t now;
+    esp_err_t rc;
+
+#if CONFIG_RTC_DEEP_SLEEP
+    /* 唤醒后沿用面板上的画面，之后只局刷变化的区域 */
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP && restore_shown()) {
+        ESP_LOGI(TAG, "深睡眠唤醒，沿用面板画面；距上次全刷已局刷 %u 次",
+                 partials_since_full);
+    } else
+#endif
+    {
+        rc = epd_init();
+        if (rc != ESP_OK) {
+            return rc;
+        }
+
+        read_model(&shown);
+        build_scene(&shown);
+        rc = draw_full();
+        epd_sleep();
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        epd_get_stats(&stats);
+        now = history_now();
+        hour_start_s = now - now % DISPLAY_REPORT_PERIOD_S;
+        note_refresh(now, true, stats.last_busy_ms);
+    }
+    account(history_now());
+
+    if (xTaskCreate(display_task, "Display", 3 * 1024, NULL, 3,
+                    &display_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void display_update(void) {
+    if (display_task_handle != NULL) {
+        taskENTER_CRITICAL(&display_lock);
+        display_pending++;
+        taskEXIT_CRITICAL(&display_lock);
+        xTaskNotifyGive(display_task_handle);
+    }
+}
+
+void display_wait_idle(void) {
+    while (display_pending != 0) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+void display_get_report(struct display_report *report) { *report = last_report; }
+
+#endif // CONFIG_EPD_DISPLAY
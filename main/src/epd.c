@@ -0,0 +1,363 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "epd.h"
+#include "common.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+#if CONFIG_EPD_DISPLAY
+
+/* Defines */
+#define EPD_SPI_HOST SPI2_HOST
+#define EPD_SPI_CLOCK_HZ (10 * 1000 * 1000)
+#define EPD_DMA_CHUNK 128       // 每个 DMA 缓冲区字节数
+#define EPD_DMA_SLOTS 2         // 乒乓缓冲: CPU 填一块时 DMA 发另一块
+#define EPD_BUSY_TIMEOUT_MS 5000
+#define EPD_RESET_TIMEOUT_MS 100    // 软件复位数毫秒内完成，超时视为未接屏
+
+/* SSD1681 命令 */
+#define EPD_CMD_DRIVER_OUTPUT 0x01
+#define EPD_CMD_DEEP_SLEEP 0x10
+#define EPD_CMD_DATA_ENTRY 0x11
+#define EPD_CMD_SW_RESET 0x12
+#define EPD_CMD_TEMP_SENSOR 0x18
+#define EPD_CMD_MASTER_ACTIVATE 0x20
+#define EPD_CMD_UPDATE_CTRL2 0x22
+#define EPD_CMD_WRITE_RAM_BW 0x24
+#define EPD_CMD_WRITE_RAM_RED 0x26
+#define EPD_CMD_BORDER 0x3C
+#define EPD_CMD_RAM_X_RANGE 0x44
+#define EPD_CMD_RAM_Y_RANGE 0x45
+#define EPD_CMD_RAM_X_COUNTER 0x4E
+#define EPD_CMD_RAM_Y_COUNTER 0x4F
+
+#define EPD_UPDATE_FULL 0xF7        // 加载温度和波形，显示模式 1
+#define EPD_UPDATE_PARTIAL 0xFF     // 显示模式 2，只驱动变化的像素
+#define EPD_BORDER_FULL 0x05
+#define EPD_BORDER_PARTIAL 0x80
+
+/* Private function declarations */
+static void IRAM_ATTR spi_pre_cb(spi_transaction_t *t);
+static void IRAM_ATTR busy_isr(void *arg);
+static esp_err_t drain(void);
+static esp_err_t send_cmd(uint8_t cmd, const uint8_t *data, size_t len);
+static esp_err_t wait_busy(uint32_t timeout_ms);
+
+/* Private variables */
+static spi_device_handle_t epd_spi;
+static SemaphoreHandle_t busy_sem;
+static uint8_t *dma_buf[EPD_DMA_SLOTS];
+static spi_transaction_t dma_trans[EPD_DMA_SLOTS];
+static uint8_t dma_next;
+static uint8_t dma_inflight;
+static struct epd_stats stats;
+
+/* Private functions */
+/* D/C 引脚随事务切换: user 为 0 表示命令，1 表示数据 */
+static void IRAM_ATTR spi_pre_cb(spi_transaction_t *t) {
+    gpio_set_level(CONFIG_EPD_PIN_DC, (int)(intptr_t)t->user);
+}
+
+/* 忙信号下降沿表示控制器空闲 */
+static void IRAM_ATTR busy_isr(void *arg) {
+    BaseType_t woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(busy_sem, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/* 等待所有已排队的 DMA 事务完成，之后才能发送轮询事务 */
+static esp_err_t drain(void) {
+    spi_transaction_t *done;
+    esp_err_t rc;
+
+    while (dma_inflight > 0) {
+        rc = spi_device_get_trans_result(epd_spi, &done, portMAX_DELAY);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        dma_inflight--;
+    }
+    return ESP_OK;
+}
+
+/* 命令及其少量参数，参数不超过 4 字节 */
+static esp_err_t send_cmd(uint8_t cmd, const uint8_t *data, size_t len) {
+    spi_transaction_t t = {
+        .length = 8,
+        .flags = SPI_TRANS_USE_TXDATA,
+        .tx_data = {cmd},
+        .user = (void *)0,
+    };
+    esp_err_t rc;
+
+    rc = drain();
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    rc = spi_device_polling_transmit(epd_spi, &t);
+    if (rc != ESP_OK || len == 0) {
+        return rc;
+    }
+
+    t.length = len * 8;
+    t.user = (void *)1;
+    memcpy(t.tx_data, data, len);
+    return spi_device_polling_transmit(epd_spi, &t);
+}
+
+static esp_err_t wait_busy(uint32_t timeout_ms) {
+    while (gpio_get_level(CONFIG_EPD_PIN_BUSY) != 0) {
+        if (xSemaphoreTake(busy_sem, pdMS_TO_TICKS(timeout_ms)) != pdTRUE &&
+            gpio_get_level(CONFIG_EPD_PIN_BUSY) != 0) {
+            ESP_LOGE(TAG, "墨水屏忙信号超时");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+/* Public functions */
+esp_err_t epd_init(void) {
+    const uint8_t driver_output[] = {(EPD_HEIGHT - 1) & 0xFF, (EPD_HEIGHT - 1) >> 8, 0x00};
+    const uint8_t entry_mode = 0x03;    // X、Y 递增，按行写入
+    const uint8_t border = EPD_BORDER_FULL;
+    const uint8_t temp_sensor = 0x80;   // 内部温度传感器
+    esp_err_t rc;
+
+    if (epd_spi == NULL) {
+        spi_bus_config_t bus = {
+            .mosi_io_num = CONFIG_EPD_PIN_MOSI,
+            .miso_io_num = -1,
+            .sclk_io_num = CONFIG_EPD_PIN_SCLK,
+            .quadwp_io_num = -1,
+            .quadhd_io_num = -1,
+            .max_transfer_sz = EPD_DMA_CHUNK,
+        };
+        spi_device_interface_config_t dev = {
+            .clock_speed_hz = EPD_SPI_CLOCK_HZ,
+            .mode = 0,
+            .spics_io_num = CONFIG_EPD_PIN_CS,
+            .queue_size = EPD_DMA_SLOTS,
+            .pre_cb = spi_pre_cb,
+        };
+        gpio_config_t out = {
+            .pin_bit_mask = (1ULL << CONFIG_EPD_PIN_DC) | (1ULL << CONFIG_EPD_PIN_RST),
+            .mode = GPIO_MODE_OUTPUT,
+        };
+        gpio_config_t busy = {
+            .pin_bit_mask = 1ULL << CONFIG_EPD_PIN_BUSY,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_ENABLE,   // 未接屏时忙信号保持高电平，初始化快速失败
+            .intr_type = GPIO_INTR_NEGEDGE,
+        };
+
+        busy_sem = xSemaphoreCreateBinary();
+        if (busy_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (int i = 0; i < EPD_DMA_SLOTS; i++) {
+            dma_buf[i] = heap_caps_malloc(EPD_DMA_CHUNK, MALLOC_CAP_DMA);
+            if (dma_buf[i] == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+
+        ESP_ERROR_CHECK(gpio_config(&out));
+        ESP_ERROR_CHECK(gpio_config(&busy));
+        rc = gpio_install_isr_service(0);
+        if (rc != ESP_OK && rc != ESP_ERR_INVALID_STATE) {
+            return rc;
+        }
+        ESP_ERROR_CHECK(gpio_isr_handler_add(CONFIG_EPD_PIN_BUSY, busy_isr, NULL));
+
+        rc = spi_bus_initialize(EPD_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+        if (rc != ESP_OK) {
+            ESP_LOGE(TAG, "墨水屏 SPI 总线初始化失败，错误码: %d", rc);
+            return rc;
+        }
+        rc = spi_bus_add_device(EPD_SPI_HOST, &dev, &epd_spi);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+    }
+
+    /* 硬件复位同时唤醒深睡眠 */
+    gpio_set_level(CONFIG_EPD_PIN_RST, 0);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    gpio_set_level(CONFIG_EPD_PIN_RST, 1);
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    xSemaphoreTake(busy_sem, 0);
+    rc = send_cmd(EPD_CMD_SW_RESET, NULL, 0);
+    if (rc == ESP_OK && wait_busy(EPD_RESET_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGE(TAG, "未检测到墨水屏");
+        rc = ESP_ERR_NOT_FOUND;
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_DRIVER_OUTPUT, driver_output, sizeof(driver_output));
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_DATA_ENTRY, &entry_mode, 1);
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_BORDER, &border, 1);
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_TEMP_SENSOR, &temp_sensor, 1);
+    }
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    ESP_LOGI(TAG, "墨水屏已初始化；%dx%d", EPD_WIDTH, EPD_HEIGHT);
+    return ESP_OK;
+}
+
+esp_err_t epd_begin_window(enum epd_ram ram, uint16_t x, uint16_t y, uint16_t w,
+                           uint16_t h) {
+    uint16_t y_end = y + h - 1;
+    uint8_t x_range[] = {x / 8, (x + w - 1) / 8};
+    uint8_t y_range[] = {y & 0xFF, y >> 8, y_end & 0xFF, y_end >> 8};
+    esp_err_t rc;
+
+    if ((x | w) % 8 != 0 || w == 0 || h == 0 || x + w > EPD_ROW_BYTES * 8 ||
+        y + h > EPD_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    rc = send_cmd(EPD_CMD_RAM_X_RANGE, x_range, sizeof(x_range));
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_RAM_Y_RANGE, y_range, sizeof(y_range));
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_RAM_X_COUNTER, x_range, 1);
+    }
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_RAM_Y_COUNTER, y_range, 2);
+    }
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    return send_cmd(ram == EPD_RAM_NEW ? EPD_CMD_WRITE_RAM_BW : EPD_CMD_WRITE_RAM_RED,
+                    NULL, 0);
+}
+
+esp_err_t epd_write(const uint8_t *data, size_t len) {
+    spi_transaction_t *done;
+    esp_err_t rc;
+
+    while (len > 0) {
+        size_t n = len < EPD_DMA_CHUNK ? len : EPD_DMA_CHUNK;
+
+        /* 槽位全部在途时回收最早的一个，结果按排队顺序返回 */
+        if (dma_inflight == EPD_DMA_SLOTS) {
+            rc = spi_device_get_trans_result(epd_spi, &done, portMAX_DELAY);
+            if (rc != ESP_OK) {
+                return rc;
+            }
+            dma_inflight--;
+        }
+
+        spi_transaction_t *t = &dma_trans[dma_next];
+        memcpy(dma_buf[dma_next], data, n);
+        memset(t, 0, sizeof(*t));
+        t->length = n * 8;
+        t->tx_buffer = dma_buf[dma_next];
+        t->user = (void *)1;
+
+        rc = spi_device_queue_trans(epd_spi, t, portMAX_DELAY);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        dma_inflight++;
+        dma_next = (dma_next + 1) % EPD_DMA_SLOTS;
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t epd_fill(uint8_t value, size_t len) {
+    uint8_t chunk[32];
+    esp_err_t rc = ESP_OK;
+
+    memset(chunk, value, sizeof(chunk));
+    while (len > 0 && rc == ESP_OK) {
+        size_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+        rc = epd_write(chunk, n);
+        len -= n;
+    }
+    return rc;
+}
+
+esp_err_t epd_refresh(enum epd_refresh mode) {
+    const uint8_t border = mode == EPD_REFRESH_FULL ? EPD_BORDER_FULL : EPD_BORDER_PARTIAL;
+    const uint8_t update = mode == EPD_REFRESH_FULL ? EPD_UPDATE_FULL : EPD_UPDATE_PARTIAL;
+    int64_t start;
+    uint32_t busy_ms;
+    esp_err_t rc;
+
+    rc = send_cmd(EPD_CMD_BORDER, &border, 1);
+    if (rc == ESP_OK) {
+        rc = send_cmd(EPD_CMD_UPDATE_CTRL2, &update, 1);
+    }
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    xSemaphoreTake(busy_sem, 0);
+    start = esp_timer_get_time();
+    rc = send_cmd(EPD_CMD_MASTER_ACTIVATE, NULL, 0);
+    if (rc == ESP_OK) {
+        rc = wait_busy(EPD_BUSY_TIMEOUT_MS);
+    }
+    busy_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+
+    stats.last_busy_ms = busy_ms;
+    if (mode == EPD_REFRESH_FULL) {
+        stats.full_refreshes++;
+        stats.full_busy_ms += busy_ms;
+    } else {
+        stats.partial_refreshes++;
+        stats.partial_busy_ms += busy_ms;
+    }
+    ESP_LOGI(TAG, "墨水屏%s刷新耗时 %lu ms", mode == EPD_REFRESH_FULL ? "全" : "局部",
+             (unsigned long)busy_ms);
+    return rc;
+}
+
+esp_err_t epd_clear(void) {
+    esp_err_t rc;
+
+    for (int ram = EPD_RAM_NEW; ram <= EPD_RAM_OLD; ram++) {
+        rc = epd_begin_window(ram, 0, 0, EPD_ROW_BYTES * 8, EPD_HEIGHT);
+        if (rc == ESP_OK) {
+            rc = epd_fill(0xFF, EPD_ROW_BYTES * EPD_HEIGHT);
+        }
+        if (rc != ESP_OK) {
+            return rc;
+        }
+    }
+    return epd_refresh(EPD_REFRESH_FULL);
+}
+
+esp_err_t epd_sleep(void) {
+    const uint8_t mode = 0x01;  // 深睡眠模式 1，保留 RAM 供下次局刷比较
+
+    return send_cmd(EPD_CMD_DEEP_SLEEP, &mode, 1);
+}
+
+void epd_get_stats(struct epd_stats *out) { *out = stats; }
+
+#endif // CONFIG_EPD_DISPLAY
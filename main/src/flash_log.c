@@ -0,0 +1,615 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "flash_log.h"
+#include <stdlib.h>
+#include "common.h"
+#include "hist_codec.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "freertos/semphr.h"
+
+/* Defines */
+/* 每条压缩记录至少占 1 字节 */
+#define FLASH_LOG_RECORDS_MAX (FLASH_LOG_PAYLOAD_SIZE < UINT8_MAX ? FLASH_LOG_PAYLOAD_SIZE : UINT8_MAX)
+#define FLASH_LOG_STAGE_MAGIC (0x53540000 | FLASH_LOG_VERSION)   // "ST" + 版本
+
+/* Private function declarations */
+static uint32_t block_crc(const uint8_t *block);
+static bool block_is_erased(uint32_t block);
+static int read_valid_block(uint32_t block, uint8_t *buf);
+static int check_block(const uint8_t *buf);
+static esp_err_t erase_sector(uint32_t sector);
+static esp_err_t write_block(void);
+static esp_err_t flush_batch(void);
+static uint32_t stage_crc(void);
+static void stage_seal(void);
+static void stage_recover(void);
+static uint32_t sector_of(uint32_t block);
+static uint32_t seek(uint32_t key, bool by_seq);
+static void keep_last(const struct history_sample *sample, void *arg);
+static uint32_t corrected(uint32_t seq, uint32_t ts);
+
+/* Private variables */
+static const esp_partition_t *log_part;
+static uint32_t block_total;
+static uint32_t wr_block;           // 下一个待写入的块
+static uint32_t oldest_block;       // 最旧的有效块
+static uint32_t next_seq;
+static uint32_t cur_erase_count;    // 写指针所在扇区的擦除次数
+static bool log_empty = true;
+static uint32_t last_ts;            // 最后一条记录(含暂存)的原始时间戳
+static uint32_t last_seq;
+static uint32_t end_seq;            // 最后一条已落盘记录的序号 + 1
+static flash_log_correct_fn correct_fn;
+
+static const uint8_t *map_base;     // 整个分区的只读映射，仅在流式读取期间有效
+static esp_partition_mmap_handle_t map_handle;
+
+/*
+ * 稀疏索引: 每个扇区第一个有效块的首条时间戳与序号，
+ * ts 为 UINT32_MAX 表示该扇区无数据。
+ */
+static struct sector_index {
+    uint32_t ts;
+    uint32_t seq;
+} *sector_idx;
+
+/*
+ * 暂存块放在 .noinit 段: 软件复位、看门狗或 panic 重启时 RAM 不被清零，
+ * 启动时校验通过即作为一个普通块写出，记录和序号都不会丢失。
+ * 上电/掉电复位后内容随机，CRC 校验失败即丢弃。
+ */
+static __NOINIT_ATTR struct log_stage {
+    uint32_t magic;
+    uint32_t first_ts;
+    uint32_t first_seq;
+    uint32_t last_ts;
+    struct hist_codec_state enc;
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    uint32_t crc;
+} stage;
+static bool stage_intact = false;   // 启动时暂存块是否完好(可能为空)
+static uint32_t batch_cycles;       // 本块累计的编码周期数
+static SemaphoreHandle_t log_lock;
+
+/* Private functions */
+static uint32_t sector_of(uint32_t block) { return block / FLASH_LOG_BLOCKS_PER_SECTOR; }
+
+static uint32_t corrected(uint32_t seq, uint32_t ts) {
+    return correct_fn != NULL ? correct_fn(seq, ts) : ts;
+}
+
+static uint32_t block_crc(const uint8_t *block) {
+    uint32_t crc;
+
+    crc = esp_rom_crc32_le(0, block, offsetof(struct flash_log_block_hdr, crc));
+    return esp_rom_crc32_le(crc, block + sizeof(struct flash_log_block_hdr),
+                            FLASH_LOG_PAYLOAD_SIZE);
+}
+
+static bool block_is_erased(uint32_t block) {
+    uint32_t words[sizeof(struct flash_log_block_hdr) / sizeof(uint32_t)];
+
+    if (esp_partition_read(log_part, block * FLASH_LOG_BLOCK_SIZE, words,
+                           sizeof(words)) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        if (words[i] != UINT32_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 读取整个块并校验，成功返回 0 */
+static int read_valid_block(uint32_t block, uint8_t *buf) {
+    if (esp_partition_read(log_part, block * FLASH_LOG_BLOCK_SIZE, buf,
+                           FLASH_LOG_BLOCK_SIZE) != ESP_OK) {
+        return -1;
+    }
+    return check_block(buf);
+}
+
+/* 校验魔数/版本/CRC，buf 可以是 RAM 副本或映射的 flash */
+static int check_block(const uint8_t *buf) {
+    const struct flash_log_block_hdr *hdr = (const struct flash_log_block_hdr *)buf;
+
+    if (hdr->magic != FLASH_LOG_MAGIC || hdr->version != FLASH_LOG_VERSION ||
+        hdr->count > FLASH_LOG_RECORDS_MAX || hdr->len > FLASH_LOG_PAYLOAD_SIZE) {
+        return -1;
+    }
+    return hdr->crc == block_crc(buf) ? 0 : -1;
+}
+
+/*
+ * 擦除扇区前先读出其首块记录的擦除次数，新块沿用并加一，
+ * 以此在掉电后仍能追踪每个扇区的磨损。
+ */
+static esp_err_t erase_sector(uint32_t sector) {
+    struct flash_log_block_hdr hdr;
+    uint32_t offset = sector * FLASH_LOG_SECTOR_SIZE;
+    uint32_t sector_count = block_total / FLASH_LOG_BLOCKS_PER_SECTOR;
+    esp_err_t err;
+
+    err = esp_partition_read(log_part, offset, &hdr, sizeof(hdr));
+    cur_erase_count = (err == ESP_OK && hdr.magic == FLASH_LOG_MAGIC) ? hdr.erase_count + 1 : 1;
+
+    sector_idx[sector].ts = UINT32_MAX;
+    err = esp_partition_erase_range(log_part, offset, FLASH_LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    /* 被擦除的扇区保存着最旧的数据，最旧块顺延到下一个扇区 */
+    if (!log_empty && oldest_block / FLASH_LOG_BLOCKS_PER_SECTOR == sector) {
+        oldest_block = ((sector + 1) % sector_count) * FLASH_LOG_BLOCKS_PER_SECTOR;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t write_block(void) {
+    uint8_t buf[FLASH_LOG_BLOCK_SIZE];
+    struct flash_log_block_hdr *hdr = (struct flash_log_block_hdr *)buf;
+    uint32_t sector_count = block_total / FLASH_LOG_BLOCKS_PER_SECTOR;
+    esp_err_t err;
+
+    /* 进入新扇区前擦除；擦除失败的扇区直接跳过 */
+    for (uint32_t tries = 0; wr_block % FLASH_LOG_BLOCKS_PER_SECTOR == 0; tries++) {
+        if (tries >= sector_count) {
+            return ESP_FAIL;
+        }
+        err = erase_sector(wr_block / FLASH_LOG_BLOCKS_PER_SECTOR);
+        if (err == ESP_OK) {
+            break;
+        }
+        ESP_LOGE(TAG, "擦除历史扇区 %lu 失败: %d",
+                 (unsigned long)(wr_block / FLASH_LOG_BLOCKS_PER_SECTOR), err);
+        wr_block = (wr_block + FLASH_LOG_BLOCKS_PER_SECTOR) % block_total;
+    }
+
+    memset(buf, 0xFF, sizeof(buf));
+    hdr->magic = FLASH_LOG_MAGIC;
+    hdr->version = FLASH_LOG_VERSION;
+    hdr->count = stage.enc.count;
+    hdr->seq = next_seq;
+    hdr->erase_count = cur_erase_count;
+    hdr->first_ts = stage.first_ts;
+    hdr->first_seq = stage.first_seq;
+    hdr->len = stage.enc.len;
+    memcpy(buf + sizeof(*hdr), stage.payload, stage.enc.len);
+    hdr->crc = block_crc(buf);
+
+    ESP_LOGI(TAG, "历史块 seq=%lu: %d 条 %d 字节，压缩比 %d.%02d，编码 %lu 周期/条",
+             (unsigned long)next_seq, stage.enc.count, (int)stage.enc.len,
+             (int)(stage.enc.count * HISTORY_WIRE_BYTES / stage.enc.len),
+             (int)(stage.enc.count * HISTORY_WIRE_BYTES * 100 / stage.enc.len % 100),
+             (unsigned long)(batch_cycles / stage.enc.count));
+
+    /* 整块一次写入，掉电只会留下一个 CRC 校验失败的块 */
+    err = esp_partition_write(log_part, wr_block * FLASH_LOG_BLOCK_SIZE, buf,
+                              sizeof(buf));
+    if (err == ESP_OK && sector_idx[sector_of(wr_block)].ts == UINT32_MAX) {
+        sector_idx[sector_of(wr_block)].ts = stage.first_ts;
+        sector_idx[sector_of(wr_block)].seq = stage.first_seq;
+    }
+    if (err == ESP_OK) {
+        end_seq = stage.first_seq + stage.enc.count;
+    }
+    if (log_empty) {
+        oldest_block = wr_block;
+        log_empty = false;
+    }
+    wr_block = (wr_block + 1) % block_total;
+    next_seq++;
+    return err;
+}
+
+static esp_err_t flush_batch(void) {
+    esp_err_t err = write_block();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "写入历史块失败: %d", err);
+    }
+    hist_codec_enc_init(&stage.enc, stage.payload, sizeof(stage.payload));
+    stage_seal();
+    batch_cycles = 0;
+    return err;
+}
+
+static uint32_t stage_crc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t *)&stage, offsetof(struct log_stage, crc));
+}
+
+/* 每次修改暂存块后更新校验 */
+static void stage_seal(void) {
+    stage.magic = FLASH_LOG_STAGE_MAGIC;
+    stage.crc = stage_crc();
+}
+
+/*
+ * 在写指针和 end_seq 恢复之后调用。暂存块须与日志衔接(首条序号等于 end_seq)，
+ * 且编码器指针指向本固件中的暂存区，否则视为无效。
+ */
+static void stage_recover(void) {
+    bool valid = stage.magic == FLASH_LOG_STAGE_MAGIC && stage.crc == stage_crc() &&
+                 stage.enc.wr == stage.payload && stage.enc.cap == sizeof(stage.payload) &&
+                 stage.enc.len <= stage.enc.cap;
+
+    stage_intact = valid && (stage.enc.count == 0 || log_empty || stage.first_seq == end_seq);
+    if (!stage_intact || stage.enc.count == 0) {
+        hist_codec_enc_init(&stage.enc, stage.payload, sizeof(stage.payload));
+        stage_seal();
+        return;
+    }
+
+    ESP_LOGI(TAG, "恢复重启前暂存的 %d 条记录，序号 %lu 起", stage.enc.count,
+             (unsigned long)stage.first_seq);
+    last_ts = stage.last_ts;
+    last_seq = stage.first_seq + stage.enc.count - 1;
+    flush_batch();
+}
+
+/* Public functions */
+esp_err_t flash_log_init(void) {
+    struct flash_log_block_hdr hdr;
+    uint8_t buf[FLASH_LOG_BLOCK_SIZE];
+    uint32_t newest = FLASH_LOG_BLOCK_NONE;
+    uint32_t sector_count;
+
+    log_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                        FLASH_LOG_PARTITION_SUBTYPE,
+                                        FLASH_LOG_PARTITION_LABEL);
+    if (log_part == NULL) {
+        ESP_LOGE(TAG, "未找到历史数据分区 %s", FLASH_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    log_lock = xSemaphoreCreateMutex();
+    if (log_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    block_total = log_part->size / FLASH_LOG_BLOCK_SIZE;
+    sector_count = block_total / FLASH_LOG_BLOCKS_PER_SECTOR;
+    block_total = sector_count * FLASH_LOG_BLOCKS_PER_SECTOR;
+
+    sector_idx = malloc(sector_count * sizeof(sector_idx[0]));
+    if (sector_idx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memset(sector_idx, 0xFF, sector_count * sizeof(sector_idx[0]));
+
+    /*
+     * 扫描所有通过校验的块，序号最大的即最后写入的块；掉电留下的残块被忽略。
+     * 同时从块头重建扇区时间索引。
+     */
+    for (uint32_t b = 0; b < block_total; b++) {
+        const struct flash_log_block_hdr *bh = (const struct flash_log_block_hdr *)buf;
+
+        if (read_valid_block(b, buf) != 0) {
+            continue;
+        }
+        if (sector_idx[sector_of(b)].ts == UINT32_MAX) {
+            sector_idx[sector_of(b)].ts = bh->first_ts;
+            sector_idx[sector_of(b)].seq = bh->first_seq;
+        }
+        if (newest == FLASH_LOG_BLOCK_NONE || (int32_t)(bh->seq - next_seq) >= 0) {
+            newest = b;
+            next_seq = bh->seq + 1;
+            cur_erase_count = bh->erase_count;
+        }
+    }
+
+    if (newest == FLASH_LOG_BLOCK_NONE) {
+        /* 空分区，从第一个扇区开始(写入前会先擦除) */
+        wr_block = 0;
+        log_empty = true;
+        ESP_LOGI(TAG, "历史日志为空；%lu 个块", (unsigned long)block_total);
+        stage_recover();
+        return ESP_OK;
+    }
+
+    /* 写指针跳过未擦除的残块，直到遇到空块或扇区边界 */
+    wr_block = (newest + 1) % block_total;
+    while (wr_block % FLASH_LOG_BLOCKS_PER_SECTOR != 0 && !block_is_erased(wr_block)) {
+        wr_block = (wr_block + 1) % block_total;
+    }
+
+    /* 环形日志已回绕时，写扇区的下一个扇区保存最旧的数据 */
+    oldest_block = (((newest / FLASH_LOG_BLOCKS_PER_SECTOR) + 1) % sector_count) *
+                   FLASH_LOG_BLOCKS_PER_SECTOR;
+    if (esp_partition_read(log_part, oldest_block * FLASH_LOG_BLOCK_SIZE, &hdr,
+                           sizeof(hdr)) != ESP_OK ||
+        hdr.magic != FLASH_LOG_MAGIC) {
+        oldest_block = 0;
+    }
+    log_empty = false;
+
+    /* 解码最新块得到最后一条记录的时间戳 */
+    if (read_valid_block(newest, buf) == 0) {
+        const struct flash_log_block_hdr *bh = (const struct flash_log_block_hdr *)buf;
+        struct hist_codec_state dec;
+        struct history_sample sample;
+
+        end_seq = bh->first_seq + bh->count;
+        hist_codec_dec_init(&dec, buf + sizeof(*bh), bh->len);
+        while (dec.count < bh->count && hist_codec_dec_next(&dec, &sample) == 0) {
+            last_ts = sample.ts;
+        }
+        last_seq = end_seq - 1;
+    }
+
+    ESP_LOGI(TAG, "历史日志已恢复；写指针=%lu 最旧块=%lu 序号=%lu 擦除次数=%lu",
+             (unsigned long)wr_block, (unsigned long)oldest_block,
+             (unsigned long)next_seq, (unsigned long)cur_erase_count);
+    stage_recover();
+    return ESP_OK;
+}
+
+void flash_log_append(const struct history_sample *sample) {
+    if (log_part == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    uint32_t start = esp_cpu_get_cycle_count();
+    if (hist_codec_enc_add(&stage.enc, sample) != 0) {
+        /* 载荷区已满，先写出当前块，新块从绝对值重新开始 */
+        flush_batch();
+        start = esp_cpu_get_cycle_count();
+        hist_codec_enc_add(&stage.enc, sample);
+    }
+    batch_cycles += esp_cpu_get_cycle_count() - start;
+    if (stage.enc.count == 1) {
+        stage.first_ts = sample->ts;
+        stage.first_seq = sample->seq;
+    }
+    last_ts = sample->ts;
+    last_seq = sample->seq;
+    stage.last_ts = sample->ts;
+
+    if (stage.enc.count >= CONFIG_FLASH_LOG_BATCH) {
+        flush_batch();
+    } else {
+        stage_seal();
+    }
+    xSemaphoreGive(log_lock);
+}
+
+esp_err_t flash_log_flush(void) {
+    esp_err_t err = ESP_OK;
+
+    if (log_part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (stage.enc.count > 0) {
+        err = flush_batch();
+    }
+    xSemaphoreGive(log_lock);
+    return err;
+}
+
+void flash_log_set_correct(flash_log_correct_fn fn) { correct_fn = fn; }
+
+uint32_t flash_log_first_block(void) {
+    return (log_part == NULL || log_empty) ? FLASH_LOG_BLOCK_NONE : oldest_block;
+}
+
+uint32_t flash_log_next_block(uint32_t block) {
+    block = (block + 1) % block_total;
+    return block == wr_block ? FLASH_LOG_BLOCK_NONE : block;
+}
+
+int flash_log_read_raw(uint32_t block, struct flash_log_block_hdr *hdr, uint8_t *payload) {
+    uint8_t buf[FLASH_LOG_BLOCK_SIZE];
+
+    if (log_part == NULL || block >= block_total) {
+        return -1;
+    }
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (read_valid_block(block, buf) != 0) {
+        xSemaphoreGive(log_lock);
+        return -1;
+    }
+    xSemaphoreGive(log_lock);
+
+    memcpy(hdr, buf, sizeof(*hdr));
+    memcpy(payload, buf + sizeof(*hdr), FLASH_LOG_PAYLOAD_SIZE);
+    return 0;
+}
+
+int flash_log_read_block(uint32_t block, struct flash_log_block_hdr *hdr,
+                         struct history_sample *out, size_t max) {
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    struct hist_codec_state dec;
+    size_t n;
+
+    if (flash_log_read_raw(block, hdr, payload) != 0) {
+        return -1;
+    }
+
+    hist_codec_dec_init(&dec, payload, hdr->len);
+    for (n = 0; n < hdr->count && n < max; n++) {
+        if (hist_codec_dec_next(&dec, &out[n]) != 0) {
+            return -1;
+        }
+        out[n].seq = hdr->first_seq + n;
+        out[n].ts = corrected(out[n].seq, out[n].ts);
+    }
+    return n;
+}
+
+/*
+ * 按时间戳或序号在稀疏索引上定位，二者都随块单调递增。
+ * 索引和块头保存原始时间戳，按修正后的时间比较。
+ */
+static uint32_t seek(uint32_t key, bool by_seq) {
+    struct flash_log_block_hdr hdr;
+    uint32_t sector_count = block_total / FLASH_LOG_BLOCKS_PER_SECTOR;
+    uint32_t first_sector;
+    uint32_t used;
+    uint32_t lo = 0;
+    uint32_t hi;
+    uint32_t sector;
+    uint32_t block;
+    uint32_t found;
+
+    if (log_part == NULL || log_empty) {
+        return FLASH_LOG_BLOCK_NONE;
+    }
+
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    first_sector = sector_of(oldest_block);
+    used = (sector_of(wr_block == 0 ? block_total - 1 : wr_block - 1) + sector_count -
+            first_sector) % sector_count + 1;
+
+    /* 在逻辑扇区序列上二分，找到最后一个首条键值 <= key 的扇区 */
+    hi = used;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const struct sector_index *e = &sector_idx[(first_sector + mid) % sector_count];
+        if (e->ts != UINT32_MAX && (by_seq ? e->seq : corrected(e->seq, e->ts)) <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        /* key 早于所有记录，从最旧块开始 */
+        xSemaphoreGive(log_lock);
+        return oldest_block;
+    }
+
+    /* 扇区内顺序读块头，取最后一个首条键值 <= key 的有效块 */
+    sector = (first_sector + lo - 1) % sector_count;
+    found = sector * FLASH_LOG_BLOCKS_PER_SECTOR;
+    for (block = found; sector_of(block) == sector && block != wr_block; block++) {
+        if (esp_partition_read(log_part, block * FLASH_LOG_BLOCK_SIZE, &hdr,
+                               sizeof(hdr)) != ESP_OK ||
+            hdr.magic != FLASH_LOG_MAGIC || hdr.version != FLASH_LOG_VERSION) {
+            continue;
+        }
+        if ((by_seq ? hdr.first_seq : corrected(hdr.first_seq, hdr.first_ts)) > key) {
+            break;
+        }
+        found = block;
+    }
+    xSemaphoreGive(log_lock);
+    return found;
+}
+
+uint32_t flash_log_seek(uint32_t ts) { return seek(ts, false); }
+
+size_t flash_log_replay(uint32_t from_ts, flash_log_replay_fn fn, void *arg) {
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    struct flash_log_block_hdr hdr;
+    struct hist_codec_state dec;
+    struct history_sample sample;
+    size_t n = 0;
+
+    for (uint32_t block = flash_log_seek(from_ts); block != FLASH_LOG_BLOCK_NONE;
+         block = flash_log_next_block(block)) {
+        if (flash_log_read_raw(block, &hdr, payload) != 0) {
+            /* 掉电残块，跳过 */
+            continue;
+        }
+        hist_codec_dec_init(&dec, payload, hdr.len);
+        for (uint32_t i = 0; i < hdr.count && hist_codec_dec_next(&dec, &sample) == 0; i++) {
+            sample.seq = hdr.first_seq + i;
+            sample.ts = corrected(sample.seq, sample.ts);
+            if (sample.ts < from_ts) {
+                continue;
+            }
+            fn(&sample, arg);
+            n++;
+        }
+    }
+    return n;
+}
+
+uint32_t flash_log_seek_seq(uint32_t seq) { return seek(seq, true); }
+
+static void keep_last(const struct history_sample *sample, void *arg) {
+    *(struct history_sample *)arg = *sample;
+}
+
+int flash_log_last(struct history_sample *sample) {
+    if (last_ts == 0) {
+        return -1;
+    }
+    /* 时间戳单调，不早于最后时间戳的只有末尾的记录 */
+    return flash_log_replay(flash_log_last_ts(), keep_last, sample) > 0 ? 0 : -1;
+}
+
+uint32_t flash_log_end_seq(void) { return end_seq; }
+
+uint32_t flash_log_first_seq(void) {
+    uint32_t seq;
+
+    if (log_part == NULL || log_empty) {
+        return end_seq;
+    }
+    seq = sector_idx[sector_of(oldest_block)].seq;
+    return sector_idx[sector_of(oldest_block)].ts == UINT32_MAX ? end_seq : seq;
+}
+
+bool flash_log_stage_intact(void) { return stage_intact; }
+
+uint32_t flash_log_last_ts(void) { return last_ts == 0 ? 0 : corrected(last_seq, last_ts); }
+
+esp_err_t flash_log_mmap_begin(void) {
+    const void *ptr;
+    esp_err_t err;
+
+    if (log_part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (map_base != NULL) {
+        return ESP_OK;
+    }
+
+    err = esp_partition_mmap(log_part, 0, block_total * FLASH_LOG_BLOCK_SIZE,
+                             ESP_PARTITION_MMAP_DATA, &ptr, &map_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "映射历史分区失败: %d", err);
+        return err;
+    }
+    map_base = ptr;
+    return ESP_OK;
+}
+
+void flash_log_mmap_end(void) {
+    if (map_base != NULL) {
+        esp_partition_munmap(map_handle);
+        map_base = NULL;
+    }
+}
+
+int flash_log_visit_block(uint32_t block, flash_log_visit_fn fn, void *arg) {
+    const uint8_t *p;
+    int rc;
+
+    if (map_base == NULL || block >= block_total) {
+        return -1;
+    }
+
+    /* 持锁期间写入方不会擦除该块，回调可以直接读取映射中的载荷 */
+    p = map_base + block * FLASH_LOG_BLOCK_SIZE;
+    xSemaphoreTake(log_lock, portMAX_DELAY);
+    if (check_block(p) != 0) {
+        xSemaphoreGive(log_lock);
+        return -1;
+    }
+    rc = fn((const struct flash_log_block_hdr *)p, p + sizeof(struct flash_log_block_hdr), arg);
+    xSemaphoreGive(log_lock);
+    return rc;
+}
@@ -0,0 +1,145 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "fleet_slot.h"
+#include "common.h"
+#include "esp_mac.h"
+#include "timebase.h"
+
+#if CONFIG_FLEET_SLOTS
+
+/* 私有函数声明 */
+static bool cfg_valid(const struct fleet_slot_cfg *cfg);
+static uint32_t default_offset_ms(void);
+
+/* 私有变量 */
+static struct fleet_slot_cfg slot = {
+    .period_s = CONFIG_FLEET_SLOT_PERIOD_S,
+    .burst_ms = CONFIG_FLEET_SLOT_BURST_MS,
+};
+static portMUX_TYPE slot_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* 私有函数 */
+static bool cfg_valid(const struct fleet_slot_cfg *cfg) {
+    return cfg->period_s >= 10 && cfg->period_s <= 3600 &&
+           cfg->offset_ms < (uint32_t)cfg->period_s * 1000 &&
+           cfg->burst_ms >= 100 && cfg->burst_ms <= cfg->period_s * 1000 / 2;
+}
+
+/*
+ * 未分配时以 BT 地址的 FNV-1a 散列选一个突发时长对齐的时隙，
+ * 设备随机分布，碰撞概率与生日问题相同，网关分配后即可消除。
+ */
+static uint32_t default_offset_ms(void) {
+    uint8_t mac[6] = {0};
+    uint32_t hash = 2166136261u;
+    uint32_t slots = (uint32_t)slot.period_s * 1000 / slot.burst_ms;
+
+    esp_read_mac(mac, ESP_MAC_BT);
+    for (int i = 0; i < sizeof(mac); i++) {
+        hash = (hash ^ mac[i]) * 16777619u;
+    }
+    return (hash % slots) * slot.burst_ms;
+}
+
+/* 公有函数 */
+void fleet_slot_init(void) {
+    struct fleet_slot_cfg stored;
+    nvs_handle_t handle;
+    size_t len = sizeof(stored);
+    bool loaded = false;
+
+    if (nvs_open(FLEET_SLOT_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        loaded = nvs_get_blob(handle, "slot", &stored, &len) == ESP_OK &&
+                 len == sizeof(stored) && cfg_valid(&stored);
+        nvs_close(handle);
+    }
+
+    if (loaded) {
+        slot = stored;
+    } else {
+        slot.offset_ms = default_offset_ms();
+    }
+    ESP_LOGI(TAG, "采样时隙%s: 周期 %u s，偏移 %lu ms，突发 %u ms",
+             loaded ? "(网关分配)" : "(默认)", slot.period_s,
+             (unsigned long)slot.offset_ms, slot.burst_ms);
+}
+
+bool fleet_slot_active(void) {
+    struct timebase_status status;
+
+    timebase_get_status(&status);
+    return status.synced;
+}
+
+void fleet_slot_get(struct fleet_slot_cfg *cfg) {
+    taskENTER_CRITICAL(&slot_lock);
+    *cfg = slot;
+    taskEXIT_CRITICAL(&slot_lock);
+}
+
+int fleet_slot_set(const struct fleet_slot_cfg *cfg) {
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    if (!cfg_valid(cfg)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&slot_lock);
+    slot = *cfg;
+    taskEXIT_CRITICAL(&slot_lock);
+
+    err = nvs_open(FLEET_SLOT_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "打开时隙 NVS 失败: %d", err);
+        return err;
+    }
+    err = nvs_set_blob(handle, "slot", cfg, sizeof(*cfg));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "保存采样时隙失败: %d", err);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "网关分配采样时隙: 周期 %u s，偏移 %lu ms，突发 %u ms",
+             cfg->period_s, (unsigned long)cfg->offset_ms, cfg->burst_ms);
+    return ESP_OK;
+}
+
+void fleet_slot_encode(const struct fleet_slot_cfg *cfg, uint8_t *buf) {
+    buf[0] = cfg->period_s & 0xFF;
+    buf[1] = (cfg->period_s >> 8) & 0xFF;
+    buf[2] = cfg->offset_ms & 0xFF;
+    buf[3] = (cfg->offset_ms >> 8) & 0xFF;
+    buf[4] = (cfg->offset_ms >> 16) & 0xFF;
+    buf[5] = (cfg->offset_ms >> 24) & 0xFF;
+    buf[6] = cfg->burst_ms & 0xFF;
+    buf[7] = (cfg->burst_ms >> 8) & 0xFF;
+}
+
+void fleet_slot_decode(const uint8_t *buf, struct fleet_slot_cfg *cfg) {
+    cfg->period_s = buf[0] | (buf[1] << 8);
+    cfg->offset_ms = buf[2] | (buf[3] << 8) | (buf[4] << 16) | ((uint32_t)buf[5] << 24);
+    cfg->burst_ms = buf[6] | (buf[7] << 8);
+}
+
+uint32_t fleet_slot_wait_ms(void) {
+    struct fleet_slot_cfg cfg;
+    uint64_t now = timebase_now_ms();
+    uint64_t period_ms;
+    uint64_t phase;
+
+    fleet_slot_get(&cfg);
+    period_ms = (uint64_t)cfg.period_s * 1000;
+    phase = (now + period_ms - cfg.offset_ms) % period_ms;
+    return (uint32_t)(period_ms - phase);
+}
+
+#endif // CONFIG_FLEET_SLOTS
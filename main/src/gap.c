@@ -7,16 +7,40 @@
 #include "gap.h"
 #include "common.h"
 #include "gatt_svc.h"
+#include "bulk_xfer.h"
+#include "EnGet.h"
+#include "tx_power.h"
+#include "fleet_slot.h"
 
 /* 私有函数声明 */
 inline static void format_addr(char *addr_str, uint8_t addr[]);
 static void print_conn_desc(struct ble_gap_conn_desc *desc);
-static void start_advertising(void);
+static void fill_adv_fields(struct ble_hs_adv_fields *adv_fields);
+#if !CONFIG_BT_NIMBLE_EXT_ADV || defined(LEGACY_ADV_INSTANCE)
+static void fill_rsp_fields(struct ble_hs_adv_fields *rsp_fields);
+#endif
+static void start_advertising(uint16_t burst_ms);
+#if CONFIG_BT_NIMBLE_EXT_ADV
+static void stop_connectable_advertising(void);
+#endif
 static int gap_event_handler(struct ble_gap_event *event, void *arg);
 
 /* 私有变量 */
 static uint8_t own_addr_type;
+static volatile uint8_t conn_count;
 static uint8_t addr_val[6] = {0};
+#if CONFIG_LONG_RANGE_ADV
+static int8_t lr_tx_power;
+#endif
+#if CONFIG_PERIODIC_READINGS_ADV
+static bool periodic_adv_started = false;
+#endif
+/* burst_ms 非 0 时只广播这么长时间，用于时隙内的突发广播，改用短间隔 */
+#if CONFIG_FLEET_SLOTS
+#define ADV_ITVL_MS(normal, burst_ms) ((burst_ms) != 0 ? CONFIG_FLEET_SLOT_ADV_ITVL_MS : (normal))
+#else
+#define ADV_ITVL_MS(normal, burst_ms) (normal)
+#endif
 static uint8_t esp_uri[] = {BLE_GAP_URI_PREFIX_HTTPS, '/', '/', 'e', 's', 'p', 'r', 'e', 's', 's', 'i', 'f', '.', 'c', 'o', 'm'};
 
 /* 私有函数 */
@@ -51,56 +75,392 @@ static void print_conn_desc(struct ble_gap_conn_desc *desc) {
              desc->sec_state.bonded);
 }
 
-static void start_advertising(void) {
+static void fill_adv_fields(struct ble_hs_adv_fields *adv_fields) {
     /* 局部变量 */
-    int rc = 0;
     const char *name;
-    struct ble_hs_adv_fields adv_fields = {0};
-    struct ble_hs_adv_fields rsp_fields = {0};
-    struct ble_gap_adv_params adv_params = {0};
 
     /* 设置广播标志位 */
-    adv_fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    adv_fields->flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
 
     /* 设置设备名称 */
     name = ble_svc_gap_device_name();
-    adv_fields.name = (uint8_t *)name;
-    adv_fields.name_len = strlen(name);
-    adv_fields.name_is_complete = 1;
+    adv_fields->name = (uint8_t *)name;
+    adv_fields->name_len = strlen(name);
+    adv_fields->name_is_complete = 1;
 
     /* 设置设备发射功率 */
-    adv_fields.tx_pwr_lvl = BLE_HS_ADV_TX_PWR_LVL_AUTO;
-    adv_fields.tx_pwr_lvl_is_present = 1;
+    adv_fields->tx_pwr_lvl = BLE_HS_ADV_TX_PWR_LVL_AUTO;
+    adv_fields->tx_pwr_lvl_is_present = 1;
 
     /* 设置设备外观 */
-    adv_fields.appearance = BLE_GAP_APPEARANCE_GENERIC_TAG;
-    adv_fields.appearance_is_present = 1;
+    adv_fields->appearance = BLE_GAP_APPEARANCE_GENERIC_TAG;
+    adv_fields->appearance_is_present = 1;
 
     /* 设置设备的 LE 角色 */
-    adv_fields.le_role = BLE_GAP_LE_ROLE_PERIPHERAL;
-    adv_fields.le_role_is_present = 1;
+    adv_fields->le_role = BLE_GAP_LE_ROLE_PERIPHERAL;
+    adv_fields->le_role_is_present = 1;
+}
 
-    /* 设置广播字段 */
-    rc = ble_gap_adv_set_fields(&adv_fields);
+#if !CONFIG_BT_NIMBLE_EXT_ADV || defined(LEGACY_ADV_INSTANCE)
+static void fill_rsp_fields(struct ble_hs_adv_fields *rsp_fields) {
+    /* 设置设备地址 */
+    rsp_fields->device_addr = addr_val;
+    rsp_fields->device_addr_type = own_addr_type;
+    rsp_fields->device_addr_is_present = 1;
+
+    /* 设置 URI */
+    rsp_fields->uri = esp_uri;
+    rsp_fields->uri_len = sizeof(esp_uri);
+
+    /* 设置广播间隔 */
+    rsp_fields->adv_itvl = BLE_GAP_ADV_ITVL_MS(500);
+    rsp_fields->adv_itvl_is_present = 1;
+}
+#endif
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+static int ext_adv_set_fields(uint8_t instance,
+                              const struct ble_hs_adv_fields *fields, bool rsp) {
+    /* 局部变量 */
+    int rc = 0;
+    struct os_mbuf *data;
+
+    data = os_msys_get_pkthdr(0, 0);
+    if (data == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = ble_hs_adv_set_fields_mbuf(fields, data);
+    if (rc != 0) {
+        os_mbuf_free_chain(data);
+        return rc;
+    }
+
+    /* data 的所有权交给协议栈 */
+    return rsp ? ble_gap_ext_adv_rsp_set_data(instance, data)
+               : ble_gap_ext_adv_set_data(instance, data);
+}
+
+#if CONFIG_LONG_RANGE_ADV || CONFIG_PERIODIC_READINGS_ADV
+/* 环境传感服务数据: UUID(2) + 温度(2) + 湿度(2) + 电量(1)，小端 */
+static void fill_readings_svc_data(uint8_t *buf) {
+    int16_t temp_value = (int16_t)(GetTemp() * 100);
+    uint16_t humi_value = (uint16_t)(GetHumi() * 100);
+    float percentage = GetBatteryPercentage();
+
+    buf[0] = BLE_GAP_ESS_UUID16 & 0xFF;
+    buf[1] = (BLE_GAP_ESS_UUID16 >> 8) & 0xFF;
+    buf[2] = temp_value & 0xFF;
+    buf[3] = (temp_value >> 8) & 0xFF;
+    buf[4] = humi_value & 0xFF;
+    buf[5] = (humi_value >> 8) & 0xFF;
+    buf[6] = percentage < 0 ? 0 : percentage > 100 ? 100 : (uint8_t)percentage;
+}
+
+static void set_readings_adv_fields(struct ble_hs_adv_fields *fields,
+                                    uint8_t *svc_data) {
+    fill_readings_svc_data(svc_data);
+    fields->svc_data_uuid16 = svc_data;
+    fields->svc_data_uuid16_len = BLE_GAP_READINGS_SVC_DATA_LEN;
+}
+#endif
+
+#if CONFIG_LONG_RANGE_ADV
+static int set_long_range_adv_data(void) {
+    /* 局部变量 */
+    struct ble_hs_adv_fields adv_fields = {0};
+    uint8_t svc_data[BLE_GAP_READINGS_SVC_DATA_LEN];
+
+    fill_adv_fields(&adv_fields);
+
+    /* 扩展广播期间不能再使用传统 HCI 命令查询发射功率 */
+    adv_fields.tx_pwr_lvl = lr_tx_power;
+
+    /* 附带当前读数，扫描端无需连接即可获取 */
+    set_readings_adv_fields(&adv_fields, svc_data);
+
+    return ext_adv_set_fields(LONG_RANGE_ADV_INSTANCE, &adv_fields, false);
+}
+#endif
+
+#ifdef LEGACY_ADV_INSTANCE
+static void start_legacy_advertising(uint16_t burst_ms) {
+    /* 局部变量 */
+    int rc = 0;
+    int8_t tx_power = 0;
+    struct ble_hs_adv_fields adv_fields = {0};
+    struct ble_hs_adv_fields rsp_fields = {0};
+    struct ble_gap_ext_adv_params params = {0};
+
+    if (ble_gap_ext_adv_active(LEGACY_ADV_INSTANCE)) {
+        return;
+    }
+
+    /* 使用传统 PDU，兼容只支持 1M 传统广播的网关 */
+    params.legacy_pdu = 1;
+    params.connectable = 1;
+    params.scannable = 1;
+    params.own_addr_type = own_addr_type;
+    params.primary_phy = BLE_HCI_LE_PHY_1M;
+    params.secondary_phy = BLE_HCI_LE_PHY_1M;
+    params.sid = LEGACY_ADV_INSTANCE;
+    params.tx_power = CONFIG_TX_POWER_ADV_DBM;
+    params.itvl_min = BLE_GAP_ADV_ITVL_MS(ADV_ITVL_MS(500, burst_ms));
+    params.itvl_max = BLE_GAP_ADV_ITVL_MS(ADV_ITVL_MS(500, burst_ms) + 10);
+
+    rc = ble_gap_ext_adv_configure(LEGACY_ADV_INSTANCE, &params, &tx_power,
+                                   gap_event_handler, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "配置传统广播集失败，错误码: %d", rc);
+        return;
+    }
+
+    fill_adv_fields(&adv_fields);
+    adv_fields.tx_pwr_lvl = tx_power;
+    rc = ext_adv_set_fields(LEGACY_ADV_INSTANCE, &adv_fields, false);
     if (rc != 0) {
         ESP_LOGE(TAG, "设置广播数据失败，错误码: %d", rc);
         return;
     }
 
-    /* 设置设备地址 */
-    rsp_fields.device_addr = addr_val;
-    rsp_fields.device_addr_type = own_addr_type;
-    rsp_fields.device_addr_is_present = 1;
+    fill_rsp_fields(&rsp_fields);
+    rc = ext_adv_set_fields(LEGACY_ADV_INSTANCE, &rsp_fields, true);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置扫描响应数据失败，错误码: %d", rc);
+        return;
+    }
 
-    /* 设置 URI */
-    rsp_fields.uri = esp_uri;
-    rsp_fields.uri_len = sizeof(esp_uri);
+    /* duration 单位为 10ms，0 表示一直广播 */
+    rc = ble_gap_ext_adv_start(LEGACY_ADV_INSTANCE, burst_ms / 10, 0);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "开始传统广播失败，错误码: %d", rc);
+        return;
+    }
+    ESP_LOGI(TAG, "传统广播已开始！");
+}
+#endif
 
-    /* 设置广播间隔 */
-    rsp_fields.adv_itvl = BLE_GAP_ADV_ITVL_MS(500);
-    rsp_fields.adv_itvl_is_present = 1;
+#if CONFIG_LONG_RANGE_ADV
+/*
+ * 远距离广播的间隔策略: 启动或断开后先以快速间隔广播一段时间，便于
+ * 网关尽快发现并连接；超时后切换到慢速间隔长期广播以节省电量。
+ */
+static void start_long_range_advertising(bool fast, uint16_t burst_ms) {
+    /* 局部变量 */
+    int rc = 0;
+    struct ble_gap_ext_adv_params params = {0};
+    uint16_t itvl_ms = ADV_ITVL_MS(fast ? CONFIG_LONG_RANGE_ADV_FAST_ITVL_MS
+                                        : CONFIG_LONG_RANGE_ADV_SLOW_ITVL_MS,
+                                   burst_ms);
+    uint16_t duration = fast ? CONFIG_LONG_RANGE_ADV_FAST_TIMEOUT_S * 100 : 0;
+
+    if (ble_gap_ext_adv_active(LONG_RANGE_ADV_INSTANCE)) {
+        return;
+    }
+
+    /* 主/次广播信道均使用 Coded PHY，可连接、不可扫描 */
+    params.connectable = 1;
+    params.own_addr_type = own_addr_type;
+    params.primary_phy = BLE_HCI_LE_PHY_CODED;
+    params.secondary_phy = BLE_HCI_LE_PHY_CODED;
+    params.sid = LONG_RANGE_ADV_INSTANCE;
+    params.tx_power = CONFIG_TX_POWER_ADV_DBM;
+    params.itvl_min = BLE_GAP_ADV_ITVL_MS(itvl_ms);
+    params.itvl_max = BLE_GAP_ADV_ITVL_MS(itvl_ms + 10);
+
+    rc = ble_gap_ext_adv_configure(LONG_RANGE_ADV_INSTANCE, &params,
+                                   &lr_tx_power, gap_event_handler, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "配置远距离广播集失败，错误码: %d", rc);
+        return;
+    }
+
+    rc = set_long_range_adv_data();
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置远距离广播数据失败，错误码: %d", rc);
+        return;
+    }
+
+    /* duration 单位为 10ms，0 表示一直广播 */
+    if (burst_ms != 0) {
+        duration = burst_ms / 10;
+    }
+    rc = ble_gap_ext_adv_start(LONG_RANGE_ADV_INSTANCE, duration, 0);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "开始远距离广播失败，错误码: %d", rc);
+        return;
+    }
+    ESP_LOGI(TAG, "远距离广播已开始！间隔=%d ms", itvl_ms);
+}
+
+#endif
+
+#if CONFIG_PERIODIC_READINGS_ADV
+static int set_periodic_adv_data(void) {
+    /* 局部变量 */
+    int rc = 0;
+    struct ble_hs_adv_fields fields = {0};
+    uint8_t svc_data[BLE_GAP_READINGS_SVC_DATA_LEN];
+    struct os_mbuf *data;
+
+    set_readings_adv_fields(&fields, svc_data);
+
+    data = os_msys_get_pkthdr(0, 0);
+    if (data == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+    rc = ble_hs_adv_set_fields_mbuf(&fields, data);
+    if (rc != 0) {
+        os_mbuf_free_chain(data);
+        return rc;
+    }
+
+#if CONFIG_BT_NIMBLE_PERIODIC_ADV_ENH
+    struct ble_gap_periodic_adv_set_data_params dparams = {0};
+    return ble_gap_periodic_adv_set_data(PERIODIC_ADV_INSTANCE, data, &dparams);
+#else
+    return ble_gap_periodic_adv_set_data(PERIODIC_ADV_INSTANCE, data);
+#endif
+}
+
+/*
+ * 周期广播: 网关同步一次后只需在已知时刻醒来接收，无需持续扫描。
+ * 承载周期广播的扩展广播集不可连接、不可扫描，只用于让网关发现并同步。
+ */
+static void start_periodic_advertising(void) {
+    /* 局部变量 */
+    int rc = 0;
+    struct ble_gap_ext_adv_params params = {0};
+    struct ble_gap_periodic_adv_params pparams = {0};
+    struct ble_hs_adv_fields adv_fields = {0};
+    const char *name;
+
+    if (periodic_adv_started) {
+        return;
+    }
+
+    params.own_addr_type = own_addr_type;
+    params.primary_phy = BLE_HCI_LE_PHY_1M;
+    params.secondary_phy = BLE_HCI_LE_PHY_1M;
+    params.sid = PERIODIC_ADV_INSTANCE;
+    params.tx_power = CONFIG_TX_POWER_ADV_DBM;
+    params.itvl_min = BLE_GAP_ADV_ITVL_MS(CONFIG_PERIODIC_READINGS_ADV_ITVL_MS);
+    params.itvl_max = BLE_GAP_ADV_ITVL_MS(CONFIG_PERIODIC_READINGS_ADV_ITVL_MS + 10);
+
+    rc = ble_gap_ext_adv_configure(PERIODIC_ADV_INSTANCE, &params, NULL,
+                                   gap_event_handler, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "配置周期广播集失败，错误码: %d", rc);
+        return;
+    }
+
+    /* 扩展广播只带名称，便于网关识别后同步 */
+    name = ble_svc_gap_device_name();
+    adv_fields.name = (uint8_t *)name;
+    adv_fields.name_len = strlen(name);
+    adv_fields.name_is_complete = 1;
+    rc = ext_adv_set_fields(PERIODIC_ADV_INSTANCE, &adv_fields, false);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置周期广播集数据失败，错误码: %d", rc);
+        return;
+    }
+
+    pparams.include_tx_power = 0;
+    pparams.itvl_min = BLE_GAP_PERIODIC_ITVL_MS(CONFIG_PERIODIC_READINGS_ADV_SYNC_ITVL_MS);
+    pparams.itvl_max = BLE_GAP_PERIODIC_ITVL_MS(CONFIG_PERIODIC_READINGS_ADV_SYNC_ITVL_MS);
+    rc = ble_gap_periodic_adv_configure(PERIODIC_ADV_INSTANCE, &pparams);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "配置周期广播失败，错误码: %d", rc);
+        return;
+    }
+
+    rc = set_periodic_adv_data();
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置周期广播数据失败，错误码: %d", rc);
+        return;
+    }
+
+#if CONFIG_BT_NIMBLE_PERIODIC_ADV_ENH
+    struct ble_gap_periodic_adv_start_params sparams = {0};
+    rc = ble_gap_periodic_adv_start(PERIODIC_ADV_INSTANCE, &sparams);
+#else
+    rc = ble_gap_periodic_adv_start(PERIODIC_ADV_INSTANCE);
+#endif
+    if (rc != 0) {
+        ESP_LOGE(TAG, "开始周期广播失败，错误码: %d", rc);
+        return;
+    }
+
+    rc = ble_gap_ext_adv_start(PERIODIC_ADV_INSTANCE, 0, 0);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "开始周期广播集失败，错误码: %d", rc);
+        return;
+    }
+    periodic_adv_started = true;
+    ESP_LOGI(TAG, "周期广播已开始！间隔=%d ms",
+             CONFIG_PERIODIC_READINGS_ADV_SYNC_ITVL_MS);
+}
+#endif
+
+/*
+ * 连接只会从其中一个可连接广播集建立，该集由控制器自动结束；
+ * 另一个集需要手动停止，断开后由 start_advertising 一并恢复。
+ */
+static void stop_connectable_advertising(void) {
+#ifdef LEGACY_ADV_INSTANCE
+    if (ble_gap_ext_adv_active(LEGACY_ADV_INSTANCE)) {
+        ble_gap_ext_adv_stop(LEGACY_ADV_INSTANCE);
+    }
+#endif
+#if CONFIG_LONG_RANGE_ADV
+    if (ble_gap_ext_adv_active(LONG_RANGE_ADV_INSTANCE)) {
+        ble_gap_ext_adv_stop(LONG_RANGE_ADV_INSTANCE);
+    }
+#endif
+}
+
+static void start_advertising(uint16_t burst_ms) {
+#if CONFIG_FLEET_SLOTS
+    /* 已加入时隙网格，只在 gap_adv_burst 触发的时隙内广播 */
+    if (burst_ms == 0 && fleet_slot_active()) {
+        return;
+    }
+#endif
+#ifdef LEGACY_ADV_INSTANCE
+    start_legacy_advertising(burst_ms);
+#endif
+#if CONFIG_LONG_RANGE_ADV
+    start_long_range_advertising(true, burst_ms);
+#endif
+#if CONFIG_PERIODIC_READINGS_ADV
+    start_periodic_advertising();
+#endif
+}
+#else
+static void start_advertising(uint16_t burst_ms) {
+    /* 局部变量 */
+    int rc = 0;
+    struct ble_hs_adv_fields adv_fields = {0};
+    struct ble_hs_adv_fields rsp_fields = {0};
+    struct ble_gap_adv_params adv_params = {0};
+
+#if CONFIG_FLEET_SLOTS
+    /* 已加入时隙网格，只在 gap_adv_burst 触发的时隙内广播 */
+    if (burst_ms == 0 && fleet_slot_active()) {
+        return;
+    }
+#endif
+
+    /* 设置广播字段 */
+    fill_adv_fields(&adv_fields);
+    rc = ble_gap_adv_set_fields(&adv_fields);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "设置广播数据失败，错误码: %d", rc);
+        return;
+    }
 
     /* 设置扫描响应字段 */
+    fill_rsp_fields(&rsp_fields);
     rc = ble_gap_adv_rsp_set_fields(&rsp_fields);
     if (rc != 0) {
         ESP_LOGE(TAG, "设置扫描响应数据失败，错误码: %d", rc);
@@ -112,11 +472,12 @@ static void start_advertising(void) {
     adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
 
     /* 设置广播间隔 */
-    adv_params.itvl_min = BLE_GAP_ADV_ITVL_MS(500);
-    adv_params.itvl_max = BLE_GAP_ADV_ITVL_MS(510);
+    adv_params.itvl_min = BLE_GAP_ADV_ITVL_MS(ADV_ITVL_MS(500, burst_ms));
+    adv_params.itvl_max = BLE_GAP_ADV_ITVL_MS(ADV_ITVL_MS(500, burst_ms) + 10);
 
     /* 开始广播 */
-    rc = ble_gap_adv_start(own_addr_type, NULL, BLE_HS_FOREVER, &adv_params,
+    rc = ble_gap_adv_start(own_addr_type, NULL,
+                           burst_ms != 0 ? burst_ms : BLE_HS_FOREVER, &adv_params,
                            gap_event_handler, NULL);
     if (rc != 0) {
         ESP_LOGE(TAG, "开始广播失败，错误码: %d", rc);
@@ -124,6 +485,7 @@ static void start_advertising(void) {
     }
     ESP_LOGI(TAG, "广播已开始！");
 }
+#endif
 
 /*
  * NimBLE 采用事件驱动模型来维持 GAP 服务。
@@ -158,6 +520,15 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
 
             /* 打印连接描述符 */
             print_conn_desc(&desc);
+            conn_count++;
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+            /* 停止仍在广播的另一个可连接广播集 */
+            stop_connectable_advertising();
+#endif
+
+            /* 启动发射功率闭环控制 */
+            tx_power_conn_start(event->connect.conn_handle);
 
             /* 尝试更新连接参数 */
             struct ble_gap_upd_params params = {.itvl_min = desc.conn_itvl,
@@ -176,7 +547,7 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
         }
         /* 连接失败，重新开始广播 */
         else {
-            start_advertising();
+            start_advertising(0);
         }
         return rc;
 
@@ -185,9 +556,14 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
         /* 连接终止，打印连接描述符 */
         ESP_LOGI(TAG, "与对端断开连接；原因=%d",
                  event->disconnect.reason);
+        bulk_xfer_gap_event(event);
+        tx_power_conn_stop(event->disconnect.conn.conn_handle);
+        if (conn_count > 0) {
+            conn_count--;
+        }
 
         /* 重新开始广播 */
-        start_advertising();
+        start_advertising(0);
         return rc;
 
     /* 连接参数更新事件 */
@@ -211,7 +587,35 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
         /* 广播完成后，重新开始广播 */
         ESP_LOGI(TAG, "广播已完成；原因=%d",
                  event->adv_complete.reason);
-        start_advertising();
+#if CONFIG_BT_NIMBLE_EXT_ADV
+        /* 广播集因建立连接而结束，断开后再恢复 */
+        if (event->adv_complete.reason == 0) {
+#if CONFIG_LONG_RANGE_ADV
+            if (event->adv_complete.instance == LONG_RANGE_ADV_INSTANCE) {
+                ble_gap_set_prefered_le_phy(event->adv_complete.conn_handle,
+                                            BLE_GAP_LE_PHY_CODED_MASK,
+                                            BLE_GAP_LE_PHY_CODED_MASK,
+                                            LONG_RANGE_PHY_OPTS);
+            }
+#endif
+            return rc;
+        }
+#endif
+#if CONFIG_FLEET_SLOTS
+        /* 时隙内的突发广播结束，等待下一个时隙 */
+        if (fleet_slot_active()) {
+            return rc;
+        }
+#endif
+#if CONFIG_LONG_RANGE_ADV
+        /* 快速广播阶段结束，切换到慢速间隔 */
+        if (event->adv_complete.instance == LONG_RANGE_ADV_INSTANCE &&
+            event->adv_complete.reason == BLE_HS_ETIMEOUT) {
+            start_long_range_advertising(false, 0);
+            return rc;
+        }
+#endif
+        start_advertising(0);
         return rc;
 
     /* 通知发送事件 */
@@ -224,6 +628,9 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
                      "status=%d is_indication=%d",
                      event->notify_tx.conn_handle, event->notify_tx.attr_handle,
                      event->notify_tx.status, event->notify_tx.indication);
+
+            /* 视为丢包，提高发射功率 */
+            tx_power_on_tx_error(event->notify_tx.conn_handle);
         }
         return rc;
 
@@ -249,12 +656,67 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
                  event->mtu.conn_handle, event->mtu.channel_id,
                  event->mtu.value);
         return rc;
+
+#if CONFIG_BT_NIMBLE_50_FEATURE_SUPPORT
+    /* PHY 更新事件 */
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+        bulk_xfer_gap_event(event);
+        return rc;
+#endif
     }
 
     return rc;
 }
 
 /* 公有函数 */
+uint8_t gap_conn_count(void) { return conn_count; }
+
+#if CONFIG_FLEET_SLOTS
+void gap_adv_burst(void) {
+    struct fleet_slot_cfg cfg;
+
+    if (conn_count > 0 || !fleet_slot_active()) {
+        return;
+    }
+
+    /* 停掉校时前留下的连续广播，以突发时长重新开始 */
+#if CONFIG_BT_NIMBLE_EXT_ADV
+#ifdef LEGACY_ADV_INSTANCE
+    ble_gap_ext_adv_stop(LEGACY_ADV_INSTANCE);
+#endif
+#if CONFIG_LONG_RANGE_ADV
+    ble_gap_ext_adv_stop(LONG_RANGE_ADV_INSTANCE);
+#endif
+#else
+    ble_gap_adv_stop();
+#endif
+
+    fleet_slot_get(&cfg);
+    start_advertising(cfg.burst_ms);
+}
+#endif
+
+void gap_update_readings(void) {
+#if CONFIG_LONG_RANGE_ADV
+    /* 广播进行中直接替换数据，无需重启广播集 */
+    if (ble_gap_ext_adv_active(LONG_RANGE_ADV_INSTANCE)) {
+        int rc = set_long_range_adv_data();
+        if (rc != 0) {
+            ESP_LOGE(TAG, "更新远距离广播数据失败，错误码: %d", rc);
+        }
+    }
+#endif
+#if CONFIG_PERIODIC_READINGS_ADV
+    /* 周期广播数据原地更新，已同步的网关在下一个周期事件即可收到 */
+    if (periodic_adv_started) {
+        int rc = set_periodic_adv_data();
+        if (rc != 0) {
+            ESP_LOGE(TAG, "更新周期广播数据失败，错误码: %d", rc);
+        }
+    }
+#endif
+}
+
 void adv_init(void) {
     /* 局部变量 */
     int rc = 0;
@@ -283,8 +745,11 @@ void adv_init(void) {
     format_addr(addr_str, addr_val);
     ESP_LOGI(TAG, "设备地址: %s", addr_str);
 
+    /* 设置广播发射功率 */
+    tx_power_adv_init();
+
     /* 开始广播 */
-    start_advertising();
+    start_advertising(0);
 }
 
 int gap_init(void) {
@@ -5,12 +5,29 @@
  */
 /* 头文件包含 */
 #include "gatt_svc.h"
+#include <stdlib.h>
 #include "common.h"
 #include "EnGet.h"
+#include "bulk_xfer.h"
+#include "tx_power.h"
+#include "history.h"
+#include "hist_sync.h"
+#include "rollup.h"
+#include "comfort.h"
+#include "display.h"
+#include "timebase.h"
+#include "fleet_slot.h"
 
 /* 私有函数声明 */
 static int chr_access(uint16_t conn_handle, uint16_t attr_handle,
                                   struct ble_gatt_access_ctxt *ctxt, void *arg);
+static int xfer_chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                           struct ble_gatt_access_ctxt *ctxt, void *arg);
+static int cts_chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt, void *arg);
+static void current_comfort(struct comfort_metrics *m);
+static int8_t centi_to_sint8(int16_t v);
+static bool outside_deadband(int32_t value, int32_t *last, bool *valid);
 
 /* 私有变量 */
 static const ble_uuid16_t temp_humi_svc_uuid = BLE_UUID16_INIT(0x181A);
@@ -24,8 +41,65 @@ static uint16_t percentage_chr_val_handle;
 
 static const ble_uuid16_t temperature_chr_uuid = BLE_UUID16_INIT(0x2A6E);
 static const ble_uuid16_t humidity_chr_uuid = BLE_UUID16_INIT(0x2A6F);
+static const ble_uuid16_t dew_point_chr_uuid = BLE_UUID16_INIT(0x2A7B);       // 露点
+static const ble_uuid16_t heat_index_chr_uuid = BLE_UUID16_INIT(0x2A7A);      // 酷热指数
+static uint16_t dew_point_chr_val_handle;
+static uint16_t heat_index_chr_val_handle;
 static const ble_uuid16_t battery_svc_uuid = BLE_UUID16_INIT(0x180F);         // 电量服务
 static const ble_uuid16_t percentage_chr_uuid = BLE_UUID16_INIT(0x2A1B);      // 电量百分比属性
+static const ble_uuid16_t cts_svc_uuid = BLE_UUID16_INIT(0x1805);             // 当前时间服务
+static const ble_uuid16_t current_time_chr_uuid = BLE_UUID16_INIT(0x2A2B);    // 当前时间属性
+static uint16_t current_time_chr_val_handle;
+
+/* 数据传输服务(自定义 128 位 UUID) */
+static const ble_uuid128_t xfer_svc_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x00, 0x10, 0x5a, 0x3e);
+static const ble_uuid128_t xfer_ctrl_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x01, 0x10, 0x5a, 0x3e);
+static const ble_uuid128_t xfer_data_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x02, 0x10, 0x5a, 0x3e);
+static const ble_uuid128_t diag_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x03, 0x10, 0x5a, 0x3e);
+static const ble_uuid128_t reading_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x04, 0x10, 0x5a, 0x3e);
+static const ble_uuid128_t comfort_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x05, 0x10, 0x5a, 0x3e);
+#if CONFIG_FLEET_SLOTS
+static const ble_uuid128_t slot_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x06, 0x10, 0x5a, 0x3e);
+static uint16_t slot_chr_val_handle;
+#endif
+static const ble_uuid128_t sensors_chr_uuid =
+    BLE_UUID128_INIT(0x8a, 0x6c, 0x2f, 0x11, 0x5e, 0x43, 0x4b, 0x9d,
+                     0x91, 0x2a, 0x7e, 0x3c, 0x07, 0x10, 0x5a, 0x3e);
+static uint16_t diag_chr_val_handle;
+static uint16_t comfort_chr_val_handle;
+static uint16_t sensors_chr_val_handle;
+static uint16_t reading_chr_val_handle;
+static uint16_t reading_chr_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static bool reading_notify_status = false;
+static uint16_t xfer_ctrl_chr_val_handle;
+static uint16_t xfer_data_chr_val_handle;
+static uint16_t xfer_chr_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static bool xfer_notify_status = false;
+
+/* 数据传输控制点操作码 */
+#define XFER_OP_BENCHMARK 0x01      // 吞吐量测试，可选 4 字节小端长度
+#define XFER_OP_SYNC 0x02           // 补发序号不小于 N 的记录，4 字节小端序号
+#define XFER_OP_ROLLUP 0x03         // 读取聚合: 分辨率(1) + 可选起始时间(4)
+
+/* 最新读数: 序号(4) + 时间戳(4) + 温度(2) + 湿度(2) + 电量(1)，小端 */
+#define READING_CHR_LEN 13
+
+/* 当前时间特性长度，见 cts_chr_access */
+#define CTS_CURRENT_TIME_LEN 10
 
 static uint16_t temp_chr_conn_handle = BLE_HS_CONN_HANDLE_NONE;
 static uint16_t humi_chr_conn_handle = BLE_HS_CONN_HANDLE_NONE;
@@ -34,6 +108,11 @@ static bool percentage_ind_status = false;
 static bool temp_ind_status = false;
 static bool humi_ind_status = false;
 
+/* 上次指示的温湿度(0.01 单位)，用于死区判断 */
+static int32_t temp_last_ind, humi_last_ind;
+static bool temp_last_valid = false;
+static bool humi_last_valid = false;
+
 /* GATT 服务表 */
 static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     /* 温湿度服务 */
@@ -52,6 +131,16 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
                  .access_cb = chr_access,
                  .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_INDICATE,
                  .val_handle = &humidity_chr_val_handle},
+                {/* 露点特性，sint8，单位 1 °C */
+                 .uuid = &dew_point_chr_uuid.u,
+                 .access_cb = chr_access,
+                 .flags = BLE_GATT_CHR_F_READ,
+                 .val_handle = &dew_point_chr_val_handle},
+                {/* 酷热指数特性，sint8，单位 1 °C */
+                 .uuid = &heat_index_chr_uuid.u,
+                 .access_cb = chr_access,
+                 .flags = BLE_GATT_CHR_F_READ,
+                 .val_handle = &heat_index_chr_val_handle},
                 {0}},
     },
     /* 电量服务 */
@@ -67,10 +156,79 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
                  .val_handle = &percentage_chr_val_handle},
                 {0}},
     },
+    /* 当前时间服务，网关连接后写入时间 */
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &cts_svc_uuid.u,
+        .characteristics =
+            (struct ble_gatt_chr_def[]){
+                {/* 当前时间特性 */
+                 .uuid = &current_time_chr_uuid.u,
+                 .access_cb = cts_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE |
+                          BLE_GATT_CHR_F_NOTIFY,
+                 .val_handle = &current_time_chr_val_handle},
+                {0}},
+    },
+    /* 数据传输服务 */
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &xfer_svc_uuid.u,
+        .characteristics =
+            (struct ble_gatt_chr_def[]){
+                {/* 控制点特性 */
+                 .uuid = &xfer_ctrl_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_WRITE,
+                 .val_handle = &xfer_ctrl_chr_val_handle},
+                {/* 批量数据特性 */
+                 .uuid = &xfer_data_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_NOTIFY,
+                 .val_handle = &xfer_data_chr_val_handle},
+                {/* 诊断特性 */
+                 .uuid = &diag_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ,
+                 .val_handle = &diag_chr_val_handle},
+                {/* 带序号的最新读数特性 */
+                 .uuid = &reading_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+                 .val_handle = &reading_chr_val_handle},
+                {/* 精确舒适度指标特性 */
+                 .uuid = &comfort_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ,
+                 .val_handle = &comfort_chr_val_handle},
+                {/* 各传感器读数与一致性特性 */
+                 .uuid = &sensors_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ,
+                 .val_handle = &sensors_chr_val_handle},
+#if CONFIG_FLEET_SLOTS
+                {/* 采样时隙特性，网关读取或分配 */
+                 .uuid = &slot_chr_uuid.u,
+                 .access_cb = xfer_chr_access,
+                 .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+                 .val_handle = &slot_chr_val_handle},
+#endif
+                {0}},
+    },
     {0},
 };
 
 /* 私有函数 */
+static void current_comfort(struct comfort_metrics *m) {
+    comfort_compute((int16_t)(GetTemp() * 100), (uint16_t)(GetHumi() * 100), m);
+}
+
+/* ESS 露点/酷热指数为 sint8 整度，四舍五入并限幅 */
+static int8_t centi_to_sint8(int16_t v) {
+    int32_t deg = (v + (v >= 0 ? 50 : -50)) / 100;
+    return deg > INT8_MAX ? INT8_MAX : deg < INT8_MIN ? INT8_MIN : (int8_t)deg;
+}
+
 static int chr_access(uint16_t conn_handle, uint16_t attr_handle,
                                   struct ble_gatt_access_ctxt *ctxt, void *arg) {
     int rc;
@@ -122,14 +280,260 @@ static int chr_access(uint16_t conn_handle, uint16_t attr_handle,
 
         ESP_LOGE(TAG, "对电量百分比特性的访问操作异常，操作码: %d", ctxt->op);
         return BLE_ATT_ERR_UNLIKELY;
+    }else if (attr_handle == dew_point_chr_val_handle ||
+              attr_handle == heat_index_chr_val_handle){
+        if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+            struct comfort_metrics m;
+            current_comfort(&m);
+            int8_t value = centi_to_sint8(attr_handle == dew_point_chr_val_handle ?
+                                          m.dew_point : m.heat_index);
+            rc = os_mbuf_append(ctxt->om, &value, sizeof(value));
+            return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+
+        ESP_LOGE(TAG, "对舒适度特性的访问操作异常，操作码: %d", ctxt->op);
+        return BLE_ATT_ERR_UNLIKELY;
     }else{
         return 0;
     }
 }
 
+/*
+ * 当前时间: 年(2) + 月 + 日 + 时 + 分 + 秒 + 星期(1=周一) + 1/256 秒 + 调整原因，
+ * 一律按 UTC 解释，时区由网关处理
+ */
+static int cts_chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    struct timebase_civil civil;
+    uint8_t buf[CTS_CURRENT_TIME_LEN] = {0};
+    uint16_t len = 0;
+    int rc;
+
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        timebase_to_civil(timebase_now(), &civil);
+        buf[0] = civil.year & 0xFF;
+        buf[1] = (civil.year >> 8) & 0xFF;
+        buf[2] = civil.month;
+        buf[3] = civil.day;
+        buf[4] = civil.hour;
+        buf[5] = civil.minute;
+        buf[6] = civil.second;
+        buf[7] = civil.weekday;
+        rc = os_mbuf_append(ctxt->om, buf, sizeof(buf));
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        rc = ble_hs_mbuf_to_flat(ctxt->om, buf, sizeof(buf), &len);
+        if (rc != 0 || len != CTS_CURRENT_TIME_LEN) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+
+        civil.year = buf[0] | (buf[1] << 8);
+        civil.month = buf[2];
+        civil.day = buf[3];
+        civil.hour = buf[4];
+        civil.minute = buf[5];
+        civil.second = buf[6];
+        /* 日期须真实存在，年份上限保证换算成 uint32 秒数不溢出 */
+        if (civil.year < 2000 || !timebase_civil_valid(&civil)) {
+            return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+        }
+
+        ESP_LOGI(TAG, "网关写入当前时间；conn_handle=%d", conn_handle);
+        timebase_sync(timebase_from_civil(&civil), buf[8]);
+
+        /* 通知其他订阅者时间已调整 */
+        ble_gatts_chr_updated(current_time_chr_val_handle);
+        return 0;
+    }
+
+    ESP_LOGE(TAG, "对当前时间特性的访问操作异常，操作码: %d", ctxt->op);
+    return BLE_ATT_ERR_UNLIKELY;
+}
+
+static int xfer_chr_access(uint16_t conn_handle, uint16_t attr_handle,
+                           struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    uint8_t buf[READING_CHR_LEN] = {0};
+    uint16_t len = 0;
+    int rc;
+
+    /*
+     * 诊断: 连接功率(1) + 广播功率(1) + RSSI(1) + 功率调整次数(2)，
+     * 启用墨水屏时追加上一小时局刷次数(2) + 全刷次数(2) + 刷新能量 mJ(2)
+     */
+    if (attr_handle == diag_chr_val_handle &&
+        ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        struct tx_power_diag diag;
+        tx_power_get_diag(&diag);
+        buf[0] = (uint8_t)diag.conn_dbm;
+        buf[1] = (uint8_t)diag.adv_dbm;
+        buf[2] = (uint8_t)diag.last_rssi;
+        buf[3] = diag.adjustments & 0xFF;
+        buf[4] = (diag.adjustments >> 8) & 0xFF;
+        len = 5;
+#if CONFIG_EPD_DISPLAY
+        struct display_report report;
+        uint16_t energy;
+        display_get_report(&report);
+        energy = report.energy_mj > UINT16_MAX ? UINT16_MAX : report.energy_mj;
+        buf[5] = report.partial_refreshes & 0xFF;
+        buf[6] = (report.partial_refreshes >> 8) & 0xFF;
+        buf[7] = report.full_refreshes & 0xFF;
+        buf[8] = (report.full_refreshes >> 8) & 0xFF;
+        buf[9] = energy & 0xFF;
+        buf[10] = (energy >> 8) & 0xFF;
+        len = 11;
+#endif
+        rc = os_mbuf_append(ctxt->om, buf, len);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    /* 精确舒适度指标: 露点(2, 0.01 °C) + 绝对湿度(2, 0.01 g/m³) + 酷热指数(2, 0.01 °C) */
+    if (attr_handle == comfort_chr_val_handle &&
+        ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        struct comfort_metrics m;
+        current_comfort(&m);
+        buf[0] = m.dew_point & 0xFF;
+        buf[1] = (m.dew_point >> 8) & 0xFF;
+        buf[2] = m.abs_humidity & 0xFF;
+        buf[3] = (m.abs_humidity >> 8) & 0xFF;
+        buf[4] = m.heat_index & 0xFF;
+        buf[5] = (m.heat_index >> 8) & 0xFF;
+        rc = os_mbuf_append(ctxt->om, buf, 6);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    /*
+     * 传感器: 数量(1) + 标志(1，bit0 不一致，bit1..2 各传感器本次有效)
+     *         + 每个传感器温度(2, 0.01 °C) + 湿度(2, 0.01 %RH)，共 TH_SENSOR_MAX 组
+     */
+    if (attr_handle == sensors_chr_val_handle &&
+        ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        struct th_fused fused;
+        GetTHSensors(&fused);
+        buf[0] = fused.count;
+        buf[1] = (fused.disagree ? 0x01 : 0) | (fused.valid_mask << 1);
+        len = 2;
+        for (int i = 0; i < TH_SENSOR_MAX; i++) {
+            buf[len++] = fused.each[i].temp & 0xFF;
+            buf[len++] = (fused.each[i].temp >> 8) & 0xFF;
+            buf[len++] = fused.each[i].humi & 0xFF;
+            buf[len++] = (fused.each[i].humi >> 8) & 0xFF;
+        }
+        rc = os_mbuf_append(ctxt->om, buf, len);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+    /* 读取或通知最新读数，网关据序号判断是否漏收 */
+    if (attr_handle == reading_chr_val_handle &&
+        ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        struct history_sample sample;
+        if (history_latest(&sample) != 0) {
+            return 0;
+        }
+        buf[0] = sample.seq & 0xFF;
+        buf[1] = (sample.seq >> 8) & 0xFF;
+        buf[2] = (sample.seq >> 16) & 0xFF;
+        buf[3] = (sample.seq >> 24) & 0xFF;
+        buf[4] = sample.ts & 0xFF;
+        buf[5] = (sample.ts >> 8) & 0xFF;
+        buf[6] = (sample.ts >> 16) & 0xFF;
+        buf[7] = (sample.ts >> 24) & 0xFF;
+        buf[8] = sample.temp & 0xFF;
+        buf[9] = (sample.temp >> 8) & 0xFF;
+        buf[10] = sample.humi & 0xFF;
+        buf[11] = (sample.humi >> 8) & 0xFF;
+        buf[12] = sample.batt;
+        rc = os_mbuf_append(ctxt->om, buf, READING_CHR_LEN);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+
+#if CONFIG_FLEET_SLOTS
+    /* 采样时隙: 见 FLEET_SLOT_WIRE_BYTES，写入后从下一个时隙开始生效 */
+    if (attr_handle == slot_chr_val_handle) {
+        struct fleet_slot_cfg cfg;
+        if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+            fleet_slot_get(&cfg);
+            fleet_slot_encode(&cfg, buf);
+            rc = os_mbuf_append(ctxt->om, buf, FLEET_SLOT_WIRE_BYTES);
+            return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        rc = ble_hs_mbuf_to_flat(ctxt->om, buf, sizeof(buf), &len);
+        if (rc != 0 || len != FLEET_SLOT_WIRE_BYTES) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        fleet_slot_decode(buf, &cfg);
+        rc = fleet_slot_set(&cfg);
+        return rc == ESP_OK ? 0 :
+               rc == ESP_ERR_INVALID_ARG ? BLE_ATT_ERR_VALUE_NOT_ALLOWED :
+                                           BLE_ATT_ERR_UNLIKELY;
+    }
+#endif
+
+    if (attr_handle != xfer_ctrl_chr_val_handle ||
+        ctxt->op != BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        ESP_LOGE(TAG, "对数据传输特性的访问操作异常，操作码: %d", ctxt->op);
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+
+    rc = ble_hs_mbuf_to_flat(ctxt->om, buf, sizeof(buf), &len);
+    if (rc != 0 || len < 1) {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    if (!xfer_notify_status || xfer_chr_conn_handle != conn_handle) {
+        ESP_LOGW(TAG, "数据传输特性未订阅通知；conn_handle=%d", conn_handle);
+        return BLE_ATT_ERR_WRITE_NOT_PERMITTED;
+    }
+
+    switch (buf[0]) {
+    case XFER_OP_BENCHMARK: {
+        uint32_t total = 0;
+        if (len >= 5) {
+            total = buf[1] | (buf[2] << 8) | (buf[3] << 16) | ((uint32_t)buf[4] << 24);
+        }
+        rc = bulk_xfer_start_benchmark(conn_handle, xfer_data_chr_val_handle, total);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    case XFER_OP_SYNC: {
+        if (len < 5) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        uint32_t since = buf[1] | (buf[2] << 8) | (buf[3] << 16) | ((uint32_t)buf[4] << 24);
+        rc = hist_sync_start(conn_handle, xfer_data_chr_val_handle, since);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    case XFER_OP_ROLLUP: {
+        uint32_t since = 0;
+        if (len < 2 || buf[1] >= ROLLUP_LEVELS) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        if (len >= 6) {
+            since = buf[2] | (buf[3] << 8) | (buf[4] << 16) | ((uint32_t)buf[5] << 24);
+        }
+        rc = hist_sync_rollup_start(conn_handle, xfer_data_chr_val_handle, buf[1], since);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    default:
+        return BLE_ATT_ERR_REQ_NOT_SUPPORTED;
+    }
+}
+
 /* 公有函数 */
+/* 与上次指示的值相差不足死区时不再发送，首次订阅后总会发送一次 */
+static bool outside_deadband(int32_t value, int32_t *last, bool *valid) {
+    if (*valid && abs(value - *last) < CONFIG_INDICATE_DEADBAND) {
+        return false;
+    }
+    *last = value;
+    *valid = true;
+    return true;
+}
+
 void send_indication(void) {
-    if (temp_ind_status && temp_chr_conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+    if (temp_ind_status && temp_chr_conn_handle != BLE_HS_CONN_HANDLE_NONE &&
+        outside_deadband((int16_t)(GetTemp() * 100), &temp_last_ind, &temp_last_valid)) {
         uint16_t temp_value = (int16_t)(GetTemp() * 100);
         // 分解为两个字节
         temperature_chr_val[0] = temp_value & 0xFF;         // 低字节;
@@ -146,7 +550,8 @@ void send_indication(void) {
         //ESP_LOGW(TAG, "未订阅温度指示或无效连接句柄！");
     }
 
-    if (humi_ind_status && humi_chr_conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+    if (humi_ind_status && humi_chr_conn_handle != BLE_HS_CONN_HANDLE_NONE &&
+        outside_deadband((int16_t)(GetHumi() * 100), &humi_last_ind, &humi_last_valid)) {
         uint16_t humi_value = (int16_t)(GetHumi() * 100);
         // 分解为两个字节
         humidity_chr_val[0] = humi_value & 0xFF;         // 低字节;
@@ -175,21 +580,38 @@ void send_indication(void) {
     } else {
         //ESP_LOGW(TAG, "未订阅电量百分比指示或无效连接句柄！");
     }
+
+    if (reading_notify_status && reading_chr_conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+        int rc = ble_gatts_notify(reading_chr_conn_handle, reading_chr_val_handle);
+        if (rc != 0) {
+            ESP_LOGE(TAG, "发送最新读数通知失败，错误码=%d", rc);
+        }
+    }
 }
 
 void gatt_svr_subscribe_cb(struct ble_gap_event *event) {
     if (event->subscribe.attr_handle == temperature_chr_val_handle) {
         temp_chr_conn_handle = event->subscribe.conn_handle;
         temp_ind_status = event->subscribe.cur_indicate;
+        temp_last_valid = false;
         ESP_LOGI(TAG, "温度订阅事件；conn_handle=%d, 当前状态=%d", temp_chr_conn_handle, temp_ind_status);
     } else if (event->subscribe.attr_handle == humidity_chr_val_handle) {
         humi_chr_conn_handle = event->subscribe.conn_handle;
         humi_ind_status = event->subscribe.cur_indicate;
+        humi_last_valid = false;
         ESP_LOGI(TAG, "湿度订阅事件；conn_handle=%d, 当前状态=%d", humi_chr_conn_handle, humi_ind_status);
     } else if (event->subscribe.attr_handle == percentage_chr_val_handle) {
         battery_chr_conn_handle = event->subscribe.conn_handle;
         percentage_ind_status = event->subscribe.cur_indicate;
         ESP_LOGI(TAG, "电量百分比订阅事件；conn_handle=%d, 当前状态=%d", battery_chr_conn_handle, percentage_ind_status);
+    } else if (event->subscribe.attr_handle == xfer_data_chr_val_handle) {
+        xfer_chr_conn_handle = event->subscribe.conn_handle;
+        xfer_notify_status = event->subscribe.cur_notify;
+        ESP_LOGI(TAG, "数据传输订阅事件；conn_handle=%d, 当前状态=%d", xfer_chr_conn_handle, xfer_notify_status);
+    } else if (event->subscribe.attr_handle == reading_chr_val_handle) {
+        reading_chr_conn_handle = event->subscribe.conn_handle;
+        reading_notify_status = event->subscribe.cur_notify;
+        ESP_LOGI(TAG, "最新读数订阅事件；conn_handle=%d, 当前状态=%d", reading_chr_conn_handle, reading_notify_status);
     }
 }
 
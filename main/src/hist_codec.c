@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "hist_codec.h"
+#include <string.h>
+
+/* Private function declarations */
+static inline uint32_t zigzag(int32_t v);
+static inline int32_t unzigzag(uint32_t v);
+static size_t put_varint(uint8_t *p, uint32_t v);
+static int get_varint(struct hist_codec_state *st, uint32_t *v);
+
+/* Private functions */
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static int get_varint(struct hist_codec_state *st, uint32_t *v) {
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (st->len >= st->cap) {
+            return -1;
+        }
+        uint8_t b = st->rd[st->len++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *v = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Public functions */
+void hist_codec_enc_init(struct hist_codec_state *st, uint8_t *buf, size_t cap) {
+    memset(st, 0, sizeof(*st));
+    st->wr = buf;
+    st->cap = cap;
+}
+
+int hist_codec_enc_add(struct hist_codec_state *st, const struct history_sample *sample) {
+    uint8_t tmp[HIST_CODEC_MAX_SAMPLE_BYTES];
+    uint8_t flags = 0;
+    size_t n = 1;
+    int32_t dts = (int32_t)(sample->ts - st->prev_ts);
+    int32_t dod = st->count == 0 ? (int32_t)sample->ts : dts - st->prev_dts;
+    int32_t dtemp = sample->temp - st->prev_temp;
+    int32_t dhumi = sample->humi - st->prev_humi;
+    int32_t dbatt = sample->batt - st->prev_batt;
+
+    /* 第一条记录写绝对值(与零的差分)，时间戳不做 zigzag */
+    if (dod != 0) {
+        flags |= HIST_CODEC_F_TS;
+        n += put_varint(tmp + n, st->count == 0 ? sample->ts : zigzag(dod));
+    }
+    if (dtemp != 0) {
+        flags |= HIST_CODEC_F_TEMP;
+        n += put_varint(tmp + n, zigzag(dtemp));
+    }
+    if (dhumi != 0) {
+        flags |= HIST_CODEC_F_HUMI;
+        n += put_varint(tmp + n, zigzag(dhumi));
+    }
+    if (dbatt != 0) {
+        flags |= HIST_CODEC_F_BATT;
+        n += put_varint(tmp + n, zigzag(dbatt));
+    }
+    tmp[0] = flags;
+
+    if (st->len + n > st->cap) {
+        return -1;
+    }
+    memcpy(st->wr + st->len, tmp, n);
+    st->len += n;
+    st->count++;
+
+    st->prev_dts = st->count == 1 ? 0 : dts;
+    st->prev_ts = sample->ts;
+    st->prev_temp = sample->temp;
+    st->prev_humi = sample->humi;
+    st->prev_batt = sample->batt;
+    return 0;
+}
+
+void hist_codec_dec_init(struct hist_codec_state *st, const uint8_t *buf, size_t len) {
+    memset(st, 0, sizeof(*st));
+    st->rd = buf;
+    st->cap = len;
+}
+
+int hist_codec_dec_next(struct hist_codec_state *st, struct history_sample *sample) {
+    uint32_t v = 0;
+    uint8_t flags;
+    int32_t dts = st->prev_dts;
+
+    if (st->len >= st->cap) {
+        return 1;
+    }
+    flags = st->rd[st->len++];
+    if (flags & ~(HIST_CODEC_F_TS | HIST_CODEC_F_TEMP | HIST_CODEC_F_HUMI | HIST_CODEC_F_BATT)) {
+        /* 擦除态(0xFF)填充表示数据结束 */
+        return flags == 0xFF ? 1 : -1;
+    }
+
+    if (flags & HIST_CODEC_F_TS) {
+        if (get_varint(st, &v) != 0) {
+            return -1;
+        }
+    }
+    if (st->count == 0) {
+        sample->ts = v;
+        dts = 0;
+    } else {
+        dts += (flags & HIST_CODEC_F_TS) ? unzigzag(v) : 0;
+        sample->ts = st->prev_ts + dts;
+    }
+
+    v = 0;
+    if ((flags & HIST_CODEC_F_TEMP) && get_varint(st, &v) != 0) {
+        return -1;
+    }
+    sample->temp = st->prev_temp + unzigzag(v);
+
+    v = 0;
+    if ((flags & HIST_CODEC_F_HUMI) && get_varint(st, &v) != 0) {
+        return -1;
+    }
+    sample->humi = st->prev_humi + unzigzag(v);
+
+    v = 0;
+    if ((flags & HIST_CODEC_F_BATT) && get_varint(st, &v) != 0) {
+        return -1;
+    }
+    sample->batt = st->prev_batt + unzigzag(v);
+
+    st->count++;
+    st->prev_dts = dts;
+    st->prev_ts = sample->ts;
+    st->prev_temp = sample->temp;
+    st->prev_humi = sample->humi;
+    st->prev_batt = sample->batt;
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "hist_sync.h"
+#include "common.h"
+#include "bulk_xfer.h"
+#include "flash_log.h"
+#include "hist_codec.h"
+#include "history.h"
+#include "rollup.h"
+
+/* 私有函数声明 */
+static int cursor_next(struct history_sample *sample);
+static int sync_notify(const uint8_t *buf, uint16_t len);
+static void sync_task(void *param);
+static void rollup_task(void *param);
+static int start_task(TaskFunction_t fn, const char *name, uint16_t conn_handle,
+                      uint16_t attr_handle);
+
+/* 私有变量 */
+static struct {
+    uint32_t seq;           // 下一条要补发的序号
+    bool seeked;
+    uint32_t block;         // 正在解码的 flash 块
+    uint32_t dec_seq;
+    uint16_t dec_left;
+    struct hist_codec_state dec;
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+} cursor;
+
+static struct {
+    enum rollup_level level;
+    uint32_t since;
+} rollup_req;
+
+/* 补发和聚合下载共用数据特性，同一时间只运行一个发送任务 */
+static uint16_t sync_conn_handle;
+static uint16_t sync_attr_handle;
+static volatile bool sync_running = false;
+
+/* 私有函数 */
+/* 读取序号不小于 cursor.seq 的下一条记录，返回 0；已追上最新记录返回 1 */
+static int cursor_next(struct history_sample *sample) {
+    struct flash_log_block_hdr hdr;
+
+    for (;;) {
+        int rc = history_get_seq(cursor.seq, sample);
+        if (rc == 0) {
+            cursor.seq++;
+            return 0;
+        } else if (rc > 0) {
+            return 1;
+        }
+
+        /* 已不在 RAM 缓冲区中，从 flash 日志读取 */
+        if (cursor.dec_left == 0) {
+            if (!cursor.seeked) {
+                cursor.block = flash_log_seek_seq(cursor.seq);
+                cursor.seeked = true;
+            } else if (cursor.block != FLASH_LOG_BLOCK_NONE) {
+                cursor.block = flash_log_next_block(cursor.block);
+            }
+            if (cursor.block == FLASH_LOG_BLOCK_NONE) {
+                /* flash 中也已不存在，从 RAM 中最旧的记录继续 */
+                cursor.seq = history_first_seq();
+                continue;
+            }
+            if (flash_log_read_raw(cursor.block, &hdr, cursor.payload) != 0) {
+                continue;
+            }
+            hist_codec_dec_init(&cursor.dec, cursor.payload, hdr.len);
+            cursor.dec_seq = hdr.first_seq;
+            cursor.dec_left = hdr.count;
+        }
+
+        if (hist_codec_dec_next(&cursor.dec, sample) != 0) {
+            cursor.dec_left = 0;
+            continue;
+        }
+        sample->seq = cursor.dec_seq++;
+        sample->ts = history_correct_ts(sample->seq, sample->ts);
+        cursor.dec_left--;
+        if ((int32_t)(sample->seq - cursor.seq) >= 0) {
+            cursor.seq = sample->seq + 1;
+            return 0;
+        }
+    }
+}
+
+static int sync_notify(const uint8_t *buf, uint16_t len) {
+    for (;;) {
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(buf, len);
+        int rc;
+
+        if (om == NULL) {
+            /* mbuf 用尽，等待控制器发送完成后再试 */
+            vTaskDelay(1);
+            continue;
+        }
+        rc = ble_gatts_notify_custom(sync_conn_handle, sync_attr_handle, om);
+        if (rc != BLE_HS_ENOMEM) {
+            return rc;
+        }
+        vTaskDelay(1);
+    }
+}
+
+static void sync_task(void *param) {
+    uint8_t buf[BULK_XFER_LL_OCTETS_MAX];
+    struct hist_codec_state enc;
+    struct history_sample sample;
+    bool pending = false;
+    uint32_t first_seq = 0;
+    uint32_t total = 0;
+    uint32_t packets = 0;
+    int rc = 0;
+
+    for (;;) {
+        uint16_t max_len = bulk_xfer_att_payload(sync_conn_handle);
+        if (max_len > sizeof(buf)) {
+            max_len = sizeof(buf);
+        }
+        if (max_len <= HIST_SYNC_HDR_LEN) {
+            rc = BLE_HS_ENOTCONN;
+            break;
+        }
+
+        /* 一个通知只打包序号连续的记录，每个通知可独立解码 */
+        hist_codec_enc_init(&enc, buf + HIST_SYNC_HDR_LEN, max_len - HIST_SYNC_HDR_LEN);
+        while (enc.count < UINT8_MAX) {
+            if (!pending && cursor_next(&sample) != 0) {
+                break;
+            }
+            pending = true;
+            if (enc.count > 0 && sample.seq != first_seq + enc.count) {
+                break;
+            }
+            if (hist_codec_enc_add(&enc, &sample) != 0) {
+                break;
+            }
+            if (enc.count == 1) {
+                first_seq = sample.seq;
+            }
+            pending = false;
+        }
+        if (enc.count == 0) {
+            break;
+        }
+
+        buf[0] = first_seq & 0xFF;
+        buf[1] = (first_seq >> 8) & 0xFF;
+        buf[2] = (first_seq >> 16) & 0xFF;
+        buf[3] = (first_seq >> 24) & 0xFF;
+        buf[4] = enc.count;
+        rc = sync_notify(buf, HIST_SYNC_HDR_LEN + enc.len);
+        if (rc != 0) {
+            break;
+        }
+        total += enc.count;
+        packets++;
+    }
+
+    /* 结束标记: 下一条将要产生的记录的序号 + 0 条；请求的序号超前时网关据此发现设备已复位 */
+    if (rc == 0) {
+        uint32_t next_seq = history_first_seq() + history_count();
+        buf[0] = next_seq & 0xFF;
+        buf[1] = (next_seq >> 8) & 0xFF;
+        buf[2] = (next_seq >> 16) & 0xFF;
+        buf[3] = (next_seq >> 24) & 0xFF;
+        buf[4] = 0;
+        rc = sync_notify(buf, HIST_SYNC_HDR_LEN);
+        packets++;
+    }
+
+    if (rc == 0) {
+        ESP_LOGI(TAG, "历史补发完成：%lu 条记录，%lu 个通知",
+                 (unsigned long)total, (unsigned long)packets);
+    } else {
+        ESP_LOGE(TAG, "历史补发中止，错误码=%d", rc);
+    }
+
+    sync_running = false;
+    vTaskDelete(NULL);
+}
+
+/*
+ * 每个通知: 分辨率(1) + 桶数(1) + 若干 ROLLUP_WIRE_BYTES 记录，桶数为 0 表示结束。
+ * 与补发一样在独立任务中发送，mbuf 用尽时等待而不是中止。
+ */
+static void rollup_task(void *param) {
+    uint8_t buf[BULK_XFER_LL_OCTETS_MAX];
+    struct rollup_bucket bucket;
+    size_t idx = 0;
+    uint32_t total = 0;
+    int rc = 0;
+
+    while (rollup_get(rollup_req.level, idx, &bucket) == 0 && bucket.start < rollup_req.since) {
+        idx++;
+    }
+
+    do {
+        uint16_t max_len = bulk_xfer_att_payload(sync_conn_handle);
+        uint16_t len = 2;
+
+        if (max_len > sizeof(buf)) {
+            max_len = sizeof(buf);
+        }
+        if (max_len < 2 + ROLLUP_WIRE_BYTES) {
+            rc = BLE_HS_ENOTCONN;
+            break;
+        }
+        buf[0] = rollup_req.level;
+        buf[1] = 0;
+        while (len + ROLLUP_WIRE_BYTES <= max_len &&
+               rollup_get(rollup_req.level, idx, &bucket) == 0) {
+            len += rollup_encode(&bucket, buf + len);
+            buf[1]++;
+            idx++;
+        }
+        rc = sync_notify(buf, len);
+        total += buf[1];
+    } while (rc == 0 && buf[1] != 0);
+
+    if (rc == 0) {
+        ESP_LOGI(TAG, "聚合数据发送完成：%lu 个桶", (unsigned long)total);
+    } else {
+        ESP_LOGE(TAG, "发送聚合数据失败，错误码=%d", rc);
+    }
+
+    sync_running = false;
+    vTaskDelete(NULL);
+}
+
+static int start_task(TaskFunction_t fn, const char *name, uint16_t conn_handle,
+                      uint16_t attr_handle) {
+    sync_conn_handle = conn_handle;
+    sync_attr_handle = attr_handle;
+    if (xTaskCreate(fn, name, 3 * 1024, NULL, 4, NULL) != pdPASS) {
+        sync_running = false;
+        return BLE_HS_ENOMEM;
+    }
+    return 0;
+}
+
+/* 公有函数 */
+int hist_sync_start(uint16_t conn_handle, uint16_t attr_handle, uint32_t since_seq) {
+    int rc;
+
+    if (sync_running) {
+        return BLE_HS_EBUSY;
+    }
+    sync_running = true;
+
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.seq = since_seq;
+    cursor.block = FLASH_LOG_BLOCK_NONE;
+
+    rc = start_task(sync_task, "History Sync", conn_handle, attr_handle);
+    if (rc == 0) {
+        ESP_LOGI(TAG, "开始补发历史记录；conn_handle=%d since=%lu", conn_handle,
+                 (unsigned long)since_seq);
+    }
+    return rc;
+}
+
+int hist_sync_rollup_start(uint16_t conn_handle, uint16_t attr_handle,
+                           enum rollup_level level, uint32_t since) {
+    int rc;
+
+    if (level >= ROLLUP_LEVELS) {
+        return BLE_HS_EINVAL;
+    }
+    if (sync_running) {
+        return BLE_HS_EBUSY;
+    }
+    sync_running = true;
+
+    rollup_req.level = level;
+    rollup_req.since = since;
+
+    rc = start_task(rollup_task, "Rollup Sync", conn_handle, attr_handle);
+    if (rc == 0) {
+        ESP_LOGI(TAG, "开始发送聚合数据；conn_handle=%d level=%d since=%lu", conn_handle,
+                 level, (unsigned long)since);
+    }
+    return rc;
+}
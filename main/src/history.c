@@ -0,0 +1,706 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "history.h"
+#include "common.h"
+#include "EnGet.h"
+#include "l2cap_coc.h"
+#include "flash_log.h"
+#include "hist_codec.h"
+#include "rollup.h"
+#include "esp_timer.h"
+#include "timebase.h"
+#include "esp_system.h"
+#include "freertos/semphr.h"
+
+/* 私有类型 */
+/* 一次校时的修正参数，作用于序号小于 end_seq 的记录，见 history_adjust_ts */
+struct ts_adjust {
+    uint32_t end_seq;
+    uint32_t from;
+    uint32_t to;
+    int32_t offset;
+    bool ramp;
+};
+
+/* 私有函数声明 */
+static size_t phys_index(size_t idx);
+static void get_locked(size_t idx, struct history_sample *sample);
+static size_t find_locked(uint32_t ts);
+static int stream_next(struct history_sample *sample);
+static void sdu_truncate(struct os_mbuf *sdu, uint16_t len);
+static int stream_open(const uint8_t *params, uint16_t len, void *arg);
+static int stream_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg);
+static int packed_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg);
+static int flash_open(const uint8_t *params, uint16_t len, void *arg);
+static int flash_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg);
+static int flash_append_block(const struct flash_log_block_hdr *hdr,
+                              const uint8_t *payload, void *arg);
+static int flash_append_corrected(const struct flash_log_block_hdr *hdr,
+                                  const uint8_t *payload, struct os_mbuf *sdu);
+static void flash_close(void *arg);
+static uint32_t adjust_one(uint32_t ts, const struct ts_adjust *adj);
+static bool ts_fix_covers(uint32_t seq);
+static void ts_fix_prune(uint32_t oldest);
+static void ts_fix_load(void);
+static void ts_fix_persist(void);
+
+_Static_assert(L2CAP_COC_MTU >= 6 + FLASH_LOG_PAYLOAD_SIZE,
+               "L2CAP SDU must hold a whole flash log block");
+
+/* flash_append_block 的返回值 */
+#define FLASH_APPEND_OK 0
+#define FLASH_APPEND_FULL 1
+#define FLASH_APPEND_DONE 2
+
+/* 校时修正表，保留到所修正的记录从 flash 日志中擦除为止 */
+#define TS_FIX_NVS_KEY "tsfix"
+#define TS_FIX_MAX 16
+
+/* 私有变量 */
+/*
+ * 列式(结构体数组)存储: 每列连续存放，没有结构体对齐填充，
+ * 每条记录严格占用 HISTORY_SAMPLE_BYTES 字节 DRAM。
+ */
+static uint32_t hist_ts[HISTORY_CAPACITY];
+static int16_t hist_temp[HISTORY_CAPACITY];
+static uint16_t hist_humi[HISTORY_CAPACITY];
+static uint8_t hist_batt[HISTORY_CAPACITY];
+
+static uint32_t hist_first_seq;  // 最旧记录的序号，缓冲区内序号连续
+static size_t hist_head;     // 最旧记录的物理下标
+static size_t hist_count;
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t stream_seq;    // 下一条待发送记录的序号，RAM 环回绕后仍指向同一条记录
+static uint32_t stream_t_to;
+static uint32_t flash_block;
+static uint32_t flash_skip;     // 当前块中已发送的记录条数，修正后的块可能跨 SDU
+static uint16_t flash_sdu_max;
+
+static uint8_t packed_buf[L2CAP_COC_MTU];
+
+/*
+ * flash 日志和暂存块保存记录时的原始时间戳，读出时按此表修正；
+ * RAM 缓冲区在校时时原地修正。按校时先后排列，end_seq 递增。
+ */
+static struct ts_adjust ts_fixes[TS_FIX_MAX];
+static size_t ts_fix_count;
+static SemaphoreHandle_t ts_fix_lock;
+
+static const struct l2cap_coc_source stream_source = {
+    .open = stream_open,
+    .fill = stream_fill,
+};
+
+static const struct l2cap_coc_source packed_source = {
+    .open = stream_open,
+    .fill = packed_fill,
+};
+
+static const struct l2cap_coc_source flash_source = {
+    .open = flash_open,
+    .fill = flash_fill,
+    .close = flash_close,
+};
+
+/* 私有函数 */
+static size_t phys_index(size_t idx) {
+    idx += hist_head;
+    return idx >= HISTORY_CAPACITY ? idx - HISTORY_CAPACITY : idx;
+}
+
+/* 调用方需持有 hist_lock */
+static void get_locked(size_t idx, struct history_sample *sample) {
+    size_t p = phys_index(idx);
+
+    sample->seq = hist_first_seq + idx;
+    sample->ts = hist_ts[p];
+    sample->temp = hist_temp[p];
+    sample->humi = hist_humi[p];
+    sample->batt = hist_batt[p];
+}
+
+/* 调用方需持有 hist_lock */
+static size_t find_locked(uint32_t ts) {
+    size_t lo = 0;
+    size_t hi = hist_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (hist_ts[phys_index(mid)] < ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * 按序号取下一条待发送的记录。传输期间 RAM 环可能回绕，
+ * 已被覆盖的记录无法再发送，从仍保留的最旧记录继续。
+ */
+static int stream_next(struct history_sample *sample) {
+    int rc = history_get_seq(stream_seq, sample);
+
+    if (rc < 0) {
+        uint32_t first = history_first_seq();
+        ESP_LOGW(TAG, "历史流落后于缓冲区，跳过 %lu 条",
+                 (unsigned long)(first - stream_seq));
+        stream_seq = first;
+        rc = history_get_seq(stream_seq, sample);
+    }
+    if (rc != 0 || sample->ts > stream_t_to) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * os_mbuf_append 在 mbuf 池耗尽时可能只追加了一部分，
+ * 截回追加前的长度，保证 SDU 中只有完整的记录/块，接收方的分帧不被破坏。
+ */
+static void sdu_truncate(struct os_mbuf *sdu, uint16_t len) {
+    if (OS_MBUF_PKTLEN(sdu) > len) {
+        os_mbuf_adj(sdu, (int)len - (int)OS_MBUF_PKTLEN(sdu));
+    }
+}
+
+/* 请求参数: 起始时间(4) + 结束时间(4)，小端，缺省为全部 */
+static int stream_open(const uint8_t *params, uint16_t len, void *arg) {
+    uint32_t t_from = 0;
+
+    stream_t_to = UINT32_MAX;
+    if (len >= 4) {
+        t_from = params[0] | (params[1] << 8) | (params[2] << 16) |
+                 ((uint32_t)params[3] << 24);
+    }
+    if (len >= 8) {
+        stream_t_to = params[4] | (params[5] << 8) | (params[6] << 16) |
+                      ((uint32_t)params[7] << 24);
+    }
+    taskENTER_CRITICAL(&hist_lock);
+    stream_seq = hist_first_seq + find_locked(t_from);
+    taskEXIT_CRITICAL(&hist_lock);
+    return 0;
+}
+
+static int stream_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg) {
+    struct history_sample sample;
+    uint8_t buf[HISTORY_WIRE_BYTES];
+
+    while (OS_MBUF_PKTLEN(sdu) + HISTORY_WIRE_BYTES <= max_len) {
+        uint16_t mark = OS_MBUF_PKTLEN(sdu);
+
+        if (stream_next(&sample) != 0) {
+            return BLE_HS_EDONE;
+        }
+        history_encode(&sample, buf);
+        if (os_mbuf_append(sdu, buf, sizeof(buf)) != 0) {
+            sdu_truncate(sdu, mark);
+            break;
+        }
+        stream_seq++;
+    }
+    return 0;
+}
+
+/* 压缩格式 SDU: 记录条数(2，小端) + hist_codec 块，每个 SDU 可独立解码 */
+static int packed_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg) {
+    struct hist_codec_state enc;
+    struct history_sample sample;
+    uint32_t start_seq = stream_seq;
+    int rc = 0;
+
+    if (max_len > sizeof(packed_buf)) {
+        max_len = sizeof(packed_buf);
+    }
+    hist_codec_enc_init(&enc, packed_buf + 2, max_len - 2);
+
+    while (enc.count < UINT16_MAX) {
+        if (stream_next(&sample) != 0) {
+            rc = BLE_HS_EDONE;
+            break;
+        }
+        if (enc.count == 0) {
+            start_seq = stream_seq;
+        }
+        if (hist_codec_enc_add(&enc, &sample) != 0) {
+            break;
+        }
+        stream_seq++;
+    }
+
+    if (enc.count > 0) {
+        uint16_t mark = OS_MBUF_PKTLEN(sdu);
+
+        packed_buf[0] = enc.count & 0xFF;
+        packed_buf[1] = enc.count >> 8;
+        if (os_mbuf_append(sdu, packed_buf, enc.len + 2) != 0) {
+            sdu_truncate(sdu, mark);
+            /* 未能放入 SDU，下次从同一位置重新编码 */
+            stream_seq = start_seq;
+            return 0;
+        }
+    }
+    return rc;
+}
+
+/* 与 0x02 相同的请求参数，按时间索引定位到第一个相关的 flash 块 */
+static int flash_open(const uint8_t *params, uint16_t len, void *arg) {
+    uint32_t t_from = 0;
+    int64_t start = esp_timer_get_time();
+
+    stream_t_to = UINT32_MAX;
+    if (len >= 4) {
+        t_from = params[0] | (params[1] << 8) | (params[2] << 16) |
+                 ((uint32_t)params[3] << 24);
+    }
+    if (len >= 8) {
+        stream_t_to = params[4] | (params[5] << 8) | (params[6] << 16) |
+                      ((uint32_t)params[7] << 24);
+    }
+    if (flash_log_mmap_begin() != ESP_OK) {
+        return -1;
+    }
+    flash_block = flash_log_seek(t_from);
+    flash_skip = 0;
+    ESP_LOGI(TAG, "flash 历史定位: ts=%lu -> 块 %ld，耗时 %ld us",
+             (unsigned long)t_from, (long)flash_block,
+             (long)(esp_timer_get_time() - start));
+    return 0;
+}
+
+/*
+ * 将映射中的块直接追加到 SDU: 块载荷只从 flash cache 复制一次进 mbuf，
+ * 不经过中间缓冲区，整个导出过程的 RAM 占用与历史长度无关。
+ * 含有校时前记录的块须修正时间戳，改为重新编码。
+ */
+static int flash_append_block(const struct flash_log_block_hdr *hdr,
+                              const uint8_t *payload, void *arg) {
+    struct os_mbuf *sdu = arg;
+    uint16_t mark = OS_MBUF_PKTLEN(sdu);
+    uint8_t prefix[6] = {
+        hdr->count,
+        (uint8_t)hdr->len,
+        hdr->first_seq & 0xFF,
+        (hdr->first_seq >> 8) & 0xFF,
+        (hdr->first_seq >> 16) & 0xFF,
+        (hdr->first_seq >> 24) & 0xFF,
+    };
+
+    if (history_correct_ts(hdr->first_seq, hdr->first_ts) > stream_t_to) {
+        return FLASH_APPEND_DONE;
+    }
+    if (ts_fix_covers(hdr->first_seq)) {
+        return flash_append_corrected(hdr, payload, sdu);
+    }
+    if (OS_MBUF_PKTLEN(sdu) + sizeof(prefix) + hdr->len > flash_sdu_max) {
+        return FLASH_APPEND_FULL;
+    }
+    if (os_mbuf_append(sdu, prefix, sizeof(prefix)) != 0 ||
+        os_mbuf_append(sdu, payload, hdr->len) != 0) {
+        sdu_truncate(sdu, mark);
+        return FLASH_APPEND_FULL;
+    }
+    return FLASH_APPEND_OK;
+}
+
+/*
+ * 解码块并修正时间戳，重新编码到 packed_buf(各数据流不会同时进行)。
+ * 修正后的差分可能变长，一个块可拆成若干条目，SDU 放不下时由 flash_skip
+ * 记录已发送的条数，下一个 SDU 从块中同一位置继续；空 SDU 至少能放下一个整块载荷。
+ */
+static int flash_append_corrected(const struct flash_log_block_hdr *hdr,
+                                  const uint8_t *payload, struct os_mbuf *sdu) {
+    struct hist_codec_state dec;
+    struct hist_codec_state enc;
+    struct history_sample sample;
+    uint16_t mark = OS_MBUF_PKTLEN(sdu);
+    uint32_t first_seq = hdr->first_seq + flash_skip;
+    bool full = false;
+    size_t cap;
+
+    if (mark + 6 >= flash_sdu_max) {
+        return FLASH_APPEND_FULL;
+    }
+    cap = flash_sdu_max - mark - 6;
+    if (cap > FLASH_LOG_PAYLOAD_SIZE) {
+        cap = FLASH_LOG_PAYLOAD_SIZE;
+    }
+    hist_codec_dec_init(&dec, payload, hdr->len);
+    hist_codec_enc_init(&enc, packed_buf + 6, cap);
+
+    for (uint32_t i = 0; i < hdr->count && hist_codec_dec_next(&dec, &sample) == 0; i++) {
+        if (i < flash_skip) {
+            continue;
+        }
+        sample.seq = hdr->first_seq + i;
+        sample.ts = history_correct_ts(sample.seq, sample.ts);
+        if (hist_codec_enc_add(&enc, &sample) != 0) {
+            full = true;
+            break;
+        }
+    }
+    if (enc.count == 0) {
+        if (full) {
+            return FLASH_APPEND_FULL;
+        }
+        /* 损坏记录之后的部分无法解码，跳过 */
+        flash_skip = 0;
+        return FLASH_APPEND_OK;
+    }
+
+    packed_buf[0] = enc.count;
+    packed_buf[1] = (uint8_t)enc.len;
+    packed_buf[2] = first_seq & 0xFF;
+    packed_buf[3] = (first_seq >> 8) & 0xFF;
+    packed_buf[4] = (first_seq >> 16) & 0xFF;
+    packed_buf[5] = (first_seq >> 24) & 0xFF;
+    if (os_mbuf_append(sdu, packed_buf, enc.len + 6) != 0) {
+        sdu_truncate(sdu, mark);
+        return FLASH_APPEND_FULL;
+    }
+    flash_skip += enc.count;
+    if (full) {
+        /* 块的其余记录放到下一个 SDU */
+        return FLASH_APPEND_FULL;
+    }
+    flash_skip = 0;
+    return FLASH_APPEND_OK;
+}
+
+/*
+ * 每个 SDU 含若干个完整的 flash 块:
+ *   记录条数(1) + 载荷长度(1) + 首条序号(4，小端) + hist_codec 块。
+ * 首尾块可能含有范围之外的记录，由客户端按时间戳过滤。
+ */
+static int flash_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg) {
+    flash_sdu_max = max_len;
+
+    while (flash_block != FLASH_LOG_BLOCK_NONE) {
+        switch (flash_log_visit_block(flash_block, flash_append_block, sdu)) {
+        case FLASH_APPEND_DONE:
+            return BLE_HS_EDONE;
+        case FLASH_APPEND_FULL:
+            return 0;
+        default:
+            /* 已发送或是掉电残块，继续下一块 */
+            flash_block = flash_log_next_block(flash_block);
+            break;
+        }
+    }
+    return BLE_HS_EDONE;
+}
+
+static void flash_close(void *arg) { flash_log_mmap_end(); }
+
+/* 单条修正，斜率不为负，结果保持单调不减 */
+static uint32_t adjust_one(uint32_t ts, const struct ts_adjust *adj) {
+    int64_t shift = adj->offset;
+
+    if (adj->ramp) {
+        if (ts <= adj->from || adj->to <= adj->from) {
+            return ts;
+        }
+        uint32_t dt = ts < adj->to ? ts - adj->from : adj->to - adj->from;
+        shift = (int64_t)adj->offset * dt / (adj->to - adj->from);
+    }
+    return shift < -(int64_t)ts ? 0 : (uint32_t)(ts + shift);
+}
+
+/* 序号为 seq 的记录是否早于最近一次校时 */
+static bool ts_fix_covers(uint32_t seq) {
+    bool covers;
+
+    xSemaphoreTake(ts_fix_lock, portMAX_DELAY);
+    covers = ts_fix_count > 0 && (int32_t)(seq - ts_fixes[ts_fix_count - 1].end_seq) < 0;
+    xSemaphoreGive(ts_fix_lock);
+    return covers;
+}
+
+/* 丢弃只作用于 oldest 之前记录的修正，调用方需持有 ts_fix_lock */
+static void ts_fix_prune(uint32_t oldest) {
+    size_t n = 0;
+
+    while (n < ts_fix_count && (int32_t)(ts_fixes[n].end_seq - oldest) <= 0) {
+        n++;
+    }
+    memmove(ts_fixes, ts_fixes + n, (ts_fix_count - n) * sizeof(ts_fixes[0]));
+    ts_fix_count -= n;
+}
+
+static void ts_fix_load(void) {
+    nvs_handle_t handle;
+    size_t len = sizeof(ts_fixes);
+
+    if (nvs_open(HISTORY_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_get_blob(handle, TS_FIX_NVS_KEY, ts_fixes, &len) == ESP_OK) {
+        if (len % sizeof(ts_fixes[0]) != 0) {
+            ESP_LOGW(TAG, "校时修正表长度 %u 无效，已丢弃", (unsigned)len);
+        } else {
+            ts_fix_count = len / sizeof(ts_fixes[0]);
+        }
+    }
+    nvs_close(handle);
+}
+
+/* 调用方需持有 ts_fix_lock；每次校时写一次 NVS */
+static void ts_fix_persist(void) {
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(HISTORY_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "打开校时修正 NVS 失败: %d", err);
+        return;
+    }
+    err = nvs_set_blob(handle, TS_FIX_NVS_KEY, ts_fixes, ts_fix_count * sizeof(ts_fixes[0]));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "保存校时修正失败: %d", err);
+    }
+}
+
+/* 公有函数 */
+void history_init(void) {
+    uint32_t time_base;
+
+    /* 先装入修正表，日志中最后的时间戳按修正后的值接续 */
+    ts_fix_lock = xSemaphoreCreateMutex();
+    ts_fix_load();
+    flash_log_set_correct(history_correct_ts);
+
+    /* 尚未落盘的暂存记录在重启时丢失，留出一秒余量保证单调 */
+    time_base = flash_log_last_ts();
+    if (time_base != 0) {
+        time_base++;
+    }
+    timebase_init(time_base);
+
+    /*
+     * 软件复位后暂存记录已由 flash_log_init 写出，从 end_seq 接续；
+     * 进入深睡眠前总会先写出暂存记录，唤醒后同样无缺口。
+     * 只有掉电丢失的暂存记录可能已经通过指示发布过，这时序号跳过整个暂存批次，
+     * 避免同一序号对应两条不同的记录；网关会看到一个无法补取的缺口。
+     */
+    hist_first_seq = flash_log_end_seq();
+    if (hist_first_seq != 0 && !flash_log_stage_intact() &&
+        esp_reset_reason() != ESP_RST_DEEPSLEEP) {
+        hist_first_seq += CONFIG_FLASH_LOG_BATCH;
+    }
+    ESP_LOGI(TAG, "历史时间基准: %lu，起始序号: %lu，校时修正 %u 条", (unsigned long)time_base,
+             (unsigned long)hist_first_seq, (unsigned)ts_fix_count);
+}
+
+uint32_t history_now(void) { return timebase_now(); }
+
+void history_adjust_ts(uint32_t from, uint32_t to, int32_t offset, bool ramp) {
+    struct ts_adjust adj = {.from = from, .to = to, .offset = offset, .ramp = ramp};
+    uint32_t first;
+    uint32_t count;
+    uint32_t oldest;
+
+    /* 回拨量大于区间长度时线性修正会乱序，限制斜率不为负 */
+    if (ramp && to > from && (int64_t)offset < -(int64_t)(to - from)) {
+        adj.offset = -(int32_t)(to - from);
+    }
+
+    taskENTER_CRITICAL(&hist_lock);
+    first = hist_first_seq;
+    count = hist_count;
+    taskEXIT_CRITICAL(&hist_lock);
+    adj.end_seq = first + count;
+
+    /* 保留到所修正的记录在 flash 日志和 RAM 中都不存在为止 */
+    oldest = flash_log_first_seq();
+    if ((int32_t)(first - oldest) < 0) {
+        oldest = first;
+    }
+    xSemaphoreTake(ts_fix_lock, portMAX_DELAY);
+    ts_fix_prune(oldest);
+    if (ts_fix_count == TS_FIX_MAX) {
+        ESP_LOGW(TAG, "校时修正表已满，丢弃最旧的一条");
+        ts_fix_prune(ts_fixes[0].end_seq);
+    }
+    ts_fixes[ts_fix_count++] = adj;
+    ts_fix_persist();
+    xSemaphoreGive(ts_fix_lock);
+
+    /*
+     * RAM 中的记录原地修正。每条记录只在读写时进入临界区，64 位运算在临界区外；
+     * 向后修正从新到旧、向前修正从旧到新，缓冲区始终按时间排序。
+     */
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq = adj.offset > 0 ? adj.end_seq - 1 - i : first + i;
+        uint32_t off;
+        uint32_t ts = 0;
+        bool present;
+
+        taskENTER_CRITICAL(&hist_lock);
+        off = seq - hist_first_seq;
+        present = (int32_t)off >= 0 && off < hist_count;
+        if (present) {
+            ts = hist_ts[phys_index(off)];
+        }
+        taskEXIT_CRITICAL(&hist_lock);
+        if (!present) {
+            /* 已被覆盖 */
+            continue;
+        }
+
+        ts = adjust_one(ts, &adj);
+
+        taskENTER_CRITICAL(&hist_lock);
+        off = seq - hist_first_seq;
+        if ((int32_t)off >= 0 && off < hist_count) {
+            hist_ts[phys_index(off)] = ts;
+        }
+        taskEXIT_CRITICAL(&hist_lock);
+    }
+}
+
+uint32_t history_correct_ts(uint32_t seq, uint32_t ts) {
+    xSemaphoreTake(ts_fix_lock, portMAX_DELAY);
+    for (size_t i = 0; i < ts_fix_count; i++) {
+        if ((int32_t)(seq - ts_fixes[i].end_seq) < 0) {
+            ts = adjust_one(ts, &ts_fixes[i]);
+        }
+    }
+    xSemaphoreGive(ts_fix_lock);
+    return ts;
+}
+
+uint32_t history_append(uint32_t ts, int16_t temp, uint16_t humi, uint8_t batt) {
+    uint32_t seq;
+    size_t idx;
+
+    taskENTER_CRITICAL(&hist_lock);
+    if (hist_count < HISTORY_CAPACITY) {
+        idx = phys_index(hist_count);
+        hist_count++;
+    } else {
+        /* 已满，覆盖最旧的记录 */
+        idx = hist_head;
+        hist_head = phys_index(1);
+        hist_first_seq++;
+    }
+    hist_ts[idx] = ts;
+    hist_temp[idx] = temp;
+    hist_humi[idx] = humi;
+    hist_batt[idx] = batt;
+    seq = hist_first_seq + hist_count - 1;
+    taskEXIT_CRITICAL(&hist_lock);
+    return seq;
+}
+
+void history_record(void) {
+    float percentage = GetBatteryPercentage();
+    struct history_sample sample = {
+        .ts = history_now(),
+        .temp = (int16_t)(GetTemp() * 100),
+        .humi = (uint16_t)(GetHumi() * 100),
+        .batt = percentage < 0 ? 0 : percentage > 100 ? 100 : (uint8_t)percentage,
+    };
+
+    sample.seq = history_append(sample.ts, sample.temp, sample.humi, sample.batt);
+
+    /* 同时写入 flash 日志，重启后仍可取回 */
+    flash_log_append(&sample);
+    rollup_add(&sample);
+}
+
+size_t history_count(void) { return hist_count; }
+
+size_t history_find(uint32_t ts) {
+    size_t idx;
+
+    taskENTER_CRITICAL(&hist_lock);
+    idx = find_locked(ts);
+    taskEXIT_CRITICAL(&hist_lock);
+    return idx;
+}
+
+int history_get(size_t idx, struct history_sample *sample) {
+    int rc = -1;
+
+    taskENTER_CRITICAL(&hist_lock);
+    if (idx < hist_count) {
+        get_locked(idx, sample);
+        rc = 0;
+    }
+    taskEXIT_CRITICAL(&hist_lock);
+    return rc;
+}
+
+int history_get_seq(uint32_t seq, struct history_sample *sample) {
+    uint32_t offset;
+    int rc = 0;
+
+    taskENTER_CRITICAL(&hist_lock);
+    offset = seq - hist_first_seq;
+    if ((int32_t)offset < 0) {
+        rc = -1;
+    } else if (offset >= hist_count) {
+        rc = 1;
+    } else {
+        get_locked(offset, sample);
+    }
+    taskEXIT_CRITICAL(&hist_lock);
+    return rc;
+}
+
+int history_latest(struct history_sample *sample) {
+    size_t count = hist_count;
+
+    return count == 0 ? -1 : history_get(count - 1, sample);
+}
+
+uint32_t history_first_seq(void) { return hist_first_seq; }
+
+size_t history_read_range(uint32_t t_from, uint32_t t_to,
+                          struct history_sample *out, size_t max) {
+    size_t idx = history_find(t_from);
+    size_t n = 0;
+
+    while (n < max && history_get(idx + n, &out[n]) == 0 && out[n].ts <= t_to) {
+        n++;
+    }
+    return n;
+}
+
+size_t history_encode(const struct history_sample *sample, uint8_t *buf) {
+    buf[0] = sample->ts & 0xFF;
+    buf[1] = (sample->ts >> 8) & 0xFF;
+    buf[2] = (sample->ts >> 16) & 0xFF;
+    buf[3] = (sample->ts >> 24) & 0xFF;
+    buf[4] = sample->temp & 0xFF;
+    buf[5] = (sample->temp >> 8) & 0xFF;
+    buf[6] = sample->humi & 0xFF;
+    buf[7] = (sample->humi >> 8) & 0xFF;
+    buf[8] = sample->batt;
+    return HISTORY_WIRE_BYTES;
+}
+
+int history_stream_init(void) {
+    ESP_LOGI(TAG, "历史缓冲区: %d 条，%d 字节", HISTORY_CAPACITY,
+             HISTORY_CAPACITY * HISTORY_SAMPLE_BYTES);
+    int rc = l2cap_coc_register_source(L2CAP_COC_REQ_HISTORY, &stream_source);
+    if (rc != 0) {
+        return rc;
+    }
+    rc = l2cap_coc_register_source(L2CAP_COC_REQ_HISTORY_PACKED, &packed_source);
+    if (rc != 0) {
+        return rc;
+    }
+    return l2cap_coc_register_source(L2CAP_COC_REQ_HISTORY_FLASH, &flash_source);
+}
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "i2c_bus.h"
+#include "common.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+/* Private types */
+struct bus_request {
+    i2c_master_dev_handle_t dev;    // NULL 表示探测 probe_addr
+    uint8_t probe_addr;
+    const struct i2c_bus_op *ops;
+    size_t count;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+};
+
+/* Private function declarations */
+static esp_err_t run_op(i2c_master_dev_handle_t dev, const struct i2c_bus_op *op);
+static esp_err_t run_request(struct bus_request *req);
+static void bus_task(void *param);
+static esp_err_t submit(struct bus_request *req);
+
+/* Private variables */
+static i2c_master_bus_handle_t bus;
+static QueueHandle_t bus_queue;
+static struct i2c_bus_stats stats;
+
+/* Private functions */
+static esp_err_t run_op(i2c_master_dev_handle_t dev, const struct i2c_bus_op *op) {
+    if (op->tx_len > 0 && op->rx_len > 0) {
+        return i2c_master_transmit_receive(dev, op->tx, op->tx_len, op->rx, op->rx_len,
+                                           CONFIG_I2C_BUS_TIMEOUT_MS);
+    } else if (op->tx_len > 0) {
+        return i2c_master_transmit(dev, op->tx, op->tx_len, CONFIG_I2C_BUS_TIMEOUT_MS);
+    }
+    return i2c_master_receive(dev, op->rx, op->rx_len, CONFIG_I2C_BUS_TIMEOUT_MS);
+}
+
+static esp_err_t run_request(struct bus_request *req) {
+    esp_err_t rc = ESP_OK;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (req->dev == NULL) {
+            rc = i2c_master_probe(bus, req->probe_addr, CONFIG_I2C_BUS_TIMEOUT_MS);
+        } else {
+            for (size_t i = 0; i < req->count && rc == ESP_OK; i++) {
+                rc = run_op(req->dev, &req->ops[i]);
+            }
+        }
+
+        /* NACK 等错误直接返回；超时说明从机拉住了 SDA，复位总线后整组重试 */
+        if (rc != ESP_ERR_TIMEOUT || attempt > 0) {
+            break;
+        }
+        stats.recoveries++;
+        ESP_LOGW(TAG, "I2C 总线超时，复位总线");
+        if (i2c_master_bus_reset(bus) != ESP_OK) {
+            break;
+        }
+        rc = ESP_OK;
+    }
+    return rc;
+}
+
+static void bus_task(void *param) {
+    struct bus_request *req;
+
+    while (1) {
+        xQueueReceive(bus_queue, &req, portMAX_DELAY);
+
+        /* 一次唤醒内执行完已排队的全部请求 */
+        do {
+            req->result = run_request(req);
+            stats.transactions++;
+            if (req->result != ESP_OK) {
+                stats.errors++;
+            }
+            xSemaphoreGive(req->done);
+            if (xQueueReceive(bus_queue, &req, 0) != pdTRUE) {
+                break;
+            }
+            stats.batched++;
+        } while (1);
+    }
+}
+
+static esp_err_t submit(struct bus_request *req) {
+    if (bus_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    req->done = xSemaphoreCreateBinaryStatic(&req->done_buf);
+    if (xQueueSend(bus_queue, &req, portMAX_DELAY) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreTake(req->done, portMAX_DELAY);
+    vSemaphoreDelete(req->done);
+    return req->result;
+}
+
+/* Public functions */
+esp_err_t i2c_bus_init(void) {
+    i2c_master_bus_config_t conf = {
+        .i2c_port = I2C_NUM_0,
+        .sda_io_num = CONFIG_I2C_BUS_SDA_GPIO,
+        .scl_io_num = CONFIG_I2C_BUS_SCL_GPIO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    esp_err_t rc;
+
+    rc = i2c_new_master_bus(&conf, &bus);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    bus_queue = xQueueCreate(I2C_BUS_QUEUE_LEN, sizeof(struct bus_request *));
+    if (bus_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* 优先级高于采样任务，请求的排队延迟不超过前面请求的执行时间 */
+    if (xTaskCreate(bus_task, "I2C Bus", 2 * 1024, NULL, 6, NULL) != pdPASS) {
+        vQueueDelete(bus_queue);
+        bus_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(uint8_t addr, uint32_t scl_hz, i2c_master_dev_handle_t *dev) {
+    i2c_device_config_t conf = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = addr,
+        .scl_speed_hz = scl_hz > I2C_BUS_MAX_HZ ? I2C_BUS_MAX_HZ : scl_hz,
+    };
+
+    return i2c_master_bus_add_device(bus, &conf, dev);
+}
+
+esp_err_t i2c_bus_remove_device(i2c_master_dev_handle_t dev) {
+    return i2c_master_bus_rm_device(dev);
+}
+
+esp_err_t i2c_bus_transfer(i2c_master_dev_handle_t dev, const struct i2c_bus_op *ops,
+                           size_t count) {
+    struct bus_request req = {
+        .dev = dev,
+        .ops = ops,
+        .count = count,
+    };
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return submit(&req);
+}
+
+esp_err_t i2c_bus_write(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t len) {
+    struct i2c_bus_op op = {.tx = tx, .tx_len = len};
+
+    return i2c_bus_transfer(dev, &op, 1);
+}
+
+esp_err_t i2c_bus_read(i2c_master_dev_handle_t dev, uint8_t *rx, size_t len) {
+    struct i2c_bus_op op = {.rx = rx, .rx_len = len};
+
+    return i2c_bus_transfer(dev, &op, 1);
+}
+
+esp_err_t i2c_bus_write_read(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len,
+                             uint8_t *rx, size_t rx_len) {
+    struct i2c_bus_op op = {.tx = tx, .tx_len = tx_len, .rx = rx, .rx_len = rx_len};
+
+    return i2c_bus_transfer(dev, &op, 1);
+}
+
+esp_err_t i2c_bus_probe(uint8_t addr) {
+    struct bus_request req = {
+        .probe_addr = addr,
+    };
+
+    return submit(&req);
+}
+
+void i2c_bus_get_stats(struct i2c_bus_stats *out) { *out = stats; }
@@ -0,0 +1,275 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "l2cap_coc.h"
+#include "bulk_xfer.h"
+#include "common.h"
+#include "freertos/semphr.h"
+
+/* 私有函数声明 */
+static int coc_event_handler(struct ble_l2cap_event *event, void *arg);
+static int coc_rx_ready(struct ble_l2cap_chan *chan);
+static void coc_handle_request(struct ble_l2cap_chan *chan, struct os_mbuf *sdu);
+static void stream_task(void *param);
+static int bench_open(const uint8_t *params, uint16_t len, void *arg);
+static int bench_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg);
+
+/* 私有变量 */
+static struct l2cap_coc_source sources[L2CAP_COC_MAX_SOURCES];
+static uint8_t source_reqs[L2CAP_COC_MAX_SOURCES];
+static uint8_t source_count;
+
+static struct ble_l2cap_chan *coc_chan;
+static uint16_t coc_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static const struct l2cap_coc_source *stream_src;
+static volatile bool stream_running = false;
+static SemaphoreHandle_t tx_unstalled;
+
+static uint32_t bench_remaining;
+
+static const struct l2cap_coc_source bench_source = {
+    .open = bench_open,
+    .fill = bench_fill,
+};
+
+/* 私有函数 */
+static int coc_rx_ready(struct ble_l2cap_chan *chan) {
+    struct os_mbuf *sdu_rx = os_msys_get_pkthdr(L2CAP_COC_MTU, 0);
+
+    if (sdu_rx == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+    return ble_l2cap_recv_ready(chan, sdu_rx);
+}
+
+static void coc_handle_request(struct ble_l2cap_chan *chan, struct os_mbuf *sdu) {
+    uint8_t buf[16];
+    uint16_t len = 0;
+    int i;
+
+    if (ble_hs_mbuf_to_flat(sdu, buf, sizeof(buf), &len) != 0 || len < 1) {
+        return;
+    }
+
+    if (stream_running) {
+        ESP_LOGW(TAG, "L2CAP 数据流正在进行，忽略请求 0x%02x", buf[0]);
+        return;
+    }
+
+    for (i = 0; i < source_count; i++) {
+        if (source_reqs[i] == buf[0]) {
+            break;
+        }
+    }
+    if (i == source_count) {
+        ESP_LOGW(TAG, "未知的 L2CAP 请求 0x%02x", buf[0]);
+        return;
+    }
+
+    if (sources[i].open != NULL &&
+        sources[i].open(buf + 1, len - 1, sources[i].arg) != 0) {
+        return;
+    }
+
+    stream_src = &sources[i];
+    stream_running = true;
+    if (xTaskCreate(stream_task, "L2CAP Stream", 3 * 1024, chan, 4, NULL) !=
+        pdPASS) {
+        if (stream_src->close != NULL) {
+            stream_src->close(stream_src->arg);
+        }
+        stream_running = false;
+    }
+}
+
+static int coc_event_handler(struct ble_l2cap_event *event, void *arg) {
+    struct ble_l2cap_chan_info info;
+
+    switch (event->type) {
+    /* 对端请求建立通道，提供接收缓冲区(同时发放信用) */
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        ESP_LOGI(TAG, "L2CAP 通道请求；conn_handle=%d peer_sdu_size=%d",
+                 event->accept.conn_handle, event->accept.peer_sdu_size);
+        return coc_rx_ready(event->accept.chan);
+
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        if (event->connect.status != 0) {
+            ESP_LOGE(TAG, "L2CAP 通道建立失败；状态=%d", event->connect.status);
+            return 0;
+        }
+        coc_chan = event->connect.chan;
+        coc_conn_handle = event->connect.conn_handle;
+        ble_l2cap_get_chan_info(coc_chan, &info);
+        ESP_LOGI(TAG, "L2CAP 通道已建立；conn_handle=%d psm=0x%02x "
+                 "our_mtu=%d peer_mtu=%d",
+                 coc_conn_handle, info.psm, info.our_coc_mtu, info.peer_coc_mtu);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        ESP_LOGI(TAG, "L2CAP 通道已断开；conn_handle=%d",
+                 event->disconnect.conn_handle);
+        coc_chan = NULL;
+        coc_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        xSemaphoreGive(tx_unstalled);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        if (event->receive.sdu_rx != NULL) {
+            coc_handle_request(event->receive.chan, event->receive.sdu_rx);
+            os_mbuf_free_chain(event->receive.sdu_rx);
+        }
+        return coc_rx_ready(event->receive.chan);
+
+    /* 对端发放了新的信用，继续发送 */
+    case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+        xSemaphoreGive(tx_unstalled);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+static void stream_task(void *param) {
+    struct ble_l2cap_chan *chan = param;
+    uint16_t conn_handle = coc_conn_handle;
+    struct ble_l2cap_chan_info info;
+    uint32_t total = 0;
+    uint32_t rate;
+    uint16_t sdu_len;
+    int rc = 0;
+
+    ble_l2cap_get_chan_info(chan, &info);
+    sdu_len = info.peer_coc_mtu < L2CAP_COC_MTU ? info.peer_coc_mtu : L2CAP_COC_MTU;
+
+    bulk_xfer_begin(conn_handle);
+    vTaskDelay(pdMS_TO_TICKS(300));
+    xSemaphoreTake(tx_unstalled, 0);
+
+    while (rc != BLE_HS_EDONE && coc_chan == chan) {
+        struct os_mbuf *sdu = os_msys_get_pkthdr(sdu_len, 0);
+        if (sdu == NULL) {
+            vTaskDelay(1);
+            continue;
+        }
+
+        rc = stream_src->fill(sdu, sdu_len, stream_src->arg);
+        uint16_t len = OS_MBUF_PKTLEN(sdu);
+        if (len == 0) {
+            os_mbuf_free_chain(sdu);
+            if (rc == 0) {
+                /* 数据源暂时没有数据 */
+                vTaskDelay(1);
+            }
+            continue;
+        }
+
+        int send_rc;
+        do {
+            send_rc = ble_l2cap_send(chan, sdu);
+            if (send_rc == BLE_HS_EBUSY) {
+                /* 上一个 SDU 仍在发送，sdu 未被接管 */
+                xSemaphoreTake(tx_unstalled, pdMS_TO_TICKS(100));
+            }
+        } while (send_rc == BLE_HS_EBUSY && coc_chan == chan);
+
+        if (send_rc == 0 || send_rc == BLE_HS_ESTALLED) {
+            bulk_xfer_account(len);
+            total += len;
+        } else {
+            /*
+             * 仅 EBUSY（通道已断开）和 EBADDATA 时 SDU 未被协议栈接管；
+             * 其他错误（ENOMEM、ENOTCONN、底层发送失败）协议栈已释放
+             */
+            if (send_rc == BLE_HS_EBUSY || send_rc == BLE_HS_EBADDATA) {
+                os_mbuf_free_chain(sdu);
+            }
+            ESP_LOGE(TAG, "L2CAP 发送失败，错误码=%d", send_rc);
+            break;
+        }
+
+        /* 信用用尽，等待对端发放新的信用 */
+        if (send_rc == BLE_HS_ESTALLED) {
+            xSemaphoreTake(tx_unstalled, portMAX_DELAY);
+        }
+    }
+
+    if (stream_src->close != NULL) {
+        stream_src->close(stream_src->arg);
+    }
+
+    rate = bulk_xfer_end(conn_handle);
+    ESP_LOGI(TAG, "L2CAP CoC 吞吐量：%lu 字节，%lu 字节/秒 (GATT 通知：%lu 字节/秒)",
+             (unsigned long)total, (unsigned long)rate,
+             (unsigned long)bulk_xfer_gatt_rate());
+
+    stream_running = false;
+    vTaskDelete(NULL);
+}
+
+static int bench_open(const uint8_t *params, uint16_t len, void *arg) {
+    bench_remaining = BULK_XFER_BENCH_DEFAULT_LEN;
+    if (len >= 4) {
+        bench_remaining = params[0] | (params[1] << 8) | (params[2] << 16) |
+                          ((uint32_t)params[3] << 24);
+    }
+    return 0;
+}
+
+static int bench_fill(struct os_mbuf *sdu, uint16_t max_len, void *arg) {
+    static const uint8_t pattern[64] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    uint16_t len = bench_remaining < max_len ? bench_remaining : max_len;
+
+    while (len > 0) {
+        uint16_t n = len < sizeof(pattern) ? len : sizeof(pattern);
+        if (os_mbuf_append(sdu, pattern, n) != 0) {
+            break;
+        }
+        len -= n;
+        bench_remaining -= n;
+    }
+    return bench_remaining == 0 ? BLE_HS_EDONE : 0;
+}
+
+/* 公有函数 */
+int l2cap_coc_register_source(uint8_t req,
+                              const struct l2cap_coc_source *src) {
+    if (source_count >= L2CAP_COC_MAX_SOURCES) {
+        return BLE_HS_ENOMEM;
+    }
+    source_reqs[source_count] = req;
+    sources[source_count] = *src;
+    source_count++;
+    return 0;
+}
+
+int l2cap_coc_init(void) {
+    int rc;
+
+    tx_unstalled = xSemaphoreCreateBinary();
+    if (tx_unstalled == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = l2cap_coc_register_source(L2CAP_COC_REQ_BENCHMARK, &bench_source);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_l2cap_create_server(L2CAP_COC_PSM, L2CAP_COC_MTU,
+                                 coc_event_handler, NULL);
+    if (rc != 0) {
+        ESP_LOGE(TAG, "创建 L2CAP 服务端失败，错误码: %d", rc);
+        return rc;
+    }
+
+    ESP_LOGI(TAG, "L2CAP CoC 服务端已注册；psm=0x%02x mtu=%d",
+             L2CAP_COC_PSM, L2CAP_COC_MTU);
+    return 0;
+}
@@ -7,35 +7,99 @@
 #include "led.h"
 #include "common.h"
 
+#if CONFIG_BLINK_LED_GPIO
+#include "driver/ledc.h"
+#include "esp_sleep.h"
+#endif
+
+/* Defines */
+#if CONFIG_BLINK_LED_GPIO
+#define LED_LEDC_MODE LEDC_LOW_SPEED_MODE
+#define LED_LEDC_TIMER LEDC_TIMER_0
+#define LED_LEDC_CHANNEL LEDC_CHANNEL_0
+#define LED_LEDC_RES_BITS 14
+#define LED_LEDC_DUTY_MAX ((1 << LED_LEDC_RES_BITS) - 1)
+#define LED_STEADY_FREQ_HZ 1000 // 常亮图案的 PWM 频率，人眼不可见闪烁
+#define LED_FADE_MS 500
+/* 只有自动 light sleep 才需要在睡眠中保持 RC_FAST；深度睡眠时 LEDC 本就停止 */
+#define LED_HOLD_RC_FAST                                                       \
+    (CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE &&                 \
+     !CONFIG_RTC_DEEP_SLEEP)
+#endif
+
+/* Private types */
+/*
+ * 闪烁图案直接用 LEDC 的低频 PWM 实现：一个 PWM 周期就是一次闪烁，占空比
+ * 决定点亮时长；常亮图案使用高频 PWM 调光，并通过硬件渐变切入。
+ * 灯带上的 LED 会锁存最后写入的颜色，因此用颜色区分状态即可。
+ */
+struct led_pattern_def {
+    uint16_t freq_hz;
+    uint16_t duty_permille;
+    uint8_t rgb[3];
+};
+
 /* Private variables */
 static uint8_t led_state;
+static enum led_pattern led_pattern = LED_PATTERN_MAX;
+
+static const struct led_pattern_def patterns[LED_PATTERN_MAX] = {
+    [LED_PATTERN_OFF] = {1000, 0, {0, 0, 0}},
+    [LED_PATTERN_ON] = {1000, 1000, {16, 16, 16}},
+    /* 每 0.5 秒短闪 10ms */
+    [LED_PATTERN_ADVERTISING] = {2, 20, {0, 0, 16}},
+    /* 低亮度常亮 */
+    [LED_PATTERN_CONNECTED] = {1000, 50, {0, 16, 0}},
+    /* 每 0.5 秒亮 125ms */
+    [LED_PATTERN_LOW_BATTERY] = {2, 250, {16, 6, 0}},
+    /* 8Hz 快闪 */
+    [LED_PATTERN_SENSOR_ERROR] = {8, 500, {16, 0, 0}},
+};
 
 #ifdef CONFIG_BLINK_LED_STRIP
 static led_strip_handle_t led_strip;
+#elif CONFIG_BLINK_LED_GPIO
+static uint32_t ledc_freq_hz = LED_STEADY_FREQ_HZ;
+#if LED_HOLD_RC_FAST
+static bool rc_fast_held;
 #endif
+#endif
+
+/* Private function declarations */
+static void led_apply(const struct led_pattern_def *p);
 
 /* Public functions */
 uint8_t get_led_state(void) { return led_state; }
 
+enum led_pattern led_get_pattern(void) { return led_pattern; }
+
+void led_set_pattern(enum led_pattern pattern) {
+    if (pattern >= LED_PATTERN_MAX || pattern == led_pattern) {
+        return;
+    }
+    led_pattern = pattern;
+    led_apply(&patterns[pattern]);
+    led_state = patterns[pattern].duty_permille != 0;
+}
+
+void led_on(void) { led_set_pattern(LED_PATTERN_ON); }
+
+void led_off(void) { led_set_pattern(LED_PATTERN_OFF); }
+
 #ifdef CONFIG_BLINK_LED_STRIP
 
-void led_on(void) {
+static void led_apply(const struct led_pattern_def *p) {
+    if (p->duty_permille == 0) {
+        /* Set all LED off to clear all pixels */
+        led_strip_clear(led_strip);
+        return;
+    }
+
     /* Set the LED pixel using RGB from 0 (0%) to 255 (100%) for each color */
-    led_strip_set_pixel(led_strip, 0, 16, 16, 16);
+    led_strip_set_pixel(led_strip, 0, p->rgb[0], p->rgb[1], p->rgb[2]);
 
     /* Refresh the strip to send data */
     led_strip_refresh(led_strip);
-
-    /* Update LED state */
-    led_state = true;
-}
-
-void led_off(void) {
-    /* Set all LED off to clear all pixels */
-    led_strip_clear(led_strip);
-
-    /* Update LED state */
-    led_state = false;
 }
 
 void led_init(void) {
@@ -68,15 +132,97 @@ void led_init(void) {
 
 #elif CONFIG_BLINK_LED_GPIO
 
-void led_on(void) { gpio_set_level(CONFIG_BLINK_GPIO, true); }
+#if LED_HOLD_RC_FAST
+/*
+ * esp_sleep_pd_config 对域做引用计数：ON 增加引用，OFF 释放引用，
+ * 释放后再设回 AUTO，交还给睡眠代码按需决定
+ */
+static void led_hold_rc_fast(bool hold) {
+    if (hold == rc_fast_held) {
+        return;
+    }
+    if (hold) {
+        ESP_ERROR_CHECK(esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_ON));
+    } else {
+        ESP_ERROR_CHECK(esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_OFF));
+        ESP_ERROR_CHECK(esp_sleep_pd_config(ESP_PD_DOMAIN_RC_FAST, ESP_PD_OPTION_AUTO));
+    }
+    rc_fast_held = hold;
+}
+#endif
+
+/*
+ * 直接写占空比，新值在下一个 PWM 周期生效。ledc_set_duty_and_update
+ * 会等到生效为止，2Hz 图案下最长阻塞 500ms，而调用者是采样任务
+ */
+static void led_write_duty(uint32_t duty) {
+    ledc_fade_stop(LED_LEDC_MODE, LED_LEDC_CHANNEL);
+    ledc_set_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL, duty);
+    ledc_update_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL);
+}
+
+static void led_apply(const struct led_pattern_def *p) {
+    uint32_t duty = (uint32_t)p->duty_permille * LED_LEDC_DUTY_MAX / 1000;
+    bool fade = p->freq_hz >= LED_STEADY_FREQ_HZ;
+
+#if LED_HOLD_RC_FAST
+    /*
+     * 熄灭后不再需要时钟，放开 RC_FAST 让 light sleep 可以关掉它；
+     * 渐变会在睡眠中停在半途，所以熄灭时直接写 0
+     */
+    if (p->duty_permille != 0) {
+        led_hold_rc_fast(true);
+    } else {
+        fade = false;
+    }
+#endif
 
-void led_off(void) { gpio_set_level(CONFIG_BLINK_GPIO, false); }
+    /* 改变频率前先熄灭，避免新旧周期拼接出一次异常长的闪烁 */
+    if (p->freq_hz != ledc_freq_hz) {
+        led_write_duty(0);
+        ESP_ERROR_CHECK(ledc_set_freq(LED_LEDC_MODE, LED_LEDC_TIMER, p->freq_hz));
+        ledc_freq_hz = p->freq_hz;
+    }
+
+    if (fade) {
+        /* 常亮亮度由硬件渐变过去，调用立即返回 */
+        ledc_set_fade_time_and_start(LED_LEDC_MODE, LED_LEDC_CHANNEL, duty,
+                                     LED_FADE_MS, LEDC_FADE_NO_WAIT);
+    } else {
+        led_write_duty(duty);
+    }
+
+#if LED_HOLD_RC_FAST
+    if (p->duty_permille == 0) {
+        led_hold_rc_fast(false);
+    }
+#endif
+}
 
 void led_init(void) {
     ESP_LOGI(TAG, "example configured to blink gpio led!");
-    gpio_reset_pin(CONFIG_BLINK_GPIO);
-    /* Set the GPIO as a push/pull output */
-    gpio_set_direction(CONFIG_BLINK_GPIO, GPIO_MODE_OUTPUT);
+
+    /* RC_FAST 时钟可在 light sleep 中保持运行，图案不因 CPU 睡眠而停止 */
+    ledc_timer_config_t timer_config = {
+        .speed_mode = LED_LEDC_MODE,
+        .duty_resolution = LED_LEDC_RES_BITS,
+        .timer_num = LED_LEDC_TIMER,
+        .freq_hz = LED_STEADY_FREQ_HZ,
+        .clk_cfg = LEDC_USE_RC_FAST_CLK,
+    };
+    ESP_ERROR_CHECK(ledc_timer_config(&timer_config));
+
+    ledc_channel_config_t channel_config = {
+        .gpio_num = CONFIG_BLINK_GPIO,
+        .speed_mode = LED_LEDC_MODE,
+        .channel = LED_LEDC_CHANNEL,
+        .timer_sel = LED_LEDC_TIMER,
+        .duty = 0,
+    };
+    ESP_ERROR_CHECK(ledc_channel_config(&channel_config));
+    ESP_ERROR_CHECK(ledc_fade_func_install(0));
+
+    led_off();
 }
 
 #else
@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "quantile.h"
+#include <string.h>
+
+/* Private function declarations */
+static int64_t desired_pos(const struct quantile_p2 *est, int i, int32_t total);
+static int32_t parabolic(const struct quantile_p2 *est, int i, int d);
+static int32_t linear(const struct quantile_p2 *est, int i, int d);
+
+/* Private functions */
+/* 第 i 个标记的理想位置，Q16: 1 + (total - 1) * dn[i]，dn = {0, p/2, p, (1+p)/2, 1} */
+static int64_t desired_pos(const struct quantile_p2 *est, int i, int32_t total) {
+    static const uint8_t num[QUANTILE_MARKERS] = {0, 1, 2, 1, 2};
+    int64_t dn;
+
+    switch (i) {
+    case 0:
+        dn = 0;
+        break;
+    case 4:
+        dn = 65536;
+        break;
+    case 3:
+        dn = (65536 + est->p) / 2;
+        break;
+    default:
+        dn = est->p * num[i] / 2;
+        break;
+    }
+    return 65536 + (int64_t)(total - 1) * dn;
+}
+
+/* 分段抛物线(P²)插值 */
+static int32_t parabolic(const struct quantile_p2 *est, int i, int d) {
+    const int32_t *q = est->q;
+    const int32_t *n = est->n;
+    int64_t a = (int64_t)(n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]);
+    int64_t b = (int64_t)(n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]);
+
+    return q[i] + (int32_t)(d * (a + b) / (n[i + 1] - n[i - 1]));
+}
+
+static int32_t linear(const struct quantile_p2 *est, int i, int d) {
+    return est->q[i] + d * (est->q[i + d] - est->q[i]) / (est->n[i + d] - est->n[i]);
+}
+
+/* Public functions */
+void quantile_init(struct quantile_p2 *est, uint16_t p) {
+    memset(est, 0, sizeof(*est));
+    est->p = p;
+}
+
+void quantile_add(struct quantile_p2 *est, int32_t x) {
+    int32_t total;
+    int k;
+
+    /* 负数左移是未定义行为，用乘法转换为 Q8 */
+    x *= 1 << QUANTILE_FRAC_BITS;
+
+    /* 前 5 个样本插入排序，作为初始标记 */
+    if (est->count < QUANTILE_MARKERS) {
+        int i = est->count;
+        while (i > 0 && est->q[i - 1] > x) {
+            est->q[i] = est->q[i - 1];
+            i--;
+        }
+        est->q[i] = x;
+        est->count++;
+        for (i = 0; i < QUANTILE_MARKERS; i++) {
+            est->n[i] = i + 1;
+        }
+        return;
+    }
+
+    /* 找到 x 所在的区间，必要时扩展两端标记 */
+    if (x < est->q[0]) {
+        est->q[0] = x;
+        k = 0;
+    } else if (x >= est->q[4]) {
+        est->q[4] = x;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && x >= est->q[k + 1]; k++) {
+        }
+    }
+    for (int i = k + 1; i < QUANTILE_MARKERS; i++) {
+        est->n[i]++;
+    }
+    total = est->n[4];
+
+    /* 调整中间三个标记，使其位置接近理想位置 */
+    for (int i = 1; i < QUANTILE_MARKERS - 1; i++) {
+        int64_t delta = desired_pos(est, i, total) - ((int64_t)est->n[i] << 16);
+        int d;
+
+        if (delta >= 65536 && est->n[i + 1] - est->n[i] > 1) {
+            d = 1;
+        } else if (delta <= -65536 && est->n[i - 1] - est->n[i] < -1) {
+            d = -1;
+        } else {
+            continue;
+        }
+
+        int32_t q = parabolic(est, i, d);
+        if (est->q[i - 1] < q && q < est->q[i + 1]) {
+            est->q[i] = q;
+        } else {
+            est->q[i] = linear(est, i, d);
+        }
+        est->n[i] += d;
+    }
+}
+
+int32_t quantile_value(const struct quantile_p2 *est) {
+    int idx;
+
+    if (est->count == 0) {
+        return 0;
+    }
+    if (est->count < QUANTILE_MARKERS) {
+        /* 样本不足时直接取排序后的对应样本 */
+        idx = (int)(((uint32_t)est->p * (est->count - 1) + 32767) >> 16);
+        return est->q[idx] >> QUANTILE_FRAC_BITS;
+    }
+    return (est->q[2] + (1 << (QUANTILE_FRAC_BITS - 1))) >> QUANTILE_FRAC_BITS;
+}
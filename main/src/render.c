@@ -0,0 +1,181 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "render.h"
+#include <string.h>
+
+/* Private function declarations */
+static const struct font_glyph *find_glyph(const struct font *font, char c);
+static void draw_text(const struct render_item *item, uint16_t x, uint16_t y,
+                      uint16_t w, uint16_t rows, uint8_t *buf);
+static void draw_rect(const struct render_item *item, uint16_t x, uint16_t y,
+                      uint16_t w, uint16_t rows, uint8_t *buf);
+
+/* Private variables */
+#if CONFIG_EPD_DISPLAY
+static uint8_t band_buf[RENDER_BAND_BYTES];
+#endif
+
+/* Private functions */
+static const struct font_glyph *find_glyph(const struct font *font, char c) {
+    const char *p = strchr(font->chars, c);
+
+    return p == NULL || c == '\0' ? NULL : &font->glyphs[p - font->chars];
+}
+
+static inline void put_pixel(uint8_t *buf, uint16_t stride, uint16_t col,
+                             uint16_t row, bool black) {
+    uint8_t mask = 0x80 >> (col & 7);
+
+    if (black) {
+        buf[row * stride + col / 8] &= ~mask;
+    } else {
+        buf[row * stride + col / 8] |= mask;
+    }
+}
+
+static void draw_text(const struct render_item *item, uint16_t x, uint16_t y,
+                      uint16_t w, uint16_t rows, uint8_t *buf) {
+    const struct font *font = item->font;
+    uint16_t stride = w / 8;
+    int pen = item->x;
+
+    for (const char *c = item->text; *c != '\0'; c++) {
+        const struct font_glyph *g = find_glyph(font, *c);
+        if (g == NULL) {
+            continue;
+        }
+
+        uint16_t glyph_stride = (g->width + 7) / 8;
+        for (uint16_t r = 0; r < rows; r++) {
+            int gy = y + r - item->y;
+            if (gy < 0 || gy >= font->height) {
+                continue;
+            }
+            const uint8_t *src = font->bitmap + g->offset + gy * glyph_stride;
+            for (uint16_t gx = 0; gx < g->width; gx++) {
+                int px = pen + gx - x;
+                if (px < 0 || px >= w || !(src[gx / 8] & (0x80 >> (gx & 7)))) {
+                    continue;
+                }
+                put_pixel(buf, stride, px, r, item->black);
+            }
+        }
+        pen += g->width + font->spacing;
+    }
+}
+
+static void draw_rect(const struct render_item *item, uint16_t x, uint16_t y,
+                      uint16_t w, uint16_t rows, uint8_t *buf) {
+    uint16_t stride = w / 8;
+
+    for (uint16_t r = 0; r < rows; r++) {
+        int py = y + r;
+        if (py < item->y || py >= item->y + item->h) {
+            continue;
+        }
+        for (int px = item->x; px < item->x + item->w; px++) {
+            if (px >= x && px < x + w) {
+                put_pixel(buf, stride, px - x, r, item->black);
+            }
+        }
+    }
+}
+
+/* Public functions */
+void render_clear(struct render_scene *scene) { scene->count = 0; }
+
+int render_text(struct render_scene *scene, uint16_t x, uint16_t y,
+                const struct font *font, bool black, const char *text) {
+    struct render_item *item;
+
+    if (scene->count >= RENDER_MAX_ITEMS) {
+        return -1;
+    }
+    item = &scene->items[scene->count++];
+    item->type = RENDER_TEXT;
+    item->black = black;
+    item->x = x;
+    item->y = y;
+    item->font = font;
+    strncpy(item->text, text, sizeof(item->text) - 1);
+    item->text[sizeof(item->text) - 1] = '\0';
+    item->w = render_text_width(font, item->text);
+    item->h = font->height;
+    return 0;
+}
+
+int render_rect(struct render_scene *scene, uint16_t x, uint16_t y, uint16_t w,
+                uint16_t h, bool black) {
+    struct render_item *item;
+
+    if (scene->count >= RENDER_MAX_ITEMS) {
+        return -1;
+    }
+    item = &scene->items[scene->count++];
+    item->type = RENDER_RECT;
+    item->black = black;
+    item->x = x;
+    item->y = y;
+    item->w = w;
+    item->h = h;
+    item->font = NULL;
+    item->text[0] = '\0';
+    return 0;
+}
+
+uint16_t render_text_width(const struct font *font, const char *text) {
+    uint16_t width = 0;
+
+    for (const char *c = text; *c != '\0'; c++) {
+        const struct font_glyph *g = find_glyph(font, *c);
+        if (g != NULL) {
+            width += g->width + font->spacing;
+        }
+    }
+    return width > 0 ? width - font->spacing : 0;
+}
+
+void render_band(const struct render_scene *scene, uint16_t x, uint16_t y,
+                 uint16_t w, uint16_t rows, uint8_t *buf) {
+    memset(buf, 0xFF, (size_t)(w / 8) * rows);
+
+    /* 按添加顺序绘制，后添加的覆盖先添加的 */
+    for (uint8_t i = 0; i < scene->count; i++) {
+        const struct render_item *item = &scene->items[i];
+        if (item->y >= y + rows || item->y + item->h <= y ||
+            item->x >= x + w || item->x + item->w <= x) {
+            continue;
+        }
+        if (item->type == RENDER_TEXT) {
+            draw_text(item, x, y, w, rows, buf);
+        } else {
+            draw_rect(item, x, y, w, rows, buf);
+        }
+    }
+}
+
+#if CONFIG_EPD_DISPLAY
+esp_err_t render_window(const struct render_scene *scene, enum epd_ram ram,
+                        uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    uint16_t stride = w / 8;
+    uint16_t band_rows;
+    esp_err_t rc;
+
+    if (stride == 0 || stride > RENDER_BAND_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    band_rows = RENDER_BAND_BYTES / stride;
+
+    rc = epd_begin_window(ram, x, y, w, h);
+    for (uint16_t row = 0; row < h && rc == ESP_OK; row += band_rows) {
+        uint16_t rows = h - row < band_rows ? h - row : band_rows;
+        render_band(scene, x, y + row, w, rows, band_buf);
+        rc = epd_write(band_buf, (size_t)stride * rows);
+    }
+    return rc;
+}
+#endif
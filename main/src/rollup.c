@@ -0,0 +1,308 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "rollup.h"
+#include "common.h"
+#include "quantile.h"
+#include "flash_log.h"
+
+/* 每个桶估计的分位数 */
+enum {
+    EST_TEMP_P50 = 0,
+    EST_TEMP_P95,
+    EST_HUMI_P50,
+    EST_HUMI_P95,
+    EST_COUNT,
+};
+
+/* 私有类型 */
+/* 每种分辨率: 已完成桶的环形缓冲区 + 正在累计的当前桶 */
+struct rollup_ring {
+    struct rollup_bucket *buf;
+    uint16_t cap;
+    uint16_t head;          // 最旧桶的下标
+    uint16_t count;
+    uint32_t period;        // 桶宽度(秒)
+    const char *nvs_key;    // NULL 表示不持久化
+    struct rollup_bucket cur;
+    struct quantile_p2 est[EST_COUNT];  // 当前桶的分位数估计
+};
+
+/* 私有函数声明 */
+static void bucket_reset(struct rollup_bucket *b, uint32_t start);
+static void bucket_add(struct rollup_bucket *b, const struct history_sample *sample);
+static void ring_quantiles(const struct rollup_ring *ring, struct rollup_bucket *b);
+static bool ring_add(struct rollup_ring *ring, const struct history_sample *sample);
+static void ring_persist(enum rollup_level level);
+static void replay_sample(const struct history_sample *sample, void *arg);
+
+/* 私有变量 */
+static struct rollup_bucket minute_buf[ROLLUP_MINUTES];
+static struct rollup_bucket hour_buf[ROLLUP_HOURS];
+static struct rollup_bucket day_buf[ROLLUP_DAYS];
+
+static struct rollup_ring rings[ROLLUP_LEVELS] = {
+    [ROLLUP_MINUTE] = {.buf = minute_buf, .cap = ROLLUP_MINUTES, .period = 60},
+    [ROLLUP_HOUR] = {.buf = hour_buf, .cap = ROLLUP_HOURS, .period = 3600,
+                     .nvs_key = "hours2"},
+    [ROLLUP_DAY] = {.buf = day_buf, .cap = ROLLUP_DAYS, .period = 86400,
+                    .nvs_key = "days2"},
+};
+/* 旧版(不含分位数)记录布局使用的键，升级后删除以释放 NVS 空间 */
+static const char *const legacy_nvs_keys[] = {"hours", "days"};
+static portMUX_TYPE rollup_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* 私有函数 */
+static void bucket_reset(struct rollup_bucket *b, uint32_t start) {
+    b->start = start;
+    b->count = 0;
+    b->temp_min = INT16_MAX;
+    b->temp_max = INT16_MIN;
+    b->humi_min = UINT16_MAX;
+    b->humi_max = 0;
+    b->temp_sum = 0;
+    b->humi_sum = 0;
+}
+
+static void bucket_add(struct rollup_bucket *b, const struct history_sample *sample) {
+    if (sample->temp < b->temp_min) {
+        b->temp_min = sample->temp;
+    }
+    if (sample->temp > b->temp_max) {
+        b->temp_max = sample->temp;
+    }
+    if (sample->humi < b->humi_min) {
+        b->humi_min = sample->humi;
+    }
+    if (sample->humi > b->humi_max) {
+        b->humi_max = sample->humi;
+    }
+    b->temp_sum += sample->temp;
+    b->humi_sum += sample->humi;
+    b->count++;
+}
+
+static void ring_quantiles(const struct rollup_ring *ring, struct rollup_bucket *b) {
+    b->temp_p50 = quantile_value(&ring->est[EST_TEMP_P50]);
+    b->temp_p95 = quantile_value(&ring->est[EST_TEMP_P95]);
+    b->humi_p50 = quantile_value(&ring->est[EST_HUMI_P50]);
+    b->humi_p95 = quantile_value(&ring->est[EST_HUMI_P95]);
+}
+
+/* 调用方需持有 rollup_lock；记录跨入新桶时返回 true */
+static bool ring_add(struct rollup_ring *ring, const struct history_sample *sample) {
+    uint32_t start = sample->ts - sample->ts % ring->period;
+    bool rolled = false;
+
+    if (start != ring->cur.start && ring->cur.count > 0) {
+        /* 当前桶结束，移入环形缓冲区，写满后覆盖最旧的桶 */
+        uint16_t idx = (ring->head + ring->count) % ring->cap;
+        if (ring->count < ring->cap) {
+            ring->count++;
+        } else {
+            ring->head = (ring->head + 1) % ring->cap;
+        }
+        ring_quantiles(ring, &ring->cur);
+        ring->buf[idx] = ring->cur;
+        rolled = true;
+    }
+    if (start != ring->cur.start || ring->cur.count == 0) {
+        bucket_reset(&ring->cur, start);
+        quantile_init(&ring->est[EST_TEMP_P50], QUANTILE_P(0.5));
+        quantile_init(&ring->est[EST_TEMP_P95], QUANTILE_P(0.95));
+        quantile_init(&ring->est[EST_HUMI_P50], QUANTILE_P(0.5));
+        quantile_init(&ring->est[EST_HUMI_P95], QUANTILE_P(0.95));
+    }
+    bucket_add(&ring->cur, sample);
+    quantile_add(&ring->est[EST_TEMP_P50], sample->temp);
+    quantile_add(&ring->est[EST_TEMP_P95], sample->temp);
+    quantile_add(&ring->est[EST_HUMI_P50], sample->humi);
+    quantile_add(&ring->est[EST_HUMI_P95], sample->humi);
+    return rolled;
+}
+
+/* 按逻辑顺序保存已完成的桶，每小时/每天最多写一次 NVS */
+static void ring_persist(enum rollup_level level) {
+    static struct rollup_bucket snapshot[ROLLUP_HOURS > ROLLUP_DAYS ? ROLLUP_HOURS : ROLLUP_DAYS];
+    struct rollup_ring *ring = &rings[level];
+    nvs_handle_t handle;
+    size_t n;
+    esp_err_t err;
+
+    taskENTER_CRITICAL(&rollup_lock);
+    n = ring->count;
+    for (size_t i = 0; i < n; i++) {
+        snapshot[i] = ring->buf[(ring->head + i) % ring->cap];
+    }
+    taskEXIT_CRITICAL(&rollup_lock);
+
+    err = nvs_open(ROLLUP_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "打开聚合数据 NVS 失败: %d", err);
+        return;
+    }
+    err = nvs_set_blob(handle, ring->nvs_key, snapshot, n * sizeof(snapshot[0]));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "保存聚合数据 %s 失败: %d", ring->nvs_key, err);
+    }
+}
+
+/* arg 为各分辨率的回放起点，早于起点的记录已在 NVS 中的已完成桶里 */
+static void replay_sample(const struct history_sample *sample, void *arg) {
+    const uint32_t *from = arg;
+
+    taskENTER_CRITICAL(&rollup_lock);
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        if (sample->ts >= from[level]) {
+            ring_add(&rings[level], sample);
+        }
+    }
+    taskEXIT_CRITICAL(&rollup_lock);
+}
+
+/* 公有函数 */
+void rollup_init(void) {
+    uint32_t last_ts = flash_log_last_ts();
+    uint32_t from[ROLLUP_LEVELS];
+    uint32_t from_min = UINT32_MAX;
+    nvs_handle_t handle;
+    bool erased = false;
+    size_t n;
+
+    if (nvs_open(ROLLUP_NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        for (size_t i = 0; i < sizeof(legacy_nvs_keys) / sizeof(legacy_nvs_keys[0]); i++) {
+            if (nvs_erase_key(handle, legacy_nvs_keys[i]) == ESP_OK) {
+                erased = true;
+            }
+        }
+        if (erased && nvs_commit(handle) == ESP_OK) {
+            ESP_LOGI(TAG, "已删除旧版聚合数据");
+        }
+
+        for (int level = 0; level < ROLLUP_LEVELS; level++) {
+            struct rollup_ring *ring = &rings[level];
+            size_t len = ring->cap * sizeof(ring->buf[0]);
+
+            if (ring->nvs_key == NULL ||
+                nvs_get_blob(handle, ring->nvs_key, ring->buf, &len) != ESP_OK) {
+                continue;
+            }
+            if (len % sizeof(ring->buf[0]) != 0) {
+                ESP_LOGW(TAG, "聚合数据 %s 长度 %u 无效，已丢弃", ring->nvs_key,
+                         (unsigned)len);
+                continue;
+            }
+            ring->head = 0;
+            ring->count = len / sizeof(ring->buf[0]);
+            ESP_LOGI(TAG, "已恢复 %d 个%s聚合", ring->count,
+                     level == ROLLUP_HOUR ? "小时" : "天");
+        }
+        nvs_close(handle);
+    }
+
+    if (last_ts == 0) {
+        return;
+    }
+
+    /*
+     * 正在累计的桶只在 RAM 中，重启或深睡眠唤醒后从 flash 日志回放重建:
+     * 小时/天只回放最后一条记录所在的当前桶，分钟回放整个环形缓冲区的时间跨度。
+     */
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        const struct rollup_ring *ring = &rings[level];
+        uint32_t span = level == ROLLUP_MINUTE ? (ring->cap - 1) * ring->period : 0;
+        uint32_t start = last_ts - last_ts % ring->period;
+
+        from[level] = start > span ? start - span : 0;
+        if (from[level] < from_min) {
+            from_min = from[level];
+        }
+    }
+    n = flash_log_replay(from_min, replay_sample, from);
+    ESP_LOGI(TAG, "已从 flash 日志回放 %u 条记录重建当前聚合桶", (unsigned)n);
+}
+
+void rollup_add(const struct history_sample *sample) {
+    bool rolled[ROLLUP_LEVELS];
+
+    taskENTER_CRITICAL(&rollup_lock);
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        rolled[level] = ring_add(&rings[level], sample);
+    }
+    taskEXIT_CRITICAL(&rollup_lock);
+
+    for (int level = 0; level < ROLLUP_LEVELS; level++) {
+        if (rolled[level] && rings[level].nvs_key != NULL) {
+            ring_persist(level);
+        }
+    }
+}
+
+size_t rollup_count(enum rollup_level level) {
+    const struct rollup_ring *ring = &rings[level];
+    size_t n;
+
+    taskENTER_CRITICAL(&rollup_lock);
+    n = ring->count + (ring->cur.count > 0 ? 1 : 0);
+    taskEXIT_CRITICAL(&rollup_lock);
+    return n;
+}
+
+int rollup_get(enum rollup_level level, size_t idx, struct rollup_bucket *bucket) {
+    const struct rollup_ring *ring = &rings[level];
+    int rc = 0;
+
+    taskENTER_CRITICAL(&rollup_lock);
+    if (idx < ring->count) {
+        *bucket = ring->buf[(ring->head + idx) % ring->cap];
+    } else if (idx == ring->count && ring->cur.count > 0) {
+        *bucket = ring->cur;
+        ring_quantiles(ring, bucket);
+    } else {
+        rc = -1;
+    }
+    taskEXIT_CRITICAL(&rollup_lock);
+    return rc;
+}
+
+size_t rollup_encode(const struct rollup_bucket *bucket, uint8_t *buf) {
+    int16_t temp_mean = bucket->count ? bucket->temp_sum / (int32_t)bucket->count : 0;
+    uint16_t humi_mean = bucket->count ? bucket->humi_sum / bucket->count : 0;
+
+    buf[0] = bucket->start & 0xFF;
+    buf[1] = (bucket->start >> 8) & 0xFF;
+    buf[2] = (bucket->start >> 16) & 0xFF;
+    buf[3] = (bucket->start >> 24) & 0xFF;
+    buf[4] = bucket->count & 0xFF;
+    buf[5] = (bucket->count >> 8) & 0xFF;
+    buf[6] = (bucket->count >> 16) & 0xFF;
+    buf[7] = (bucket->count >> 24) & 0xFF;
+    buf[8] = bucket->temp_min & 0xFF;
+    buf[9] = (bucket->temp_min >> 8) & 0xFF;
+    buf[10] = bucket->temp_max & 0xFF;
+    buf[11] = (bucket->temp_max >> 8) & 0xFF;
+    buf[12] = temp_mean & 0xFF;
+    buf[13] = (temp_mean >> 8) & 0xFF;
+    buf[14] = bucket->humi_min & 0xFF;
+    buf[15] = (bucket->humi_min >> 8) & 0xFF;
+    buf[16] = bucket->humi_max & 0xFF;
+    buf[17] = (bucket->humi_max >> 8) & 0xFF;
+    buf[18] = humi_mean & 0xFF;
+    buf[19] = (humi_mean >> 8) & 0xFF;
+    buf[20] = bucket->temp_p50 & 0xFF;
+    buf[21] = (bucket->temp_p50 >> 8) & 0xFF;
+    buf[22] = bucket->temp_p95 & 0xFF;
+    buf[23] = (bucket->temp_p95 >> 8) & 0xFF;
+    buf[24] = bucket->humi_p50 & 0xFF;
+    buf[25] = (bucket->humi_p50 >> 8) & 0xFF;
+    buf[26] = bucket->humi_p95 & 0xFF;
+    buf[27] = (bucket->humi_p95 >> 8) & 0xFF;
+    return ROLLUP_WIRE_BYTES;
+}
@@ -0,0 +1,217 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "rtc.h"
+#include "common.h"
+#include "driver/gpio.h"
+#include "i2c_bus.h"
+#include "esp_sleep.h"
+#include "timebase.h"
+
+#if CONFIG_RTC_PCF8563
+
+/* Defines */
+#define RTC_SCL_HZ 400000               // 与 SHT40 共用 i2c_bus 管理的总线
+
+/* PCF8563 寄存器 */
+#define REG_CTRL2 0x01
+#define REG_SECONDS 0x02
+#define REG_MINUTE_ALARM 0x09
+#define REG_TIMER_CTRL 0x0E
+#define REG_TIMER 0x0F
+
+#define CTRL2_AF 0x08       // 闹钟标志
+#define CTRL2_TF 0x04       // 倒计时标志
+#define CTRL2_AIE 0x02
+#define CTRL2_TIE 0x01
+#define SECONDS_VL 0x80     // 电压过低，时间不可信
+#define ALARM_DISABLE 0x80
+#define TIMER_ENABLE_1HZ 0x82
+
+/* Private function declarations */
+static esp_err_t reg_read(uint8_t reg, uint8_t *buf, size_t len);
+static esp_err_t reg_write(uint8_t reg, const uint8_t *buf, size_t len);
+static uint8_t bcd2bin(uint8_t v);
+static uint8_t bin2bcd(uint8_t v);
+
+/* Private variables */
+static bool time_valid = false;
+static i2c_master_dev_handle_t rtc_dev;
+
+/* Private functions */
+static esp_err_t reg_read(uint8_t reg, uint8_t *buf, size_t len) {
+    return i2c_bus_write_read(rtc_dev, &reg, 1, buf, len);
+}
+
+static esp_err_t reg_write(uint8_t reg, const uint8_t *buf, size_t len) {
+    uint8_t tx[8];
+
+    tx[0] = reg;
+    memcpy(tx + 1, buf, len);
+    return i2c_bus_write(rtc_dev, tx, len + 1);
+}
+
+static uint8_t bcd2bin(uint8_t v) { return (v >> 4) * 10 + (v & 0x0F); }
+
+static uint8_t bin2bcd(uint8_t v) { return ((v / 10) << 4) | (v % 10); }
+
+/* Public functions */
+esp_err_t rtc_init(void) {
+    uint8_t ctrl2 = 0;
+    uint8_t seconds;
+    esp_err_t rc;
+
+    if (rtc_dev == NULL) {
+        rc = i2c_bus_add_device(RTC_PCF8563_ADDR, RTC_SCL_HZ, &rtc_dev);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+    }
+
+    rc = reg_read(REG_SECONDS, &seconds, 1);
+    if (rc != ESP_OK) {
+        ESP_LOGW(TAG, "未检测到 RTC，错误码: %d", rc);
+        return rc;
+    }
+    time_valid = !(seconds & SECONDS_VL);
+
+    /* 清除唤醒我们的闹钟/倒计时标志并关闭中断，INT 引脚随之释放 */
+    rc = reg_write(REG_CTRL2, &ctrl2, 1);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    ESP_LOGI(TAG, "RTC 已初始化；时间%s", time_valid ? "有效" : "无效(需要同步)");
+    return ESP_OK;
+}
+
+bool rtc_time_valid(void) { return time_valid; }
+
+esp_err_t rtc_get_time(uint32_t *now) {
+    uint8_t r[7];
+    esp_err_t rc;
+
+    rc = reg_read(REG_SECONDS, r, sizeof(r));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (r[0] & SECONDS_VL) {
+        time_valid = false;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* 年份寄存器只有两位，约定为 20xx */
+    struct timebase_civil civil = {
+        .year = 2000 + bcd2bin(r[6]),
+        .month = bcd2bin(r[5] & 0x1F),
+        .day = bcd2bin(r[3] & 0x3F),
+        .hour = bcd2bin(r[2] & 0x3F),
+        .minute = bcd2bin(r[1] & 0x7F),
+        .second = bcd2bin(r[0] & 0x7F),
+    };
+    *now = timebase_from_civil(&civil);
+    return ESP_OK;
+}
+
+esp_err_t rtc_set_time(uint32_t now) {
+    struct timebase_civil civil;
+    uint8_t r[7];
+    esp_err_t rc;
+
+    timebase_to_civil(now, &civil);
+    if (civil.year < 2000 || civil.year > 2099) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    r[0] = bin2bcd(civil.second);           // 同时清除 VL
+    r[1] = bin2bcd(civil.minute);
+    r[2] = bin2bcd(civil.hour);
+    r[3] = bin2bcd(civil.day);
+    r[4] = civil.weekday % 7;               // PCF8563 以 0 表示星期日
+    r[5] = bin2bcd(civil.month);
+    r[6] = bin2bcd(civil.year - 2000);
+
+    rc = reg_write(REG_SECONDS, r, sizeof(r));
+    if (rc == ESP_OK) {
+        time_valid = true;
+    }
+    return rc;
+}
+
+esp_err_t rtc_set_wakeup(uint32_t at) {
+    uint32_t now;
+    uint8_t ctrl2;
+    esp_err_t rc;
+
+    rc = rtc_get_time(&now);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (at <= now) {
+        at = now + 1;
+    }
+
+    if (at - now <= RTC_TIMER_MAX_S) {
+        /* 1 Hz 倒计时，首个周期与秒边界不同步，误差不超过 1 s */
+        /* 停止、装载、启动倒计时，三次写入在一次总线占用内完成 */
+        uint8_t stop[2] = {REG_TIMER_CTRL, 0};
+        uint8_t load[2] = {REG_TIMER, (uint8_t)(at - now)};
+        uint8_t start[2] = {REG_TIMER_CTRL, TIMER_ENABLE_1HZ};
+        const struct i2c_bus_op ops[] = {
+            {.tx = stop, .tx_len = sizeof(stop)},
+            {.tx = load, .tx_len = sizeof(load)},
+            {.tx = start, .tx_len = sizeof(start)},
+        };
+        rc = i2c_bus_transfer(rtc_dev, ops, sizeof(ops) / sizeof(ops[0]));
+        ctrl2 = CTRL2_TIE;
+    } else {
+        /* 分钟/小时/日期匹配，星期不参与 */
+        struct timebase_civil civil;
+        timebase_to_civil(at, &civil);
+        uint8_t alarm[4] = {
+            bin2bcd(civil.minute),
+            bin2bcd(civil.hour),
+            bin2bcd(civil.day),
+            ALARM_DISABLE,
+        };
+        rc = reg_write(REG_MINUTE_ALARM, alarm, sizeof(alarm));
+        ctrl2 = CTRL2_AIE;
+    }
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* 写 CTRL2 同时清除 AF/TF，避免旧标志让 INT 保持低电平 */
+    return reg_write(REG_CTRL2, &ctrl2, 1);
+}
+
+void rtc_deep_sleep_until(uint32_t at) {
+    gpio_config_t io = {
+        .pin_bit_mask = 1ULL << CONFIG_RTC_INT_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+    };
+    esp_err_t rc;
+
+    rc = rtc_set_wakeup(at);
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "设置 RTC 唤醒失败，错误码: %d", rc);
+        return;
+    }
+
+    gpio_config(&io);
+    rc = esp_deep_sleep_enable_gpio_wakeup(1ULL << CONFIG_RTC_INT_GPIO,
+                                           ESP_GPIO_WAKEUP_GPIO_LOW);
+    if (rc != ESP_OK) {
+        ESP_LOGE(TAG, "配置 GPIO 唤醒失败，错误码: %d", rc);
+        return;
+    }
+
+    ESP_LOGI(TAG, "进入深睡眠，等待 RTC 在 %lu 唤醒", (unsigned long)at);
+    esp_deep_sleep_start();
+}
+
+#endif // CONFIG_RTC_PCF8563
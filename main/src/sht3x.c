@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include "common.h"
+
+#if TH_SENSOR_HAS_SHT3X
+
+/* Defines */
+#define SHT3X_CMD_MEASURE_HIGH 0x2400   // 单次测量，高重复性，不拉伸时钟
+#define SHT3X_CMD_STATUS 0xF32D
+
+/* Public functions */
+esp_err_t sht3x_init(struct th_sensor *s) {
+    uint8_t cmd[2] = {SHT3X_CMD_STATUS >> 8, SHT3X_CMD_STATUS & 0xFF};
+    uint8_t status[3];
+    esp_err_t rc;
+
+    rc = i2c_bus_write_read(s->dev, cmd, sizeof(cmd), status, sizeof(status));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    return th_sensor_crc8(status, 2) == status[2] ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+esp_err_t sht3x_trigger(struct th_sensor *s) {
+    uint8_t cmd[2] = {SHT3X_CMD_MEASURE_HIGH >> 8, SHT3X_CMD_MEASURE_HIGH & 0xFF};
+
+    return i2c_bus_write(s->dev, cmd, sizeof(cmd));
+}
+
+esp_err_t sht3x_collect(struct th_sensor *s, struct th_reading *out) {
+    uint8_t data[6];
+    esp_err_t rc;
+
+    rc = i2c_bus_read(s->dev, data, sizeof(data));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (th_sensor_crc8(data, 2) != data[2] || th_sensor_crc8(data + 3, 2) != data[5]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    /* T = -45 + 175 * S / 65535，RH = 100 * S / 65535 */
+    uint32_t raw_t = (data[0] << 8) | data[1];
+    uint32_t raw_h = (data[3] << 8) | data[4];
+    out->temp = (int16_t)(-4500 + (int32_t)(raw_t * 17500 / 65535));
+    out->humi = (uint16_t)(raw_h * 10000 / 65535);
+    return ESP_OK;
+}
+
+const struct th_sensor_driver th_sensor_sht3x = {
+    .name = "SHT3x",
+    .addrs = {0x44, 0x45},
+    .scl_hz = 400000,
+    .conv_ms = SHT3X_CONV_MS,
+    .active_ua = 800,
+    .sleep_na = 200,
+    .init = sht3x_init,
+    .trigger = sht3x_trigger,
+    .collect = sht3x_collect,
+};
+
+#endif // TH_SENSOR_HAS_SHT3X
@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include "common.h"
+
+#if TH_SENSOR_HAS_SHT4X
+
+/* Defines */
+#define SHT4X_CMD_MEASURE_HIGH 0xFD
+#define SHT4X_CMD_SERIAL 0x89
+
+/* Private function declarations */
+static esp_err_t check_words(const uint8_t *data);
+
+/* Private functions */
+/* 两个 16 位字各带一个 CRC */
+static esp_err_t check_words(const uint8_t *data) {
+    if (th_sensor_crc8(data, 2) != data[2] || th_sensor_crc8(data + 3, 2) != data[5]) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+/* Public functions */
+esp_err_t sht4x_init(struct th_sensor *s) {
+    uint8_t cmd = SHT4X_CMD_SERIAL;
+    uint8_t data[6];
+    esp_err_t rc;
+
+    /* 单字节的读序列号命令 SHT3x 不认识，CRC 正确才算 SHT4x */
+    rc = i2c_bus_write(s->dev, &cmd, 1);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    vTaskDelay(th_sensor_delay_ticks(1));
+    rc = i2c_bus_read(s->dev, data, sizeof(data));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    return check_words(data);
+}
+
+esp_err_t sht4x_trigger(struct th_sensor *s) {
+    uint8_t cmd = SHT4X_CMD_MEASURE_HIGH;
+
+    return i2c_bus_write(s->dev, &cmd, 1);
+}
+
+esp_err_t sht4x_collect(struct th_sensor *s, struct th_reading *out) {
+    uint8_t data[6];
+    esp_err_t rc;
+
+    rc = i2c_bus_read(s->dev, data, sizeof(data));
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    rc = check_words(data);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* T = -45 + 175 * S / 65535，RH = -6 + 125 * S / 65535 并限幅到 0..100 */
+    uint32_t raw_t = (data[0] << 8) | data[1];
+    uint32_t raw_h = (data[3] << 8) | data[4];
+    int32_t humi = -600 + (int32_t)(raw_h * 12500 / 65535);
+    out->temp = (int16_t)(-4500 + (int32_t)(raw_t * 17500 / 65535));
+    out->humi = humi < 0 ? 0 : humi > 10000 ? 10000 : (uint16_t)humi;
+    return ESP_OK;
+}
+
+const struct th_sensor_driver th_sensor_sht4x = {
+    .name = "SHT4x",
+    .addrs = {0x44, 0x45},
+    .scl_hz = 400000,
+    .conv_ms = SHT4X_CONV_MS,
+    .active_ua = 320,
+    .sleep_na = 80,
+    .init = sht4x_init,
+    .trigger = sht4x_trigger,
+    .collect = sht4x_collect,
+};
+
+#endif // TH_SENSOR_HAS_SHT4X
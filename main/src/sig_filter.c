@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "sig_filter.h"
+#include <string.h>
+
+/* Private function declarations */
+static int32_t window_median(const struct sig_filter *f);
+
+/* Private functions */
+/* 窗口最多 7 个值，复制后插入排序 */
+static int32_t window_median(const struct sig_filter *f) {
+    int32_t sorted[SIG_FILTER_MEDIAN_MAX];
+    int n = f->fill;
+
+    for (int i = 0; i < n; i++) {
+        int32_t v = f->window[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[n / 2];
+}
+
+/* Public functions */
+void sig_filter_init(struct sig_filter *f, uint8_t median_n, uint16_t tau_samples) {
+    memset(f, 0, sizeof(*f));
+    if (median_n < 1) {
+        median_n = 1;
+    } else if (median_n > SIG_FILTER_MEDIAN_MAX) {
+        median_n = SIG_FILTER_MEDIAN_MAX;
+    }
+    f->median_n = median_n | 1;
+
+    /* 离散时间常数 tau 对应 alpha = 1 / (tau + 1) */
+    f->alpha = tau_samples == 0 ? UINT16_MAX : 65536 / (tau_samples + 1);
+}
+
+void sig_filter_prime(struct sig_filter *f, int32_t x) {
+    for (int i = 0; i < f->median_n; i++) {
+        f->window[i] = x;
+    }
+    f->fill = f->median_n;
+    f->pos = 0;
+    f->ema = x * 256;
+    f->primed = true;
+}
+
+int32_t sig_filter_update(struct sig_filter *f, int32_t x) {
+    int32_t m;
+
+    f->window[f->pos] = x;
+    f->pos = (f->pos + 1) % f->median_n;
+    if (f->fill < f->median_n) {
+        f->fill++;
+    }
+    m = f->median_n == 1 ? x : window_median(f);
+
+    /* 负数左移是未定义行为，用乘法转换为 Q8 */
+    if (!f->primed || f->alpha == UINT16_MAX) {
+        f->ema = m * 256;
+        f->primed = true;
+    } else {
+        f->ema += (int32_t)(((int64_t)(m * 256 - f->ema) * f->alpha) >> 16);
+    }
+
+    /* 四舍五入回输入单位 */
+    return (f->ema + 128) >> 8;
+}
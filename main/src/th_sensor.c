@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include "common.h"
+#include <stdlib.h>
+
+/* Private function declarations */
+static bool addr_taken(const struct th_sensor *s, size_t n, uint8_t addr);
+
+/* Private variables */
+/* 探测顺序: 独占地址的器件在前；SHT4x 与 SHT3x 地址相同，靠命令集区分 */
+static const struct th_sensor_driver *const drivers[] = {
+#if TH_SENSOR_HAS_AHT20
+    &th_sensor_aht20,
+#endif
+#if TH_SENSOR_HAS_BME280
+    &th_sensor_bme280,
+#endif
+#if TH_SENSOR_HAS_SHT4X
+    &th_sensor_sht4x,
+#endif
+#if TH_SENSOR_HAS_SHT3X
+    &th_sensor_sht3x,
+#endif
+};
+
+/* Private functions */
+static bool addr_taken(const struct th_sensor *s, size_t n, uint8_t addr) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i].addr == addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Public functions */
+size_t th_sensor_detect(struct th_sensor *s, size_t max) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < sizeof(drivers) / sizeof(drivers[0]) && n < max; i++) {
+        const struct th_sensor_driver *drv = drivers[i];
+
+        for (size_t j = 0; j < sizeof(drv->addrs) && drv->addrs[j] != 0 && n < max; j++) {
+            struct th_sensor *cur = &s[n];
+
+            if (addr_taken(s, n, drv->addrs[j]) || i2c_bus_probe(drv->addrs[j]) != ESP_OK) {
+                continue;
+            }
+
+            memset(cur, 0, sizeof(*cur));
+            cur->drv = drv;
+            cur->addr = drv->addrs[j];
+            if (i2c_bus_add_device(cur->addr, drv->scl_hz, &cur->dev) != ESP_OK) {
+                continue;
+            }
+            if (drv->init(cur) != ESP_OK) {
+                i2c_bus_remove_device(cur->dev);
+                cur->dev = NULL;
+                cur->addr = 0;
+                continue;
+            }
+            ESP_LOGI(TAG, "检测到 %s @0x%02x；转换 %u ms，测量 %u uA，空闲 %u nA",
+                     drv->name, cur->addr, drv->conv_ms, drv->active_ua, drv->sleep_na);
+            n++;
+        }
+    }
+
+    if (n == 0) {
+        ESP_LOGE(TAG, "未检测到温湿度传感器");
+    }
+    return n;
+}
+
+esp_err_t th_sensor_sample(struct th_sensor *s, size_t n, struct th_fused *out) {
+    esp_err_t rc = ESP_ERR_NOT_FOUND;
+    esp_err_t trig[TH_SENSOR_MAX];
+    uint16_t wait_ms = 0;
+    int32_t temp_sum = 0;
+    int32_t humi_sum = 0;
+    int valid = 0;
+
+    /* 读取失败的传感器 each[i] 保持为 0，调用方不会拿到未初始化的读数 */
+    memset(out, 0, sizeof(*out));
+    out->count = n;
+
+    for (size_t i = 0; i < n; i++) {
+        trig[i] = th_sensor_trigger(&s[i]);
+        if (trig[i] == ESP_OK && th_sensor_conv_ms(&s[i]) > wait_ms) {
+            wait_ms = th_sensor_conv_ms(&s[i]);
+        } else if (trig[i] != ESP_OK) {
+            rc = trig[i];
+        }
+    }
+    if (wait_ms > 0) {
+        vTaskDelay(th_sensor_delay_ticks(wait_ms));
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        struct th_reading r;
+
+        if (trig[i] != ESP_OK) {
+            continue;
+        }
+        /* 驱动失败时可能已写了一半，读到局部变量，成功才保存 */
+        rc = th_sensor_collect(&s[i], &r);
+        if (rc != ESP_OK) {
+            ESP_LOGW(TAG, "读取传感器 @0x%02x 失败: %d", s[i].addr, rc);
+            continue;
+        }
+        out->each[i] = r;
+        out->valid_mask |= 1 << i;
+        temp_sum += out->each[i].temp;
+        humi_sum += out->each[i].humi;
+        valid++;
+    }
+    if (valid == 0) {
+        return rc;
+    }
+
+    out->value.temp = (int16_t)(temp_sum / valid);
+    out->value.humi = (uint16_t)(humi_sum / valid);
+    if (valid == 2) {
+        out->disagree = abs(out->each[0].temp - out->each[1].temp) >
+                            CONFIG_TH_SENSOR_DISAGREE_TEMP ||
+                        abs(out->each[0].humi - out->each[1].humi) >
+                            CONFIG_TH_SENSOR_DISAGREE_HUMI;
+    }
+    return ESP_OK;
+}
+
+uint8_t th_sensor_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0xFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+uint32_t th_sensor_delay_ticks(uint16_t ms) {
+    /* 向上取整，再加一个节拍抵消 vTaskDelay 第一个节拍不完整的部分 */
+    return (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS + 1;
+}
@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "timebase.h"
+#include "common.h"
+#include "esp_timer.h"
+#include "history.h"
+#include "rtc.h"
+
+/* Private function declarations */
+static int64_t now_us_locked(int64_t us);
+static uint32_t now_locked(int64_t us);
+static void anchor_locked(int64_t wall_us, int64_t us);
+static int64_t slew_left_locked(int64_t us);
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d);
+
+/* Private variables */
+/*
+ * 时钟 = 锚点时间 + (esp_timer - 锚点) * (1 + 漂移) - 已消化的回拨量，内部以微秒计，
+ * 避免整秒量化淹没 ppm 级的漂移。每次设置或校时都重新取锚点。
+ */
+static int64_t anchor_wall_us;
+static int64_t anchor_us;
+static int64_t slew_us;         // 锚点处需要回拨的总量，从锚点起逐渐消化
+static uint32_t last_out;       // 保证输出单调不减，校时也不会让它倒退
+static int64_t last_sync_us;    // 上次校时对齐后的时钟值
+static struct timebase_status status;
+static portMUX_TYPE tb_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Private functions */
+/* 以下 *_locked 函数的调用方需持有 tb_lock */
+static int64_t now_us_locked(int64_t us) {
+    int64_t elapsed_us = us - anchor_us;
+
+    /* 先换算成毫秒再乘 ppb，一年内不会溢出 */
+    return anchor_wall_us + elapsed_us + elapsed_us / 1000 * status.drift_ppb / 1000000 -
+           (slew_us - slew_left_locked(us));
+}
+
+/* 尚未消化的回拨量: 时钟以 (1 - 1/TIMEBASE_SLEW_DIV) 的速率走，直到追平参考 */
+static int64_t slew_left_locked(int64_t us) {
+    int64_t paid = (us - anchor_us) / TIMEBASE_SLEW_DIV;
+
+    return paid < slew_us ? slew_us - paid : 0;
+}
+
+static uint32_t now_locked(int64_t us) {
+    uint32_t t = (uint32_t)(now_us_locked(us) / 1000000);
+
+    if (t < last_out) {
+        t = last_out;
+    }
+    last_out = t;
+    return t;
+}
+
+static void anchor_locked(int64_t wall_us, int64_t us) {
+    anchor_wall_us = wall_us;
+    anchor_us = us;
+    slew_us = 0;
+    if ((uint32_t)(wall_us / 1000000) > last_out) {
+        last_out = (uint32_t)(wall_us / 1000000);
+    }
+}
+
+/* 公历日期与 1970-01-01 起的天数互转 (H. Hinnant 算法) */
+static int32_t days_from_civil(int32_t y, uint32_t m, uint32_t d) {
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+/* Public functions */
+void timebase_init(uint32_t floor) {
+    taskENTER_CRITICAL(&tb_lock);
+    anchor_locked((int64_t)floor * 1000000, 0);     // 从启动开始计时
+    taskEXIT_CRITICAL(&tb_lock);
+}
+
+uint32_t timebase_now(void) {
+    int64_t us = esp_timer_get_time();
+    uint32_t t;
+
+    taskENTER_CRITICAL(&tb_lock);
+    t = now_locked(us);
+    taskEXIT_CRITICAL(&tb_lock);
+    return t;
+}
+
+uint64_t timebase_now_ms(void) {
+    int64_t us = esp_timer_get_time();
+    int64_t wall_us;
+
+    taskENTER_CRITICAL(&tb_lock);
+    wall_us = now_us_locked(us);
+    taskEXIT_CRITICAL(&tb_lock);
+    return wall_us < 0 ? 0 : (uint64_t)wall_us / 1000;
+}
+
+void timebase_set(uint32_t now) {
+    int64_t us = esp_timer_get_time();
+    uint32_t current;
+
+    taskENTER_CRITICAL(&tb_lock);
+    current = now_locked(us);
+    if (now >= current) {
+        anchor_locked((int64_t)now * 1000000, us);
+    }
+    taskEXIT_CRITICAL(&tb_lock);
+
+    if (now < current) {
+        ESP_LOGW(TAG, "忽略倒退的时间 %lu (当前 %lu)", (unsigned long)now,
+                 (unsigned long)current);
+    }
+}
+
+int32_t timebase_sync(uint32_t ref, uint8_t frac256) {
+    int64_t us = esp_timer_get_time();
+    int64_t ref_us = (int64_t)ref * 1000000 + frac256 * 1000000 / 256;
+    int64_t local_us;
+    int64_t slew_left_us;
+    uint32_t local;
+    int64_t offset_us;
+    int32_t offset;
+
+    taskENTER_CRITICAL(&tb_lock);
+    local_us = now_us_locked(us);
+    local = now_locked(us);
+    slew_left_us = slew_left_locked(us);
+    taskEXIT_CRITICAL(&tb_lock);
+    offset_us = ref_us - local_us;
+    offset = (int32_t)((offset_us + (offset_us >= 0 ? 500000 : -500000)) / 1000000);
+
+    if (status.synced) {
+        int64_t elapsed_us = local_us - last_sync_us;
+
+        /*
+         * 偏差是在现有补偿下累积的，换算成残余漂移后以 1/2 权重并入估计。
+         * 上次回拨尚未消化完的部分不属于漂移，按已对齐到参考的时钟计算。
+         */
+        if (elapsed_us >= (int64_t)TIMEBASE_MIN_DRIFT_INTERVAL_S * 1000000) {
+            int64_t residual_us = offset_us + slew_left_us;
+            int64_t drift = status.drift_ppb + residual_us * 1000 / (elapsed_us / 1000000) / 2;
+            if (drift > TIMEBASE_MAX_DRIFT_PPB) {
+                drift = TIMEBASE_MAX_DRIFT_PPB;
+            } else if (drift < -TIMEBASE_MAX_DRIFT_PPB) {
+                drift = -TIMEBASE_MAX_DRIFT_PPB;
+            }
+            status.drift_ppb = (int32_t)drift;
+        }
+
+        /* 偏差自上次校时起线性累积，按比例修正其间的记录 */
+        if (offset != 0) {
+            history_adjust_ts((uint32_t)(last_sync_us / 1000000), local, offset, true);
+        }
+    } else if (offset != 0) {
+        /* 首次校时前的时钟没有参考，整体平移 */
+        history_adjust_ts(0, local, offset, false);
+    }
+
+    /*
+     * 对齐到参考时间。本地偏快时不倒退: 锚点保持在本地时间，偏差记为回拨量，
+     * 由 now_us_locked 逐渐消化，flash 日志和历史缓冲区的时间戳因此保持单调。
+     */
+    taskENTER_CRITICAL(&tb_lock);
+    if (offset_us >= 0) {
+        anchor_locked(ref_us, us);
+    } else {
+        anchor_locked(local_us, us);
+        slew_us = -offset_us;
+    }
+    taskEXIT_CRITICAL(&tb_lock);
+
+    last_sync_us = ref_us;
+    status.synced = true;
+    status.sync_count++;
+    /* 首次校时的偏差可达数十年，限幅到 int32 */
+    offset_us /= 1000;
+    status.last_offset_ms = offset_us > INT32_MAX ? INT32_MAX :
+                            offset_us < INT32_MIN ? INT32_MIN : (int32_t)offset_us;
+
+#if CONFIG_RTC_PCF8563
+    if (rtc_set_time(ref) != ESP_OK) {
+        ESP_LOGW(TAG, "写入 RTC 时间失败");
+    }
+#endif
+
+    ESP_LOGI(TAG, "网关校时: %lu，偏差 %ld ms，漂移估计 %ld ppb", (unsigned long)ref,
+             (long)status.last_offset_ms, (long)status.drift_ppb);
+    return offset;
+}
+
+void timebase_get_status(struct timebase_status *out) { *out = status; }
+
+void timebase_to_civil(uint32_t t, struct timebase_civil *civil) {
+    int32_t z = (int32_t)(t / 86400) + 719468;
+    uint32_t sod = t % 86400;
+    int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+
+    civil->day = doy - (153 * mp + 2) / 5 + 1;
+    civil->month = mp < 10 ? mp + 3 : mp - 9;
+    civil->year = (int32_t)yoe + era * 400 + (civil->month <= 2);
+    civil->hour = sod / 3600;
+    civil->minute = (sod / 60) % 60;
+    civil->second = sod % 60;
+    civil->weekday = (t / 86400 + 3) % 7 + 1;   // 1970-01-01 为星期四
+}
+
+bool timebase_civil_valid(const struct timebase_civil *civil) {
+    static const uint8_t month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    uint16_t y = civil->year;
+    uint8_t days;
+
+    if (y < 1970 || y > TIMEBASE_YEAR_MAX || civil->month < 1 || civil->month > 12) {
+        return false;
+    }
+    days = month_days[civil->month - 1];
+    if (civil->month == 2 && y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) {
+        days = 29;
+    }
+    return civil->day >= 1 && civil->day <= days && civil->hour <= 23 &&
+           civil->minute <= 59 && civil->second <= 59;
+}
+
+uint32_t timebase_from_civil(const struct timebase_civil *civil) {
+    int32_t days = days_from_civil(civil->year, civil->month, civil->day);
+
+    return (uint32_t)days * 86400 + civil->hour * 3600 + civil->minute * 60 + civil->second;
+}
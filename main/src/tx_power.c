@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* 头文件包含 */
+#include "tx_power.h"
+#include "common.h"
+#include "esp_bt.h"
+
+/* 私有函数声明 */
+static int8_t level_to_dbm(int level);
+static int dbm_to_level(int dbm);
+static void apply_conn_level(uint16_t conn_handle, int level);
+
+/* 私有变量 */
+/* 各目标芯片 esp_power_level_t 枚举值对应的 dBm */
+#if CONFIG_IDF_TARGET_ESP32
+static const int8_t level_dbm[] = {-12, -9, -6, -3, 0, 3, 6, 9};
+#elif CONFIG_IDF_TARGET_ESP32C3 || CONFIG_IDF_TARGET_ESP32S3
+static const int8_t level_dbm[] = {-24, -21, -18, -15, -12, -9, -6, -3,
+                                   0,   3,   6,   9,   12,  15,  18, 21};
+#else
+static const int8_t level_dbm[] = {-24, -21, -18, -15, -12, -9, -6, -3,
+                                   0,   3,   6,   9,   12,  15,  18, 20};
+#endif
+#define LEVEL_COUNT (sizeof(level_dbm) / sizeof(level_dbm[0]))
+
+static struct {
+    uint16_t conn_handle;
+    int level;
+} conns[CONFIG_BT_NIMBLE_MAX_CONNECTIONS] = {
+    [0 ... CONFIG_BT_NIMBLE_MAX_CONNECTIONS - 1] = {.conn_handle = BLE_HS_CONN_HANDLE_NONE},
+};
+
+static int adv_level;
+static int8_t last_rssi = 127;
+static uint16_t adjustments;
+
+/* 私有函数 */
+static int8_t level_to_dbm(int level) { return level_dbm[level]; }
+
+/* 不超过 dbm 的最大档位 */
+static int dbm_to_level(int dbm) {
+    int level = 0;
+
+    for (int i = 0; i < LEVEL_COUNT; i++) {
+        if (level_dbm[i] <= dbm) {
+            level = i;
+        }
+    }
+    return level;
+}
+
+static void apply_conn_level(uint16_t conn_handle, int level) {
+    esp_err_t err;
+
+    /* 连接功率按连接句柄索引设置 */
+    if (conn_handle > ESP_BLE_PWR_TYPE_CONN_HDL8 - ESP_BLE_PWR_TYPE_CONN_HDL0) {
+        return;
+    }
+    err = esp_ble_tx_power_set(ESP_BLE_PWR_TYPE_CONN_HDL0 + conn_handle,
+                               (esp_power_level_t)level);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "设置连接发射功率失败，错误码: %d", err);
+    }
+}
+
+/* 公有函数 */
+void tx_power_adv_init(void) {
+    esp_err_t err;
+
+    adv_level = dbm_to_level(CONFIG_TX_POWER_ADV_DBM);
+    err = esp_ble_tx_power_set(ESP_BLE_PWR_TYPE_ADV, (esp_power_level_t)adv_level);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "设置广播发射功率失败，错误码: %d", err);
+        return;
+    }
+    ESP_LOGI(TAG, "广播发射功率: %d dBm", level_to_dbm(adv_level));
+}
+
+void tx_power_conn_start(uint16_t conn_handle) {
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (conns[i].conn_handle == BLE_HS_CONN_HANDLE_NONE ||
+            conns[i].conn_handle == conn_handle) {
+            /* 从最大功率开始，逐步降到目标余量 */
+            conns[i].conn_handle = conn_handle;
+            conns[i].level = dbm_to_level(CONFIG_TX_POWER_CONN_MAX_DBM);
+            apply_conn_level(conn_handle, conns[i].level);
+            return;
+        }
+    }
+}
+
+void tx_power_conn_stop(uint16_t conn_handle) {
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (conns[i].conn_handle == conn_handle) {
+            conns[i].conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        }
+    }
+}
+
+/*
+ * 假设上下行路径损耗对称: 对端收到的功率 ≈ 本端发射功率 - (对端发射功率 - RSSI)。
+ * 余量高于目标+迟滞时降一档，低于目标时升一档。
+ */
+void tx_power_update(void) {
+#if CONFIG_TX_POWER_CONTROL
+    int min_level = dbm_to_level(CONFIG_TX_POWER_CONN_MIN_DBM);
+    int max_level = dbm_to_level(CONFIG_TX_POWER_CONN_MAX_DBM);
+
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        int8_t rssi;
+        int margin;
+        int level = conns[i].level;
+
+        if (conns[i].conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+            continue;
+        }
+        if (ble_gap_conn_rssi(conns[i].conn_handle, &rssi) != 0) {
+            continue;
+        }
+        last_rssi = rssi;
+
+        margin = level_to_dbm(level) - CONFIG_TX_POWER_PEER_DBM + rssi -
+                 TX_POWER_RX_SENSITIVITY_DBM;
+        if (margin > CONFIG_TX_POWER_TARGET_MARGIN_DB + TX_POWER_HYSTERESIS_DB &&
+            level > min_level) {
+            level--;
+        } else if (margin < CONFIG_TX_POWER_TARGET_MARGIN_DB && level < max_level) {
+            level++;
+        }
+
+        if (level != conns[i].level) {
+            conns[i].level = level;
+            adjustments++;
+            apply_conn_level(conns[i].conn_handle, level);
+            ESP_LOGI(TAG, "连接发射功率调整；conn_handle=%d rssi=%d 余量=%d dB 功率=%d dBm",
+                     conns[i].conn_handle, rssi, margin, level_to_dbm(level));
+        }
+    }
+#endif
+}
+
+void tx_power_on_tx_error(uint16_t conn_handle) {
+#if CONFIG_TX_POWER_CONTROL
+    int max_level = dbm_to_level(CONFIG_TX_POWER_CONN_MAX_DBM);
+
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (conns[i].conn_handle == conn_handle && conns[i].level < max_level) {
+            conns[i].level++;
+            adjustments++;
+            apply_conn_level(conn_handle, conns[i].level);
+            ESP_LOGW(TAG, "发送失败，提高连接发射功率；conn_handle=%d 功率=%d dBm",
+                     conn_handle, level_to_dbm(conns[i].level));
+        }
+    }
+#endif
+}
+
+void tx_power_get_diag(struct tx_power_diag *diag) {
+    diag->conn_dbm = 0;
+    for (int i = 0; i < CONFIG_BT_NIMBLE_MAX_CONNECTIONS; i++) {
+        if (conns[i].conn_handle != BLE_HS_CONN_HANDLE_NONE) {
+            diag->conn_dbm = level_to_dbm(conns[i].level);
+            break;
+        }
+    }
+    diag->adv_dbm = level_to_dbm(adv_level);
+    diag->last_rssi = last_rssi;
+    diag->adjustments = adjustments;
+}
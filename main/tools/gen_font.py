@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Unlicense OR CC0-1.0
+"""
+构建时字体生成器。
+
+字形以笔画(折线)描述在 10 单位高的设计网格上，按需要的像素高度栅格化，
+输出 1bpp 位图的 C 源文件，位图以 const 数组放在 flash rodata 中。
+
+用法: gen_font.py -o font_data.c small:16 large:40
+"""
+
+import argparse
+import math
+
+# 字符 -> (设计宽度, [折线...])，每条折线为若干 (x, y) 点，y 向下，0 为顶，10 为基线
+GLYPHS = {
+    ' ': (3, []),
+    '0': (6, [[(0, 0), (6, 0), (6, 10), (0, 10), (0, 0)]]),
+    '1': (6, [[(1, 1.5), (3, 0), (3, 10)]]),
+    '2': (6, [[(0, 0), (6, 0), (6, 5), (0, 5), (0, 10), (6, 10)]]),
+    '3': (6, [[(0, 0), (6, 0), (6, 10), (0, 10)], [(1, 5), (6, 5)]]),
+    '4': (6, [[(0, 0), (0, 5), (6, 5)], [(6, 0), (6, 10)]]),
+    '5': (6, [[(6, 0), (0, 0), (0, 5), (6, 5), (6, 10), (0, 10)]]),
+    '6': (6, [[(6, 0), (0, 0), (0, 10), (6, 10), (6, 5), (0, 5)]]),
+    '7': (6, [[(0, 0), (6, 0), (6, 10)]]),
+    '8': (6, [[(0, 0), (6, 0), (6, 10), (0, 10), (0, 0)], [(0, 5), (6, 5)]]),
+    '9': (6, [[(6, 5), (0, 5), (0, 0), (6, 0), (6, 10), (0, 10)]]),
+    '.': (1, [[(0.5, 10), (0.5, 10)]]),
+    '-': (5, [[(0.5, 5), (4.5, 5)]]),
+    ':': (1, [[(0.5, 3), (0.5, 3)], [(0.5, 8), (0.5, 8)]]),
+    '%': (7, [[(0, 10), (7, 0)], [(1, 1), (1, 2)], [(6, 8), (6, 9)]]),
+    '\'': (3, [[(0, 0), (2.5, 0), (2.5, 2.5), (0, 2.5), (0, 0)]]),    # 度数符号
+    'C': (6, [[(6, 0), (0, 0), (0, 10), (6, 10)]]),
+    'H': (6, [[(0, 0), (0, 10)], [(6, 0), (6, 10)], [(0, 5), (6, 5)]]),
+    '*': (5, [[(0, 2.5), (5, 7.5), (2.5, 10), (2.5, 0), (5, 2.5), (0, 7.5)]]),  # 蓝牙图标
+}
+
+
+def seg_dist(px, py, a, b):
+    ax, ay = a
+    bx, by = b
+    dx, dy = bx - ax, by - ay
+    l2 = dx * dx + dy * dy
+    t = 0 if l2 == 0 else max(0, min(1, ((px - ax) * dx + (py - ay) * dy) / l2))
+    return math.hypot(px - (ax + t * dx), py - (ay + t * dy))
+
+
+def rasterize(height, width_units, strokes):
+    """返回 (像素宽度, 行列表)，每行是 0/1 列表"""
+    thick = max(1.0, round(height * 0.1))
+    scale = (height - thick) / 10.0
+    pad = thick / 2
+    width = int(math.ceil(width_units * scale + thick))
+    rows = []
+    for y in range(height):
+        row = []
+        for x in range(width):
+            # 像素中心换算到设计网格
+            ux = (x + 0.5 - pad) / scale
+            uy = (y + 0.5 - pad) / scale
+            ink = any(seg_dist(ux, uy, line[i], line[i + 1]) * scale <= thick / 2
+                      for line in strokes for i in range(len(line) - 1))
+            row.append(1 if ink else 0)
+        rows.append(row)
+    return width, rows
+
+
+def emit_font(out, name, height):
+    chars = ''.join(GLYPHS.keys())
+    spacing = max(1, height // 8)
+    bitmap = []
+    glyphs = []
+    for ch in chars:
+        units, strokes = GLYPHS[ch]
+        width, rows = rasterize(height, units, strokes)
+        glyphs.append((len(bitmap), width, ch))
+        for row in rows:
+            for i in range(0, width, 8):
+                byte = 0
+                for bit, v in enumerate(row[i:i + 8]):
+                    byte |= v << (7 - bit)
+                bitmap.append(byte)
+
+    out.write('static const uint8_t %s_bitmap[%d] = {\n' % (name, len(bitmap)))
+    for i in range(0, len(bitmap), 12):
+        out.write('    ' + ', '.join('0x%02x' % b for b in bitmap[i:i + 12]) + ',\n')
+    out.write('};\n\n')
+    out.write('static const struct font_glyph %s_glyphs[%d] = {\n' % (name, len(glyphs)))
+    for offset, width, ch in glyphs:
+        out.write('    {%d, %d},   // %r\n' % (offset, width, ch))
+    out.write('};\n\n')
+    out.write('const struct font %s = {\n' % name)
+    out.write('    .height = %d,\n' % height)
+    out.write('    .spacing = %d,\n' % spacing)
+    out.write('    .chars = "%s",\n' % chars.replace('\\', '\\\\').replace('"', '\\"'))
+    out.write('    .glyphs = %s_glyphs,\n' % name)
+    out.write('    .bitmap = %s_bitmap,\n' % name)
+    out.write('};\n\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('-o', '--output', required=True)
+    parser.add_argument('fonts', nargs='+', help='名称:像素高度，如 small:16')
+    args = parser.parse_args()
+
+    with open(args.output, 'w', encoding='utf-8') as out:
+        out.write('/* 由 tools/gen_font.py 生成，请勿手工修改 */\n')
+        out.write('#include "font.h"\n\n')
+        for spec in args.fonts:
+            name, height = spec.split(':')
+            emit_font(out, 'font_' + name, int(height))
+
+
+if __name__ == '__main__':
+    main()
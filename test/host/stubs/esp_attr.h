@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+/* 主机上 .noinit 变量与普通静态变量一样清零，即每个测试进程都是一次上电复位 */
+#define __NOINIT_ATTR
+#define IRAM_ATTR
+
+#endif // ESP_ATTR_H
@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "fake_nvs.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "nvs_flash.h"
+
+/* Defines */
+#define FAKE_NVS_ENTRIES 16
+#define FAKE_NVS_NAME_MAX 16
+#define FAKE_NVS_BLOB_MAX 64
+
+/* Private types */
+struct nvs_entry {
+    char ns[FAKE_NVS_NAME_MAX];
+    char key[FAKE_NVS_NAME_MAX];
+    size_t len;             // 0 表示空闲
+    uint8_t data[FAKE_NVS_BLOB_MAX];
+};
+
+struct nvs_open_ns {
+    char ns[FAKE_NVS_NAME_MAX];
+    nvs_open_mode_t mode;
+};
+
+/* Private function declarations */
+static struct nvs_entry *find(nvs_handle_t handle, const char *key);
+
+/* Private variables */
+static struct nvs_entry *entries;
+static struct nvs_open_ns handles[4];
+
+/* Private functions */
+static struct nvs_entry *find(nvs_handle_t handle, const char *key) {
+    for (int i = 0; i < FAKE_NVS_ENTRIES; i++) {
+        if (entries[i].len != 0 && strcmp(entries[i].ns, handles[handle].ns) == 0 &&
+            strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* Public functions */
+void fake_nvs_init(void) {
+    entries = mmap(NULL, FAKE_NVS_ENTRIES * sizeof(entries[0]), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (entries == MAP_FAILED) {
+        abort();
+    }
+    memset(entries, 0, FAKE_NVS_ENTRIES * sizeof(entries[0]));
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle) {
+    if (entries == NULL || strlen(name) >= FAKE_NVS_NAME_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (nvs_handle_t h = 0; h < sizeof(handles) / sizeof(handles[0]); h++) {
+        if (handles[h].ns[0] == '\0') {
+            strcpy(handles[h].ns, name);
+            handles[h].mode = mode;
+            *handle = h;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length) {
+    struct nvs_entry *e = find(handle, key);
+
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out == NULL) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out, e->data, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                       size_t length) {
+    struct nvs_entry *e = find(handle, key);
+
+    if (handles[handle].mode != NVS_READWRITE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (length == 0 || length > FAKE_NVS_BLOB_MAX || strlen(key) >= FAKE_NVS_NAME_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (int i = 0; e == NULL && i < FAKE_NVS_ENTRIES; i++) {
+        if (entries[i].len == 0) {
+            e = &entries[i];
+            strcpy(e->ns, handles[handle].ns);
+            strcpy(e->key, key);
+        }
+    }
+    if (e == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(e->data, value, length);
+    e->len = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    struct nvs_entry *e = find(handle, key);
+
+    if (handles[handle].mode != NVS_READWRITE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    e->len = 0;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+void nvs_close(nvs_handle_t handle) { handles[handle].ns[0] = '\0'; }
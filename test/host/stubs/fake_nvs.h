@@ -0,0 +1,16 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef FAKE_NVS_H
+#define FAKE_NVS_H
+
+/* Public function declarations */
+/*
+ * 清空模拟的 NVS。与 fake_partition 一样放在共享映射中，
+ * 内容在 test_boot 启动的子进程之间保留，相当于同一台设备重启。
+ */
+void fake_nvs_init(void);
+
+#endif // FAKE_NVS_H
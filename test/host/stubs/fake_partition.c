@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "fake_partition.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "esp_partition.h"
+
+/* Private variables */
+static esp_partition_t part = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = 0x40,
+    .label = "history",
+};
+static uint8_t *flash;
+static uint32_t reads;
+static uint32_t writes;
+static uint32_t cut_nth;
+static size_t cut_bytes;
+
+/* Public functions */
+void fake_partition_init(size_t size) {
+    flash = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (flash == MAP_FAILED) {
+        abort();
+    }
+    memset(flash, 0xFF, size);
+    part.size = size;
+}
+
+uint8_t *fake_partition_data(void) { return flash; }
+
+uint32_t fake_partition_reads(void) { return reads; }
+
+void fake_partition_cut_power(uint32_t nth, size_t bytes) {
+    writes = 0;
+    cut_nth = nth;
+    cut_bytes = bytes;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, int subtype,
+                                                const char *label) {
+    if (flash == NULL || type != part.type || subtype != part.subtype ||
+        strcmp(label, part.label) != 0) {
+        return NULL;
+    }
+    return &part;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *p, size_t offset, void *dst,
+                             size_t size) {
+    if (offset + size > p->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    reads++;
+    memcpy(dst, flash + offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *p, size_t offset,
+                              const void *src, size_t size) {
+    const uint8_t *s = src;
+
+    if (offset + size > p->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (++writes == cut_nth) {
+        size = cut_bytes;
+    }
+    for (size_t i = 0; i < size; i++) {
+        flash[offset + i] &= s[i];
+    }
+    if (writes == cut_nth) {
+        _exit(0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t offset,
+                                    size_t size) {
+    if (offset + size > p->size || offset % 4096 != 0 || size % 4096 != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(flash + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *p, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle) {
+    if (offset + size > p->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_ptr = flash + offset;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {}
@@ -0,0 +1,30 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef FAKE_PARTITION_H
+#define FAKE_PARTITION_H
+
+/* Includes */
+/* STD APIs */
+#include <stddef.h>
+#include <stdint.h>
+
+/* Public function declarations */
+/*
+ * 创建 size 字节的擦除态(0xFF)模拟分区。内容放在共享映射中，
+ * test_boot 启动的子进程与父进程看到同一片 flash。
+ * 与 NOR flash 一样，写入只能把 1 变成 0。
+ */
+void fake_partition_init(size_t size);
+
+uint8_t *fake_partition_data(void);
+
+/* 本进程累计的读取次数，用于检查算法的 flash 访问量 */
+uint32_t fake_partition_reads(void);
+
+/* 本进程第 nth 次写入(从 1 开始)只写前 bytes 字节，随后进程立即退出，模拟掉电 */
+void fake_partition_cut_power(uint32_t nth, size_t bytes);
+
+#endif // FAKE_PARTITION_H
@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+/* 主机测试使用的配置，取值偏小以便少量数据就能覆盖块/扇区边界 */
+#define CONFIG_HISTORY_RAM_BUDGET 8192
+#define CONFIG_FLASH_LOG_BATCH 16
+#define CONFIG_FLEET_SLOTS 1
+#define CONFIG_FLEET_SLOT_PERIOD_S 60
+#define CONFIG_FLEET_SLOT_BURST_MS 500
+#define CONFIG_FLEET_SLOT_ADV_ITVL_MS 100
+#define CONFIG_TH_SENSOR_AUTO 1
+#define CONFIG_TH_SENSOR_DISAGREE_TEMP 50
+#define CONFIG_TH_SENSOR_DISAGREE_HUMI 300
+
+#endif // SDKCONFIG_H
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "esp_rom_crc.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+/* Private variables */
+static int mutex_dummy;
+
+/* Public functions */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return &mutex_dummy; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) { return pdTRUE; }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return pdTRUE; }
+
+TickType_t stub_delayed_ticks;
+
+void vTaskDelay(TickType_t ticks) { stub_delayed_ticks += ticks; }
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "comfort.h"
+#include <math.h>
+#include <stdlib.h>
+#include "esp_cpu.h"
+#include "test_util.h"
+
+/* Defines */
+/* 扫描传感器量程: -40..85 °C 与 0..100 %RH，步长 0.1 */
+#define T_MIN -4000
+#define T_MAX 8500
+#define RH_MAX 10000
+#define STEP 10
+
+#define DEW_POINT_TOL 10    // 0.1 °C
+#define ABS_HUMI_TOL 5      // 0.05 g/m³
+
+/* Private function declarations */
+static double ref_dew_point(int32_t t, int32_t rh);
+static double ref_abs_humidity(int32_t t, int32_t rh);
+
+/* Private functions */
+/* libm 双精度参考，公式和系数与 comfort.c 相同；0 %RH 与被测实现一样按 0.01 % 计 */
+static double ref_dew_point(int32_t t, int32_t rh) {
+    double tc = t / 100.0;
+    double g = log((rh < 1 ? 1 : rh) / 10000.0) + 17.62 * tc / (243.12 + tc);
+
+    return 243.12 * g / (17.62 - g);
+}
+
+static double ref_abs_humidity(int32_t t, int32_t rh) {
+    double tc = t / 100.0;
+
+    return 216.7 * ((rh < 1 ? 1 : rh) / 10000.0 * 6.112 * exp(17.62 * tc / (243.12 + tc))) /
+           (273.15 + tc);
+}
+
+/* 露点在整个量程内与 libm 相差不超过 0.1 °C */
+static void test_dew_point(void) {
+    struct comfort_metrics m;
+    long long worst = 0;
+
+    for (int32_t t = T_MIN; t <= T_MAX; t += STEP) {
+        for (int32_t rh = 0; rh <= RH_MAX; rh += STEP) {
+            comfort_compute(t, rh, &m);
+            long long e = llabs(m.dew_point - llround(ref_dew_point(t, rh) * 100));
+            if (e > DEW_POINT_TOL) {
+                fprintf(stderr, "T=%d RH=%d: 露点 %d，参考 %.2f\n", t, rh, m.dew_point,
+                        ref_dew_point(t, rh) * 100);
+            }
+            CHECK(e <= DEW_POINT_TOL);
+            worst = e > worst ? e : worst;
+        }
+    }
+    printf("露点最大误差 %lld.%02lld °C\n", worst / 100, worst % 100);
+}
+
+/*
+ * 绝对湿度在整个量程内与 libm 相差不超过 0.05 g/m³。
+ * 85 °C 饱和时约 354 g/m³，查表插值的相对误差约 1e-4，加上 0.01 的取整。
+ */
+static void test_abs_humidity(void) {
+    struct comfort_metrics m;
+    long long worst = 0;
+
+    for (int32_t t = T_MIN; t <= T_MAX; t += STEP) {
+        for (int32_t rh = 0; rh <= RH_MAX; rh += STEP) {
+            comfort_compute(t, rh, &m);
+            long long e = llabs(m.abs_humidity - llround(ref_abs_humidity(t, rh) * 100));
+            if (e > ABS_HUMI_TOL) {
+                fprintf(stderr, "T=%d RH=%d: 绝对湿度 %u，参考 %.2f\n", t, rh,
+                        m.abs_humidity, ref_abs_humidity(t, rh) * 100);
+            }
+            CHECK(e <= ABS_HUMI_TOL);
+            worst = e > worst ? e : worst;
+        }
+    }
+    printf("绝对湿度最大误差 %lld.%02lld g/m³\n", worst / 100, worst % 100);
+}
+
+/* 超出 0..100 % 的湿度按边界值计算 */
+static void test_humidity_clamped(void) {
+    struct comfort_metrics lo, lo_ref, hi, hi_ref;
+
+    comfort_compute(2000, 0, &lo);
+    comfort_compute(2000, 1, &lo_ref);
+    CHECK_EQ(lo.dew_point, lo_ref.dew_point);
+    CHECK_EQ(lo.abs_humidity, lo_ref.abs_humidity);
+
+    comfort_compute(2000, 10500, &hi);
+    comfort_compute(2000, 10000, &hi_ref);
+    CHECK_EQ(hi.dew_point, hi_ref.dew_point);
+    CHECK_EQ(hi.abs_humidity, hi_ref.abs_humidity);
+    /* 饱和时露点等于气温 */
+    CHECK(abs(hi.dew_point - 2000) <= DEW_POINT_TOL);
+}
+
+/*
+ * 按整行计时，报告每次计算的本机周期数，与设备上 comfort_benchmark 的
+ * libm 单精度参考对比。本机数字只用于比较两种实现，不代表设备上的周期数。
+ */
+static void test_cycles_per_eval(void) {
+    struct comfort_metrics m;
+    volatile int32_t sink = 0;
+    volatile float fsink = 0;
+    uint64_t lut_cycles = 0, ref_cycles = 0;
+    uint32_t evals = 0;
+
+    for (int32_t t = T_MIN; t <= T_MAX; t += STEP) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        for (int32_t rh = 0; rh <= RH_MAX; rh += STEP) {
+            comfort_compute(t, rh, &m);
+            sink += m.dew_point + m.abs_humidity;
+        }
+        lut_cycles += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        for (int32_t rh = 0; rh <= RH_MAX; rh += STEP) {
+            float tc = t / 100.0f, r = (rh < 1 ? 1 : rh) / 10000.0f;
+            float g = logf(r) + 17.62f * tc / (243.12f + tc);
+            float ah = 216.7f * (r * 6.112f * expf(17.62f * tc / (243.12f + tc))) /
+                       (273.15f + tc);
+            fsink += 243.12f * g / (17.62f - g) + ah;
+        }
+        ref_cycles += esp_cpu_get_cycle_count() - start;
+        evals += RH_MAX / STEP + 1;
+    }
+    (void)sink;
+    (void)fsink;
+
+    printf("%lu 次计算: 查表 %.1f 周期/次，libm %.1f 周期/次\n", (unsigned long)evals,
+           (double)lut_cycles / evals, (double)ref_cycles / evals);
+    CHECK(lut_cycles > 0 && ref_cycles > 0);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_dew_point);
+    TEST_RUN(test_abs_humidity);
+    TEST_RUN(test_humidity_clamped);
+    TEST_RUN(test_cycles_per_eval);
+    return test_summary();
+}
@@ -0,0 +1,284 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "flash_log.h"
+#include "fake_partition.h"
+#include "test_util.h"
+
+/* Defines */
+#define SECTORS 4
+#define PART_SIZE (SECTORS * FLASH_LOG_SECTOR_SIZE)
+#define BLOCK_TOTAL (PART_SIZE / FLASH_LOG_BLOCK_SIZE)
+#define MAX_SAMPLES (BLOCK_TOTAL * CONFIG_FLASH_LOG_BATCH)
+#define TS0 1700000000u
+#define SHIFT_S 600
+
+/* Private function declarations */
+static struct history_sample make_sample(uint32_t seq);
+static void append_range(uint32_t from, uint32_t to);
+static size_t read_all(struct history_sample *out, size_t max);
+static void check_range(const struct history_sample *got, size_t n, uint32_t from);
+static uint32_t shift_before(uint32_t seq, uint32_t ts);
+
+/* Private variables */
+static struct history_sample buf[MAX_SAMPLES];
+static uint32_t shift_end;
+
+/* Private functions */
+/* 间隔 60 秒，偶尔抖动 1 秒，温湿度缓慢变化，接近真实数据的压缩特性 */
+static struct history_sample make_sample(uint32_t seq) {
+    struct history_sample s = {
+        .seq = seq,
+        .ts = TS0 + seq * 60 + (seq % 7 == 0),
+        .temp = (int16_t)(2000 + (int)(seq * 37 % 200) - 100),
+        .humi = (uint16_t)(5000 + seq % 50),
+        .batt = (uint8_t)(100 - seq / 100 % 100),
+    };
+    return s;
+}
+
+static void append_range(uint32_t from, uint32_t to) {
+    for (uint32_t seq = from; seq < to; seq++) {
+        struct history_sample s = make_sample(seq);
+        flash_log_append(&s);
+    }
+}
+
+/* 按块顺序读出全部已落盘记录，校验失败的块跳过 */
+static size_t read_all(struct history_sample *out, size_t max) {
+    struct flash_log_block_hdr hdr;
+    size_t n = 0;
+
+    for (uint32_t b = flash_log_first_block(); b != FLASH_LOG_BLOCK_NONE;
+         b = flash_log_next_block(b)) {
+        int got = flash_log_read_block(b, &hdr, out + n, max - n);
+        if (got > 0) {
+            n += got;
+        }
+    }
+    return n;
+}
+
+/* 读出的记录须从 from 起序号连续，且与写入的内容完全一致 */
+static void check_range(const struct history_sample *got, size_t n, uint32_t from) {
+    for (size_t i = 0; i < n; i++) {
+        struct history_sample want = make_sample(from + i);
+        CHECK_EQ(got[i].seq, want.seq);
+        CHECK_EQ(got[i].ts, want.ts);
+        CHECK_EQ(got[i].temp, want.temp);
+        CHECK_EQ(got[i].humi, want.humi);
+        CHECK_EQ(got[i].batt, want.batt);
+    }
+}
+
+/* 模拟校时: 序号小于 shift_end 的记录时钟偏快 SHIFT_S 秒 */
+static uint32_t shift_before(uint32_t seq, uint32_t ts) {
+    return seq < shift_end ? ts - SHIFT_S : ts;
+}
+
+static void test_missing_partition(void) { CHECK_EQ(flash_log_init(), ESP_ERR_NOT_FOUND); }
+
+static void test_empty(void) {
+    struct history_sample last;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK_EQ(flash_log_first_block(), FLASH_LOG_BLOCK_NONE);
+    CHECK_EQ(flash_log_end_seq(), 0);
+    CHECK_EQ(flash_log_last_ts(), 0);
+    CHECK_EQ(flash_log_last(&last), -1);
+}
+
+static void test_append_read_back(void) {
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, 100);
+
+    /* 凑满一批才落盘，未满的部分只在暂存块中 */
+    CHECK_EQ(flash_log_end_seq(), 100 / CONFIG_FLASH_LOG_BATCH * CONFIG_FLASH_LOG_BATCH);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+    CHECK_EQ(flash_log_end_seq(), 100);
+    CHECK_EQ(flash_log_last_ts(), make_sample(99).ts);
+
+    n = read_all(buf, MAX_SAMPLES);
+    CHECK_EQ(n, 100);
+    check_range(buf, n, 0);
+}
+
+static void boot_write_50_then_stage_5(void) {
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, 50);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+    append_range(50, 55);
+}
+
+/* 上电复位后暂存块失效，已落盘的记录全部保留，新记录接着最后的序号写 */
+static void test_power_cycle(void) {
+    struct history_sample last;
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    test_boot(boot_write_50_then_stage_5);
+
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK(!flash_log_stage_intact());
+    CHECK_EQ(flash_log_end_seq(), 50);
+    CHECK_EQ(flash_log_last_ts(), make_sample(49).ts);
+    CHECK_EQ(flash_log_last(&last), 0);
+    CHECK_EQ(last.seq, 49);
+    CHECK_EQ(last.temp, make_sample(49).temp);
+
+    append_range(50, 80);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+    n = read_all(buf, MAX_SAMPLES);
+    CHECK_EQ(n, 80);
+    check_range(buf, n, 0);
+}
+
+/* 软件复位时 RAM 不清零，重新初始化会把暂存的记录作为一个块写出 */
+static void test_soft_reset_keeps_stage(void) {
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, CONFIG_FLASH_LOG_BATCH + 4);
+    CHECK_EQ(flash_log_end_seq(), CONFIG_FLASH_LOG_BATCH);
+
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK(flash_log_stage_intact());
+    CHECK_EQ(flash_log_end_seq(), CONFIG_FLASH_LOG_BATCH + 4);
+    n = read_all(buf, MAX_SAMPLES);
+    CHECK_EQ(n, CONFIG_FLASH_LOG_BATCH + 4);
+    check_range(buf, n, 0);
+}
+
+static void boot_torn_second_block(void) {
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, CONFIG_FLASH_LOG_BATCH);
+    /* 第二个块写完块头和几个字节的载荷就掉电 */
+    fake_partition_cut_power(1, sizeof(struct flash_log_block_hdr) + 4);
+    append_range(CONFIG_FLASH_LOG_BATCH, 2 * CONFIG_FLASH_LOG_BATCH);
+    CHECK(0);
+}
+
+/* 写入中途掉电只留下一个校验失败的块，恢复后被跳过 */
+static void test_torn_write(void) {
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    test_boot(boot_torn_second_block);
+
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK_EQ(flash_log_end_seq(), CONFIG_FLASH_LOG_BATCH);
+    append_range(CONFIG_FLASH_LOG_BATCH, 3 * CONFIG_FLASH_LOG_BATCH);
+
+    n = read_all(buf, MAX_SAMPLES);
+    CHECK_EQ(n, 3 * CONFIG_FLASH_LOG_BATCH);
+    check_range(buf, n, 0);
+}
+
+static void boot_fill_and_wrap(void) {
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, MAX_SAMPLES + 200);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+}
+
+/* 写满后擦除最旧的扇区继续写，重启后能找回最旧块 */
+static void test_wrap_around(void) {
+    uint32_t total = MAX_SAMPLES + 200;
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    test_boot(boot_fill_and_wrap);
+
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK_EQ(flash_log_end_seq(), total);
+    n = read_all(buf, MAX_SAMPLES);
+
+    /* 至少保留除正在写的扇区之外的全部扇区 */
+    CHECK(n >= (SECTORS - 1) * FLASH_LOG_BLOCKS_PER_SECTOR * CONFIG_FLASH_LOG_BATCH);
+    CHECK(n < MAX_SAMPLES);
+    check_range(buf, n, total - n);
+}
+
+static void count_sample(const struct history_sample *sample, void *arg) {
+    struct history_sample *prev = arg;
+
+    CHECK(prev->ts == 0 || sample->seq == prev->seq + 1);
+    *prev = *sample;
+}
+
+static void test_replay(void) {
+    struct history_sample prev = {0};
+    struct history_sample last;
+    uint32_t from = make_sample(123).ts;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, 300);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+
+    CHECK_EQ(flash_log_replay(from, count_sample, &prev), 300 - 123);
+    CHECK_EQ(prev.seq, 299);
+    CHECK_EQ(flash_log_replay(make_sample(299).ts + 1, count_sample, &prev), 0);
+
+    CHECK_EQ(flash_log_last(&last), 0);
+    CHECK_EQ(last.seq, 299);
+    CHECK_EQ(last.ts, make_sample(299).ts);
+}
+
+/* 注册修正后，按时间定位、回放、解码读取和最后时间戳都用修正后的时间，原始编码不变 */
+static void test_correct(void) {
+    struct flash_log_block_hdr hdr;
+    struct history_sample prev = {0};
+    struct history_sample last;
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    size_t n;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, 300);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+    shift_end = 200;
+    flash_log_set_correct(shift_before);
+
+    n = read_all(buf, MAX_SAMPLES);
+    CHECK_EQ(n, 300);
+    for (size_t i = 0; i < n; i++) {
+        CHECK_EQ(buf[i].ts, shift_before(i, make_sample(i).ts));
+    }
+    CHECK_EQ(flash_log_read_raw(flash_log_first_block(), &hdr, payload), 0);
+    CHECK_EQ(hdr.first_ts, make_sample(0).ts);
+
+    /* 按原始时间比较会定位到更晚的块 */
+    CHECK_EQ(flash_log_seek(make_sample(100).ts - SHIFT_S), flash_log_seek_seq(100));
+    CHECK_EQ(flash_log_replay(make_sample(150).ts - SHIFT_S, count_sample, &prev), 300 - 150);
+    CHECK_EQ(prev.seq, 299);
+    CHECK_EQ(flash_log_last_ts(), make_sample(299).ts);
+
+    shift_end = 300;
+    CHECK_EQ(flash_log_last_ts(), make_sample(299).ts - SHIFT_S);
+    CHECK_EQ(flash_log_last(&last), 0);
+    CHECK_EQ(last.seq, 299);
+    CHECK_EQ(last.ts, make_sample(299).ts - SHIFT_S);
+    flash_log_set_correct(NULL);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_missing_partition);
+    TEST_RUN(test_empty);
+    TEST_RUN(test_append_read_back);
+    TEST_RUN(test_power_cycle);
+    TEST_RUN(test_soft_reset_keeps_stage);
+    TEST_RUN(test_torn_write);
+    TEST_RUN(test_wrap_around);
+    TEST_RUN(test_replay);
+    TEST_RUN(test_correct);
+    return test_summary();
+}
@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "flash_log.h"
+#include "fake_partition.h"
+#include "test_util.h"
+
+/* Defines */
+#define SECTORS 8
+#define PART_SIZE (SECTORS * FLASH_LOG_SECTOR_SIZE)
+#define BLOCK_TOTAL (PART_SIZE / FLASH_LOG_BLOCK_SIZE)
+#define TS0 1700000000u
+
+/* Private types */
+struct block_ref {
+    uint32_t block;
+    uint32_t first_ts;
+    uint32_t first_seq;
+};
+
+/* Private function declarations */
+static void append_range(uint32_t from, uint32_t to);
+static size_t scan_blocks(struct block_ref *out);
+static uint32_t linear_seek(const struct block_ref *refs, size_t n, uint32_t key, bool by_seq);
+static void check_seek_all(uint32_t total);
+
+/* Private variables */
+static struct block_ref refs[BLOCK_TOTAL];
+
+/* Private functions */
+static void append_range(uint32_t from, uint32_t to) {
+    for (uint32_t seq = from; seq < to; seq++) {
+        struct history_sample s = {
+            .seq = seq, .ts = TS0 + seq * 60 + seq % 3, .temp = 2000, .humi = 5000};
+        flash_log_append(&s);
+    }
+}
+
+/* 参考实现: 顺序读出全部有效块的首条时间戳和序号 */
+static size_t scan_blocks(struct block_ref *out) {
+    uint8_t payload[FLASH_LOG_PAYLOAD_SIZE];
+    struct flash_log_block_hdr hdr;
+    size_t n = 0;
+
+    for (uint32_t b = flash_log_first_block(); b != FLASH_LOG_BLOCK_NONE;
+         b = flash_log_next_block(b)) {
+        if (flash_log_read_raw(b, &hdr, payload) == 0) {
+            out[n++] = (struct block_ref){b, hdr.first_ts, hdr.first_seq};
+        }
+    }
+    return n;
+}
+
+/* 最后一个首条键值不大于 key 的块，key 早于全部记录时为最旧块 */
+static uint32_t linear_seek(const struct block_ref *refs, size_t n, uint32_t key, bool by_seq) {
+    uint32_t found = flash_log_first_block();
+
+    for (size_t i = 0; i < n; i++) {
+        if ((by_seq ? refs[i].first_seq : refs[i].first_ts) > key) {
+            break;
+        }
+        found = refs[i].block;
+    }
+    return found;
+}
+
+/* 对日志覆盖范围内外的每个序号及其时间戳，索引定位须与顺序扫描一致 */
+static void check_seek_all(uint32_t total) {
+    size_t n = scan_blocks(refs);
+
+    CHECK(n > 0);
+    for (uint32_t seq = 0; seq < total + 10; seq++) {
+        uint32_t ts = TS0 + seq * 60 + seq % 3;
+        uint32_t reads = fake_partition_reads();
+
+        CHECK_EQ(flash_log_seek(ts), linear_seek(refs, n, ts, false));
+        /* 只读一个扇区内的块头，与日志长度无关 */
+        CHECK(fake_partition_reads() - reads <= FLASH_LOG_BLOCKS_PER_SECTOR);
+
+        CHECK_EQ(flash_log_seek(ts - 1), linear_seek(refs, n, ts - 1, false));
+        CHECK_EQ(flash_log_seek_seq(seq), linear_seek(refs, n, seq, true));
+    }
+    CHECK_EQ(flash_log_seek(0), flash_log_first_block());
+    CHECK_EQ(flash_log_seek(UINT32_MAX), refs[n - 1].block);
+}
+
+static void test_empty(void) {
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK_EQ(flash_log_seek(TS0), FLASH_LOG_BLOCK_NONE);
+    CHECK_EQ(flash_log_seek_seq(0), FLASH_LOG_BLOCK_NONE);
+}
+
+/* 日志只占几个扇区，索引中其余扇区为空 */
+static void test_partial(void) {
+    uint32_t total = 3 * FLASH_LOG_BLOCKS_PER_SECTOR * CONFIG_FLASH_LOG_BATCH + 40;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, total);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+    check_seek_all(total);
+}
+
+static void boot_wrap(void) {
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, BLOCK_TOTAL * CONFIG_FLASH_LOG_BATCH * 2 + 77);
+    CHECK_EQ(flash_log_flush(), ESP_OK);
+}
+
+/* 回绕后最旧扇区不在分区开头；重启后索引从块头重建 */
+static void test_wrap_after_reboot(void) {
+    uint32_t total = BLOCK_TOTAL * CONFIG_FLASH_LOG_BATCH * 2 + 77;
+
+    fake_partition_init(PART_SIZE);
+    test_boot(boot_wrap);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    CHECK(flash_log_first_block() != 0);
+    check_seek_all(total);
+}
+
+/* 运行中回绕，索引随擦除和写入增量更新 */
+static void test_wrap_live(void) {
+    uint32_t total = BLOCK_TOTAL * CONFIG_FLASH_LOG_BATCH + 5 * CONFIG_FLASH_LOG_BATCH;
+
+    fake_partition_init(PART_SIZE);
+    CHECK_EQ(flash_log_init(), ESP_OK);
+    append_range(0, total);
+    check_seek_all(total);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_empty);
+    TEST_RUN(test_partial);
+    TEST_RUN(test_wrap_after_reboot);
+    TEST_RUN(test_wrap_live);
+    return test_summary();
+}
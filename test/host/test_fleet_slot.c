@@ -0,0 +1,375 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "fleet_slot.h"
+#include <string.h>
+#include <sys/mman.h>
+#include "esp_mac.h"
+#include "fake_nvs.h"
+#include "nvs_flash.h"
+#include "test_util.h"
+#include "timebase.h"
+
+/* Defines */
+#define N_DEVICES 40
+#define N_BATCHES 10    // 默认偏移按批次重复，碰撞率取平均
+#define PERIOD_MS ((uint32_t)CONFIG_FLEET_SLOT_PERIOD_S * 1000)
+#define SLOTS (PERIOD_MS / CONFIG_FLEET_SLOT_BURST_MS)
+#define T0_MS 1700000000000ull
+
+/* Private types */
+/* 每台设备的结果，放在共享映射中由各设备的子进程填写 */
+struct device_result {
+    struct fleet_slot_cfg cfg;
+    uint64_t bursts[8];     // 模拟时间线上各次突发广播的起点(毫秒)
+};
+
+/* Private function declarations */
+static void set_device(int id);
+static void set_random_device(int id);
+static struct device_result *shared_results(void);
+static void run_device(void);
+static void receive_assignment(void);
+static bool overlaps(uint64_t a, uint16_t a_len, uint64_t b, uint16_t b_len);
+static int collided_devices(void);
+static uint32_t scan_busy_ms(void);
+
+/* Private variables */
+static uint8_t fake_mac[6];
+static uint64_t fake_now_ms;
+static bool fake_synced;
+static int device;
+static struct device_result *results;
+static struct fleet_slot_cfg assigned;
+
+/* Fakes */
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+    memcpy(mac, fake_mac, sizeof(fake_mac));
+    return ESP_OK;
+}
+
+uint64_t timebase_now_ms(void) { return fake_now_ms; }
+
+void timebase_get_status(struct timebase_status *status) {
+    memset(status, 0, sizeof(*status));
+    status->synced = fake_synced;
+}
+
+/* Private functions */
+/* 同一批次出厂的设备地址只有末尾几个字节不同 */
+static void set_device(int id) {
+    static const uint8_t oui[3] = {0x58, 0xCF, 0x79};
+
+    memcpy(fake_mac, oui, sizeof(oui));
+    fake_mac[3] = 0x12;
+    fake_mac[4] = (uint8_t)(id >> 8);
+    fake_mac[5] = (uint8_t)id;
+    device = id;
+}
+
+/* 地址后三字节取伪随机值，模拟来自不同批次的设备 */
+static void set_random_device(int id) {
+    uint32_t x = (uint32_t)id * 2654435761u + 1;
+
+    set_device(id);
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fake_mac[3] = (uint8_t)(x >> 16);
+    fake_mac[4] = (uint8_t)(x >> 8);
+    fake_mac[5] = (uint8_t)x;
+}
+
+static struct device_result *shared_results(void) {
+    void *p = mmap(NULL, N_DEVICES * sizeof(struct device_result), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    CHECK(p != MAP_FAILED);
+    memset(p, 0, N_DEVICES * sizeof(struct device_result));
+    return p;
+}
+
+/* 设备以本地时钟从任意时刻开始，依次等到各时隙起点 */
+static void run_device(void) {
+    struct device_result *r = &results[device % N_DEVICES];
+
+    fleet_slot_init();
+    fleet_slot_get(&r->cfg);
+
+    fake_synced = true;
+    CHECK(fleet_slot_active());
+    fake_now_ms = T0_MS + (uint64_t)device * 7919 + 123;
+    for (size_t i = 0; i < sizeof(r->bursts) / sizeof(r->bursts[0]); i++) {
+        uint32_t wait = fleet_slot_wait_ms();
+        CHECK(wait > 0 && wait <= PERIOD_MS);
+        fake_now_ms += wait;
+        r->bursts[i] = fake_now_ms;
+        /* 突发广播结束后再算下一个时隙 */
+        fake_now_ms += r->cfg.burst_ms;
+    }
+}
+
+/* 网关通过线上格式下发时隙，设备保存后重启 */
+static void receive_assignment(void) {
+    uint8_t wire[FLEET_SLOT_WIRE_BYTES];
+    struct fleet_slot_cfg cfg;
+
+    fleet_slot_init();
+    fleet_slot_encode(&assigned, wire);
+    fleet_slot_decode(wire, &cfg);
+    CHECK_EQ(fleet_slot_set(&cfg), ESP_OK);
+}
+
+static bool overlaps(uint64_t a, uint16_t a_len, uint64_t b, uint16_t b_len) {
+    return a < b + b_len && b < a + a_len;
+}
+
+/* 与其他设备至少有一次突发重叠的设备数 */
+static int collided_devices(void) {
+    const size_t n_bursts = sizeof(results[0].bursts) / sizeof(results[0].bursts[0]);
+    int collided = 0;
+
+    for (int a = 0; a < N_DEVICES; a++) {
+        bool hit = false;
+        for (int b = 0; b < N_DEVICES && !hit; b++) {
+            for (size_t i = 0; i < n_bursts && !hit && b != a; i++) {
+                for (size_t j = 0; j < n_bursts && !hit; j++) {
+                    hit = overlaps(results[a].bursts[i], results[a].cfg.burst_ms,
+                                   results[b].bursts[j], results[b].cfg.burst_ms);
+                }
+            }
+        }
+        collided += hit;
+    }
+    return collided;
+}
+
+/* 网关每个周期需要扫描的时长: 所有设备突发窗口的并集 */
+static uint32_t scan_busy_ms(void) {
+    static bool busy[PERIOD_MS];
+    uint32_t total = 0;
+
+    memset(busy, 0, sizeof(busy));
+    for (int d = 0; d < N_DEVICES; d++) {
+        uint32_t start = (uint32_t)(results[d].bursts[0] % PERIOD_MS);
+        for (uint32_t t = 0; t < results[d].cfg.burst_ms; t++) {
+            busy[(start + t) % PERIOD_MS] = true;
+        }
+    }
+    for (uint32_t t = 0; t < PERIOD_MS; t++) {
+        total += busy[t];
+    }
+    return total;
+}
+
+/* 未校时前不按网格运行 */
+static void test_inactive_until_synced(void) {
+    fake_nvs_init();
+    set_device(1);
+    fleet_slot_init();
+    CHECK(!fleet_slot_active());
+    fake_synced = true;
+    CHECK(fleet_slot_active());
+}
+
+/*
+ * 按默认偏移运行多批设备，返回碰撞率(与其他设备同时隙的设备比例)，
+ * duty 返回网关扫描占空比的平均值。random_macs 为 false 时各批地址连续。
+ */
+static double run_default_batches(bool random_macs, double *duty) {
+    int collided = 0;
+    uint32_t busy_ms = 0;
+
+    for (int batch = 0; batch < N_BATCHES; batch++) {
+        bool used[SLOTS] = {false};
+        int distinct = 0;
+
+        for (int d = 0; d < N_DEVICES; d++) {
+            fake_nvs_init();
+            if (random_macs) {
+                set_random_device(batch * N_DEVICES + d);
+            } else {
+                set_device(batch * N_DEVICES + d);
+            }
+            test_boot(run_device);
+        }
+        for (int d = 0; d < N_DEVICES; d++) {
+            const struct fleet_slot_cfg *cfg = &results[d].cfg;
+            CHECK_EQ(cfg->period_s, CONFIG_FLEET_SLOT_PERIOD_S);
+            CHECK_EQ(cfg->burst_ms, CONFIG_FLEET_SLOT_BURST_MS);
+            CHECK(cfg->offset_ms < PERIOD_MS);
+            CHECK_EQ(cfg->offset_ms % cfg->burst_ms, 0);
+            if (!used[cfg->offset_ms / cfg->burst_ms]) {
+                used[cfg->offset_ms / cfg->burst_ms] = true;
+                distinct++;
+            }
+        }
+
+        /* 同一时隙的突发完全重合，并集恰为不同时隙数乘以突发时长 */
+        uint32_t busy = scan_busy_ms();
+        CHECK_EQ(busy, (uint32_t)distinct * CONFIG_FLEET_SLOT_BURST_MS);
+        collided += collided_devices();
+        busy_ms += busy;
+    }
+
+    *duty = (double)busy_ms / N_BATCHES / PERIOD_MS;
+    return (double)collided / (N_DEVICES * N_BATCHES);
+}
+
+/*
+ * 未分配时各设备按地址散列出默认偏移，落在突发时长对齐的网格上。
+ * 随机分配时一台设备与其余 N-1 台中至少一台同时隙的概率为生日问题的
+ * 1 - (1 - 1/S)^(N-1)，40 台设备、120 个时隙约为 27.9%。
+ * - 随机地址: 散列应与随机分配一样好，碰撞率与期望相差不超过 8 个百分点；
+ * - 连续地址(同批出厂): 碰撞率不高于期望。
+ * 网关扫描占空比为突发窗口并集除以周期，不超过 N * burst / period (1/3)，
+ * 随机地址时约为期望的不同时隙数 S * (1 - (1 - 1/S)^N) 乘以 burst / period。
+ */
+static void test_default_offsets_spread(void) {
+    const double max_duty = (double)N_DEVICES * CONFIG_FLEET_SLOT_BURST_MS / PERIOD_MS;
+    double miss_one = 1.0;
+    double expected, expected_duty, rate, duty;
+
+    for (int i = 0; i < N_DEVICES - 1; i++) {
+        miss_one *= 1.0 - 1.0 / SLOTS;
+    }
+    expected = 1.0 - miss_one;
+    expected_duty = SLOTS * (1.0 - miss_one * (1.0 - 1.0 / SLOTS)) *
+                    CONFIG_FLEET_SLOT_BURST_MS / PERIOD_MS;
+
+    results = shared_results();
+
+    rate = run_default_batches(true, &duty);
+    printf("随机地址: 碰撞率 %.3f (生日问题期望 %.3f)，扫描占空比 %.3f (期望 %.3f，上限 %.3f)\n",
+           rate, expected, duty, expected_duty, max_duty);
+    CHECK(rate >= expected - 0.08 && rate <= expected + 0.08);
+    CHECK(duty >= expected_duty - 0.03 && duty <= max_duty);
+
+    rate = run_default_batches(false, &duty);
+    printf("连续地址: 碰撞率 %.3f，扫描占空比 %.3f\n", rate, duty);
+    CHECK(rate <= expected);
+    CHECK(duty >= expected_duty - 0.03 && duty <= max_duty);
+}
+
+/*
+ * 网关为每台设备分配相邻的时隙并重启: 设备从 NVS 读回分配，
+ * 每次突发都精确落在 UTC 网格上，整个时间线上没有两台设备的突发重叠
+ */
+static void test_assigned_slots_never_collide(void) {
+    results = shared_results();
+    for (int d = 0; d < N_DEVICES; d++) {
+        fake_nvs_init();
+        set_device(d);
+        assigned = (struct fleet_slot_cfg){
+            .period_s = CONFIG_FLEET_SLOT_PERIOD_S,
+            .offset_ms = (uint32_t)d * CONFIG_FLEET_SLOT_BURST_MS,
+            .burst_ms = CONFIG_FLEET_SLOT_BURST_MS,
+        };
+        test_boot(receive_assignment);
+        test_boot(run_device);
+    }
+
+    for (int d = 0; d < N_DEVICES; d++) {
+        const struct device_result *r = &results[d];
+        CHECK_EQ(r->cfg.offset_ms, (uint32_t)d * CONFIG_FLEET_SLOT_BURST_MS);
+        for (size_t i = 0; i < sizeof(r->bursts) / sizeof(r->bursts[0]); i++) {
+            CHECK_EQ(r->bursts[i] % PERIOD_MS, r->cfg.offset_ms);
+            CHECK(i == 0 || r->bursts[i] - r->bursts[i - 1] == PERIOD_MS);
+        }
+    }
+    CHECK_EQ(collided_devices(), 0);
+
+    /* 分配后没有重叠，网关扫描占空比正好是 N * burst / period */
+    uint32_t busy = scan_busy_ms();
+    printf("分配时隙: 扫描占空比 %.3f\n", (double)busy / PERIOD_MS);
+    CHECK_EQ(busy, N_DEVICES * CONFIG_FLEET_SLOT_BURST_MS);
+}
+
+static void set_and_reject(void) {
+    static const struct fleet_slot_cfg bad[] = {
+        {9, 0, 500},            // 周期过短
+        {3601, 0, 500},         // 周期过长
+        {60, 60000, 500},       // 偏移超出周期
+        {60, 0, 99},            // 突发过短
+        {60, 0, 30001},         // 突发超过半个周期
+    };
+    struct fleet_slot_cfg good = {120, 1500, 250};
+    struct fleet_slot_cfg cfg;
+
+    fleet_slot_init();
+    CHECK_EQ(fleet_slot_set(&good), ESP_OK);
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK_EQ(fleet_slot_set(&bad[i]), ESP_ERR_INVALID_ARG);
+    }
+    fleet_slot_get(&cfg);
+    CHECK_EQ(cfg.period_s, 120);
+    CHECK_EQ(cfg.offset_ms, 1500);
+    CHECK_EQ(cfg.burst_ms, 250);
+}
+
+static void check_kept_good(void) {
+    struct fleet_slot_cfg cfg;
+
+    fleet_slot_init();
+    fleet_slot_get(&cfg);
+    CHECK_EQ(cfg.period_s, 120);
+    CHECK_EQ(cfg.offset_ms, 1500);
+    CHECK_EQ(cfg.burst_ms, 250);
+}
+
+/* 非法参数被拒绝，不影响当前和已保存的时隙 */
+static void test_reject_invalid(void) {
+    fake_nvs_init();
+    set_device(3);
+    test_boot(set_and_reject);
+    test_boot(check_kept_good);
+}
+
+/* NVS 中的记录长度不符时回退到默认偏移 */
+static void test_bad_blob_falls_back(void) {
+    struct fleet_slot_cfg cfg;
+    nvs_handle_t handle;
+    uint8_t junk[3] = {1, 2, 3};
+
+    fake_nvs_init();
+    set_device(5);
+    CHECK_EQ(nvs_open(FLEET_SLOT_NVS_NAMESPACE, NVS_READWRITE, &handle), ESP_OK);
+    CHECK_EQ(nvs_set_blob(handle, "slot", junk, sizeof(junk)), ESP_OK);
+    nvs_close(handle);
+
+    fleet_slot_init();
+    fleet_slot_get(&cfg);
+    CHECK_EQ(cfg.period_s, CONFIG_FLEET_SLOT_PERIOD_S);
+    CHECK_EQ(cfg.offset_ms % CONFIG_FLEET_SLOT_BURST_MS, 0);
+}
+
+/* 恰好位于时隙起点时等待整整一个周期，从不返回 0 */
+static void test_wait_at_slot_start(void) {
+    struct fleet_slot_cfg cfg = {60, 2500, 500};
+
+    fake_nvs_init();
+    set_device(7);
+    fleet_slot_init();
+    CHECK_EQ(fleet_slot_set(&cfg), ESP_OK);
+
+    fake_now_ms = T0_MS - T0_MS % PERIOD_MS + 2500;
+    CHECK_EQ(fleet_slot_wait_ms(), PERIOD_MS);
+    fake_now_ms += 1;
+    CHECK_EQ(fleet_slot_wait_ms(), PERIOD_MS - 1);
+    fake_now_ms -= 2;
+    CHECK_EQ(fleet_slot_wait_ms(), 1);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_inactive_until_synced);
+    TEST_RUN(test_default_offsets_spread);
+    TEST_RUN(test_assigned_slots_never_collide);
+    TEST_RUN(test_reject_invalid);
+    TEST_RUN(test_bad_blob_falls_back);
+    TEST_RUN(test_wait_at_slot_start);
+    return test_summary();
+}
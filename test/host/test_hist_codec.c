@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "hist_codec.h"
+#include <string.h>
+#include "test_util.h"
+
+/* Defines */
+#define N_SAMPLES 2000
+
+/* Private function declarations */
+static uint32_t rnd(void);
+static void round_trip(const struct history_sample *in, size_t n, size_t cap);
+
+/* Private variables */
+static uint32_t rnd_state = 0x12345678;
+static struct history_sample in[N_SAMPLES];
+static uint8_t enc_buf[N_SAMPLES * HIST_CODEC_MAX_SAMPLE_BYTES];
+
+/* Private functions */
+static uint32_t rnd(void) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* 编码 n 条记录(放不下的丢弃)，再解码并与已编码的部分逐条比较 */
+static void round_trip(const struct history_sample *in, size_t n, size_t cap) {
+    struct hist_codec_state enc;
+    struct hist_codec_state dec;
+    struct history_sample out;
+    size_t accepted = 0;
+
+    hist_codec_enc_init(&enc, enc_buf, cap);
+    for (size_t i = 0; i < n; i++) {
+        size_t before = enc.len;
+        if (hist_codec_enc_add(&enc, &in[i]) != 0) {
+            CHECK_EQ(enc.len, before);
+            break;
+        }
+        CHECK(enc.len - before <= HIST_CODEC_MAX_SAMPLE_BYTES);
+        accepted++;
+    }
+    CHECK_EQ(enc.count, accepted);
+
+    hist_codec_dec_init(&dec, enc_buf, enc.len);
+    for (size_t i = 0; i < accepted; i++) {
+        CHECK_EQ(hist_codec_dec_next(&dec, &out), 0);
+        CHECK_EQ(out.ts, in[i].ts);
+        CHECK_EQ(out.temp, in[i].temp);
+        CHECK_EQ(out.humi, in[i].humi);
+        CHECK_EQ(out.batt, in[i].batt);
+    }
+    CHECK_EQ(hist_codec_dec_next(&dec, &out), 1);
+}
+
+/* 规律采样: 固定间隔且读数不变时每条只占 1 字节标志 */
+static void test_steady_is_one_byte(void) {
+    struct hist_codec_state enc;
+
+    for (size_t i = 0; i < N_SAMPLES; i++) {
+        in[i] = (struct history_sample){
+            .ts = 1700000000u + i * 60, .temp = 2150, .humi = 4800, .batt = 87};
+    }
+    hist_codec_enc_init(&enc, enc_buf, sizeof(enc_buf));
+    for (size_t i = 0; i < N_SAMPLES; i++) {
+        CHECK_EQ(hist_codec_enc_add(&enc, &in[i]), 0);
+    }
+    /* 第一条为绝对值，第二条引入间隔，其余只有标志 */
+    CHECK(enc.len <= 2 * HIST_CODEC_MAX_SAMPLE_BYTES + (N_SAMPLES - 2));
+    round_trip(in, N_SAMPLES, sizeof(enc_buf));
+}
+
+/* 随机游走，模拟带抖动的真实数据 */
+static void test_random_walk(void) {
+    struct history_sample s = {.ts = 1700000000u, .temp = 2000, .humi = 5000, .batt = 100};
+
+    for (size_t i = 0; i < N_SAMPLES; i++) {
+        s.ts += 60 + rnd() % 5 - 2;
+        s.temp += (int16_t)(rnd() % 21) - 10;
+        s.humi += (uint16_t)(rnd() % 41) - 20;
+        if (rnd() % 50 == 0) {
+            s.batt--;
+        }
+        in[i] = s;
+    }
+    round_trip(in, N_SAMPLES, sizeof(enc_buf));
+}
+
+/* 各字段取极值并大幅跳变，单条编码不超过 HIST_CODEC_MAX_SAMPLE_BYTES */
+static void test_extremes(void) {
+    static const int16_t temps[] = {INT16_MIN, INT16_MAX, 0, -1, INT16_MAX};
+    static const uint16_t humis[] = {0, UINT16_MAX, 1, UINT16_MAX, 0};
+    static const uint8_t batts[] = {0, 255, 0, 128, 255};
+    static const uint32_t tss[] = {UINT32_MAX, 0, 1000000000u, 1000, 1000000000u};
+
+    for (size_t i = 0; i < sizeof(tss) / sizeof(tss[0]); i++) {
+        in[i] = (struct history_sample){
+            .ts = tss[i], .temp = temps[i], .humi = humis[i], .batt = batts[i]};
+    }
+    round_trip(in, sizeof(tss) / sizeof(tss[0]), sizeof(enc_buf));
+}
+
+/* 缓冲区放不下时拒绝并保持状态不变，已编码的部分仍可完整解码 */
+static void test_full_buffer(void) {
+    for (size_t i = 0; i < N_SAMPLES; i++) {
+        in[i] = (struct history_sample){
+            .ts = i * 97, .temp = (int16_t)(rnd() % 4000), .humi = (uint16_t)rnd(),
+            .batt = (uint8_t)rnd()};
+    }
+    for (size_t cap = 1; cap < 64; cap++) {
+        round_trip(in, N_SAMPLES, cap);
+    }
+}
+
+/* 擦除态填充表示结束，未知标志位和截断的 varint 报告损坏 */
+static void test_end_and_corruption(void) {
+    struct history_sample s = {.ts = 1700000000u, .temp = -550, .humi = 9000, .batt = 3};
+    struct hist_codec_state enc;
+    struct hist_codec_state dec;
+    struct history_sample out;
+    uint8_t buf[32];
+
+    memset(buf, 0xFF, sizeof(buf));
+    hist_codec_enc_init(&enc, buf, sizeof(buf));
+    CHECK_EQ(hist_codec_enc_add(&enc, &s), 0);
+
+    hist_codec_dec_init(&dec, buf, sizeof(buf));
+    CHECK_EQ(hist_codec_dec_next(&dec, &out), 0);
+    CHECK_EQ(hist_codec_dec_next(&dec, &out), 1);
+
+    buf[0] |= 0x40;
+    hist_codec_dec_init(&dec, buf, sizeof(buf));
+    CHECK_EQ(hist_codec_dec_next(&dec, &out), -1);
+
+    buf[0] &= ~0x40;
+    hist_codec_dec_init(&dec, buf, 2);
+    CHECK_EQ(hist_codec_dec_next(&dec, &out), -1);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_steady_is_one_byte);
+    TEST_RUN(test_random_walk);
+    TEST_RUN(test_extremes);
+    TEST_RUN(test_full_buffer);
+    TEST_RUN(test_end_and_corruption);
+    return test_summary();
+}
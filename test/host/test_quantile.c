@@ -0,0 +1,191 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "quantile.h"
+#include <stdlib.h>
+#include <string.h>
+#include "test_util.h"
+
+/* Defines */
+#define N_MAX 20000
+
+/* Private types */
+typedef int32_t (*gen_fn)(size_t i);
+
+/* Private function declarations */
+static uint32_t rnd(void);
+static int cmp_i32(const void *a, const void *b);
+static int32_t estimate(gen_fn gen, size_t n, uint16_t p);
+static int32_t rank_error(size_t n, uint16_t p, int32_t v);
+static void check_accuracy(gen_fn gen, size_t n, uint16_t p, int trials, int32_t tol);
+
+/* Private variables */
+static uint32_t rnd_state = 0x9E3779B9;
+static int32_t xs[N_MAX];
+
+/* Private functions */
+static uint32_t rnd(void) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static int cmp_i32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* 用 gen 生成 n 个样本存入 xs，逐个更新并检查标记高度单调不减、位置严格递增 */
+static int32_t estimate(gen_fn gen, size_t n, uint16_t p) {
+    struct quantile_p2 est;
+
+    quantile_init(&est, p);
+    for (size_t i = 0; i < n; i++) {
+        xs[i] = gen(i);
+        quantile_add(&est, xs[i]);
+        if (est.count < QUANTILE_MARKERS) {
+            continue;
+        }
+        for (int m = 1; m < QUANTILE_MARKERS; m++) {
+            CHECK(est.q[m - 1] <= est.q[m]);
+            CHECK(est.n[m - 1] < est.n[m]);
+        }
+        CHECK_EQ(est.n[QUANTILE_MARKERS - 1], i + 1);
+    }
+    return quantile_value(&est);
+}
+
+/*
+ * 估计值 v 在 xs 中的秩误差: p 落在 [小于 v 的比例, 不大于 v 的比例] 之外的距离，
+ * 单位 1/10000。与数值误差相比，它不受分布形状和尺度影响。
+ */
+static int32_t rank_error(size_t n, uint16_t p, int32_t v) {
+    int64_t target = (int64_t)p * 10000 / 65535;
+    size_t below = 0;
+    size_t at_or_below;
+    int64_t lo;
+    int64_t hi;
+
+    qsort(xs, n, sizeof(xs[0]), cmp_i32);
+    while (below < n && xs[below] < v) {
+        below++;
+    }
+    for (at_or_below = below; at_or_below < n && xs[at_or_below] <= v; at_or_below++) {
+    }
+    lo = (int64_t)below * 10000 / n;
+    hi = (int64_t)at_or_below * 10000 / n;
+    return (int32_t)(target < lo ? lo - target : target > hi ? target - hi : 0);
+}
+
+/* 重复 trials 次，平均秩误差不超过 tol */
+static void check_accuracy(gen_fn gen, size_t n, uint16_t p, int trials, int32_t tol) {
+    int64_t sum = 0;
+
+    for (int t = 0; t < trials; t++) {
+        int32_t v = estimate(gen, n, p);
+        sum += rank_error(n, p, v);
+    }
+    if (sum / trials > tol) {
+        fprintf(stderr, "n=%zu p=%u: 平均秩误差 %lld/10000，允许 %d\n", n, p,
+                (long long)(sum / trials), tol);
+    }
+    CHECK(sum / trials <= tol);
+}
+
+/* 0.01 °C 单位的温度: 12 个均匀分布之和近似正态，均值 22 °C，标准差 1.5 °C */
+static int32_t gen_normal(size_t i) {
+    int32_t sum = 0;
+
+    for (int k = 0; k < 12; k++) {
+        sum += rnd() % 1001;
+    }
+    return 2200 + (sum - 6000) * 150 / 1000;
+}
+
+static int32_t gen_uniform(size_t i) { return rnd() % 10001; }
+
+/* 白天/夜间两个温度档，中位数落在两峰之间的稀疏区 */
+static int32_t gen_bimodal(size_t i) { return gen_normal(i) + ((rnd() & 1) ? 800 : -800); }
+
+/* 单调上升，P² 的最坏情形之一 */
+static int32_t gen_ramp(size_t i) { return (int32_t)i; }
+
+static int32_t gen_constant(size_t i) { return 2345; }
+
+static void test_few_samples(void) {
+    struct quantile_p2 est;
+
+    quantile_init(&est, QUANTILE_P(0.5));
+    CHECK_EQ(quantile_value(&est), 0);
+    quantile_add(&est, 5);
+    quantile_add(&est, 1);
+    quantile_add(&est, 3);
+    CHECK_EQ(quantile_value(&est), 3);
+
+    quantile_init(&est, QUANTILE_P(0.95));
+    for (int32_t x = 4; x >= 1; x--) {
+        quantile_add(&est, -x);
+    }
+    CHECK_EQ(quantile_value(&est), -1);
+}
+
+static void test_constant(void) {
+    CHECK_EQ(estimate(gen_constant, 1000, QUANTILE_P(0.5)), 2345);
+    CHECK_EQ(estimate(gen_constant, 1000, QUANTILE_P(0.95)), 2345);
+}
+
+/* 整体平移输入(如降到冰点以下)，估计值精确地平移同样的量 */
+static void test_shift_invariant(void) {
+    static const int32_t shifts[] = {-4000, -30000, 5000};
+    struct quantile_p2 base;
+    struct quantile_p2 moved;
+
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        quantile_init(&base, QUANTILE_P(0.95));
+        quantile_init(&moved, QUANTILE_P(0.95));
+        for (int i = 0; i < 1440; i++) {
+            int32_t x = gen_normal(i);
+            quantile_add(&base, x);
+            quantile_add(&moved, x + shifts[s]);
+        }
+        CHECK_EQ(quantile_value(&moved), quantile_value(&base) + shifts[s]);
+    }
+}
+
+/* 小时桶(每分钟一个样本)到一天桶的样本量；样本越少标记越来不及收敛 */
+static void test_normal(void) {
+    check_accuracy(gen_normal, 60, QUANTILE_P(0.5), 200, 400);
+    check_accuracy(gen_normal, 60, QUANTILE_P(0.95), 200, 200);
+    check_accuracy(gen_normal, 360, QUANTILE_P(0.5), 200, 120);
+    check_accuracy(gen_normal, 360, QUANTILE_P(0.95), 200, 100);
+    check_accuracy(gen_normal, 1440, QUANTILE_P(0.5), 100, 50);
+    check_accuracy(gen_normal, 1440, QUANTILE_P(0.95), 100, 50);
+    check_accuracy(gen_normal, N_MAX, QUANTILE_P(0.5), 10, 10);
+    check_accuracy(gen_normal, N_MAX, QUANTILE_P(0.95), 10, 10);
+}
+
+static void test_other_shapes(void) {
+    check_accuracy(gen_uniform, N_MAX, QUANTILE_P(0.5), 10, 20);
+    check_accuracy(gen_uniform, N_MAX, QUANTILE_P(0.95), 10, 20);
+    /* 两峰之间样本稀少，抛物线插值在谷底收敛最慢 */
+    check_accuracy(gen_bimodal, N_MAX, QUANTILE_P(0.5), 10, 50);
+    check_accuracy(gen_bimodal, N_MAX, QUANTILE_P(0.95), 10, 20);
+    check_accuracy(gen_ramp, N_MAX, QUANTILE_P(0.5), 1, 20);
+    check_accuracy(gen_ramp, N_MAX, QUANTILE_P(0.95), 1, 20);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_few_samples);
+    TEST_RUN(test_constant);
+    TEST_RUN(test_shift_invariant);
+    TEST_RUN(test_normal);
+    TEST_RUN(test_other_shapes);
+    return test_summary();
+}
@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "render.h"
+#include <string.h>
+#include "test_util.h"
+
+/* Defines */
+#define MAX_W 32
+#define MAX_ROWS 16
+
+/* Private function declarations */
+static void check_golden(const struct render_scene *scene, uint16_t x, uint16_t y,
+                         uint16_t w, uint16_t band, const char *const *golden,
+                         size_t rows);
+
+/* Private variables */
+/*
+ * 测试字体，与生成的字体格式相同: '0' '1' 宽 3，'-' 宽 9(每行 2 字节)。
+ * 不用构建时生成的字体，金样图不随字形调整而变化。
+ */
+static const uint8_t test_bitmap[] = {
+    0xE0, 0xA0, 0xA0, 0xA0, 0xE0,                       // 0
+    0x40, 0xC0, 0x40, 0x40, 0xE0,                       // 1
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0x80, 0x00, 0x00, 0x00, 0x00, // -
+};
+
+static const struct font_glyph test_glyphs[] = {
+    {0, 3},
+    {5, 3},
+    {10, 9},
+};
+
+static const struct font test_font = {
+    .height = 5,
+    .spacing = 1,
+    .chars = "01-",
+    .glyphs = test_glyphs,
+    .bitmap = test_bitmap,
+};
+
+/* Private functions */
+/*
+ * 以每次 band 行的条带栅格化窗口，与金样图逐像素比较；
+ * 金样图中 '#' 为黑，'.' 为白，对应缓冲区中的 0 和 1
+ */
+static void check_golden(const struct render_scene *scene, uint16_t x, uint16_t y,
+                         uint16_t w, uint16_t band, const char *const *golden,
+                         size_t rows) {
+    uint8_t buf[MAX_W / 8 * MAX_ROWS];
+    uint16_t stride = w / 8;
+
+    for (uint16_t row = 0; row < rows; row += band) {
+        uint16_t n = rows - row < band ? rows - row : band;
+
+        memset(buf, 0xA5, sizeof(buf));
+        render_band(scene, x, y + row, w, n, buf);
+        for (uint16_t r = 0; r < n; r++) {
+            for (uint16_t c = 0; c < w; c++) {
+                bool black = !(buf[r * stride + c / 8] & (0x80 >> (c % 8)));
+                if (black != (golden[row + r][c] == '#')) {
+                    fprintf(stderr, "条带 %u 行: 第 %u 行第 %u 列应为 '%c'\n", band,
+                            row + r, c, golden[row + r][c]);
+                }
+                CHECK(black == (golden[row + r][c] == '#'));
+            }
+        }
+        /* 缓冲区中条带之后的字节不被改写 */
+        CHECK_EQ(buf[stride * n], 0xA5);
+    }
+}
+
+static void build_text_scene(struct render_scene *scene) {
+    render_clear(scene);
+    CHECK_EQ(render_text(scene, 2, 1, &test_font, true, "10-"), 0);
+}
+
+/* 字形位图、字间距，以及超出窗口右边缘的裁剪 */
+static void test_text(void) {
+    static const char *const golden[] = {
+        "................",
+        "...#..###.......",
+        "..##..#.#.......",
+        "...#..#.#.######",
+        "...#..#.#.......",
+        "..###.###.......",
+        "................",
+    };
+    struct render_scene scene;
+
+    build_text_scene(&scene);
+    for (uint16_t band = 1; band <= 7; band++) {
+        check_golden(&scene, 0, 0, 16, band, golden, 7);
+    }
+}
+
+/* 窗口从 x=8 开始，跨越窗口左边缘的字形只画出窗口内的部分 */
+static void test_text_window_offset(void) {
+    static const char *const golden[] = {
+        "#.......",
+        "#.......",
+        "#.######",
+        "#.......",
+        "#.......",
+    };
+    struct render_scene scene;
+
+    build_text_scene(&scene);
+    check_golden(&scene, 8, 1, 8, 2, golden, 5);
+}
+
+/* 按添加顺序绘制，后添加的白色矩形在黑色矩形上挖出空洞 */
+static void test_rect_order(void) {
+    static const char *const golden[] = {
+        "............###.",
+        ".######.........",
+        ".#..###.........",
+        ".#..###.........",
+        ".######.........",
+        "................",
+    };
+    struct render_scene scene;
+
+    render_clear(&scene);
+    CHECK_EQ(render_rect(&scene, 1, 1, 6, 4, true), 0);
+    CHECK_EQ(render_rect(&scene, 2, 2, 2, 2, false), 0);
+    CHECK_EQ(render_rect(&scene, 12, 0, 3, 1, true), 0);
+    for (uint16_t band = 1; band <= 6; band++) {
+        check_golden(&scene, 0, 0, 16, band, golden, 6);
+    }
+}
+
+/* 黑底白字 */
+static void test_inverse_text(void) {
+    static const char *const golden[] = {
+        "########",
+        "#...##.#",
+        "#.#.#..#",
+        "#.#.##.#",
+        "#.#.##.#",
+        "#...#...",
+        "########",
+    };
+    struct render_scene scene;
+
+    render_clear(&scene);
+    CHECK_EQ(render_rect(&scene, 0, 0, 8, 7, true), 0);
+    CHECK_EQ(render_text(&scene, 1, 1, &test_font, false, "01"), 0);
+    check_golden(&scene, 0, 0, 8, 3, golden, 7);
+}
+
+/* 不在字体中的字符不占宽度，超长文本被截断，显示列表满后拒绝添加 */
+static void test_text_width_and_limits(void) {
+    struct render_scene scene;
+
+    CHECK_EQ(render_text_width(&test_font, ""), 0);
+    CHECK_EQ(render_text_width(&test_font, "1"), 3);
+    CHECK_EQ(render_text_width(&test_font, "10"), 7);
+    CHECK_EQ(render_text_width(&test_font, "1x0"), 7);
+    CHECK_EQ(render_text_width(&test_font, "-"), 9);
+
+    render_clear(&scene);
+    CHECK_EQ(render_text(&scene, 0, 0, &test_font, true, "0101010101"), 0);
+    CHECK_EQ(strlen(scene.items[0].text), RENDER_TEXT_MAX - 1);
+    CHECK_EQ(scene.items[0].w, (RENDER_TEXT_MAX - 1) * 4 - 1);
+    CHECK_EQ(scene.items[0].h, test_font.height);
+
+    for (int i = 1; i < RENDER_MAX_ITEMS; i++) {
+        CHECK_EQ(render_rect(&scene, 0, 0, 1, 1, true), 0);
+    }
+    CHECK_EQ(render_rect(&scene, 0, 0, 1, 1, true), -1);
+    CHECK_EQ(render_text(&scene, 0, 0, &test_font, true, "0"), -1);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_text);
+    TEST_RUN(test_text_window_offset);
+    TEST_RUN(test_rect_order);
+    TEST_RUN(test_inverse_text);
+    TEST_RUN(test_text_width_and_limits);
+    return test_summary();
+}
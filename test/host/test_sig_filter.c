@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "sig_filter.h"
+#include <stdlib.h>
+#include "test_util.h"
+
+/* Defines */
+#define N_SAMPLES 5000
+
+/* Private function declarations */
+static uint32_t rnd(void);
+static int32_t noise(int32_t sd);
+
+/* Private variables */
+static uint32_t rnd_state = 0x2545F491;
+
+/* Private functions */
+static uint32_t rnd(void) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+/* 12 个均匀分布之和近似正态，和的标准差为 1000，缩放到 sd */
+static int32_t noise(int32_t sd) {
+    int32_t sum = 0;
+
+    for (int k = 0; k < 12; k++) {
+        sum += rnd() % 1001;
+    }
+    return (sum - 6000) * sd / 1000;
+}
+
+/* 不滤波时原样输出 */
+static void test_passthrough(void) {
+    struct sig_filter f;
+
+    sig_filter_init(&f, 1, 0);
+    for (int i = 0; i < 1000; i++) {
+        int32_t x = 2000 + noise(300);
+        CHECK_EQ(sig_filter_update(&f, x), x);
+    }
+}
+
+/* 第一个样本直接作为 EMA 初值，恒定输入没有偏差也不漂移 */
+static void test_constant_no_bias(void) {
+    static const int32_t levels[] = {-4000, 0, 2345, 9999};
+    struct sig_filter f;
+
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        sig_filter_init(&f, 3, 8);
+        for (int i = 0; i < N_SAMPLES; i++) {
+            CHECK_EQ(sig_filter_update(&f, levels[l]), levels[l]);
+        }
+    }
+}
+
+/* 中值窗口为 n 时，连续不超过 n/2 个的尖峰被完全剔除 */
+static void test_spike_rejection(void) {
+    struct sig_filter f;
+
+    for (uint8_t n = 3; n <= SIG_FILTER_MEDIAN_MAX; n += 2) {
+        sig_filter_init(&f, n, 0);
+        for (int i = 0; i < N_SAMPLES; i++) {
+            /* 每 10 个样本出现一串 n/2 个正负交替的尖峰 */
+            int32_t x = i % 10 >= 5 && i % 10 < 5 + n / 2 ? ((i & 1) ? 9000 : -9000) : 2000;
+            CHECK_EQ(sig_filter_update(&f, x), 2000);
+        }
+    }
+}
+
+/* 白噪声加孤立的尖峰，输出的均方根误差明显小于输入 */
+static void test_noise_reduction(void) {
+    struct sig_filter f;
+    int64_t in_sq = 0;
+    int64_t out_sq = 0;
+    int32_t worst = 0;
+
+    sig_filter_init(&f, 3, 4);
+    for (int i = 0; i < N_SAMPLES; i++) {
+        int32_t n = noise(30);
+        int32_t y = sig_filter_update(&f, 2000 + n + (i % 37 == 0 ? 3000 : 0));
+        if (i < 20) {
+            continue;
+        }
+        /* 只和噪声本身比较，不把尖峰算进输入误差 */
+        in_sq += (int64_t)n * n;
+        out_sq += (int64_t)(y - 2000) * (y - 2000);
+        if (abs(y - 2000) > worst) {
+            worst = abs(y - 2000);
+        }
+    }
+    /* EMA(tau=4) 把白噪声方差降到约 1/9，尖峰使中值偏向邻近样本，留一些余量 */
+    CHECK(out_sq * 6 < in_sq);
+    /* 孤立尖峰不会传到输出 */
+    CHECK(worst < 100);
+}
+
+/* 阶跃响应单调、无过冲，约 5 个时间常数后稳定到新值 */
+static void test_step_response(void) {
+    struct sig_filter f;
+    int32_t prev = 2000;
+
+    sig_filter_init(&f, 3, 4);
+    for (int i = 0; i < 10; i++) {
+        CHECK_EQ(sig_filter_update(&f, 2000), 2000);
+    }
+    for (int i = 0; i < 60; i++) {
+        int32_t y = sig_filter_update(&f, 2500);
+        CHECK(y >= prev && y <= 2500);
+        if (i >= 1 + 5 * 4 + 10) {
+            CHECK(2500 - y <= 2);
+        }
+        prev = y;
+    }
+    for (int i = 0; i < 60; i++) {
+        sig_filter_update(&f, 2500);
+    }
+    CHECK_EQ(sig_filter_update(&f, 2500), 2500);
+}
+
+/* 整体平移输入(如冰点以下)，输出精确地平移同样的量 */
+static void test_shift_invariant(void) {
+    struct sig_filter a;
+    struct sig_filter b;
+
+    sig_filter_init(&a, 5, 6);
+    sig_filter_init(&b, 5, 6);
+    for (int i = 0; i < N_SAMPLES; i++) {
+        int32_t x = 1500 + noise(80);
+        CHECK_EQ(sig_filter_update(&b, x - 5000), sig_filter_update(&a, x) - 5000);
+    }
+}
+
+/* 预置后窗口已满，唤醒后的第一个尖峰同样被剔除，EMA 从预置值继续 */
+static void test_prime(void) {
+    struct sig_filter f;
+
+    sig_filter_init(&f, 3, 4);
+    sig_filter_prime(&f, 2150);
+    CHECK_EQ(sig_filter_update(&f, 8000), 2150);
+    CHECK_EQ(sig_filter_update(&f, 2150), 2150);
+
+    /* 不预置时第一个样本直接输出 */
+    sig_filter_init(&f, 3, 4);
+    CHECK_EQ(sig_filter_update(&f, 8000), 8000);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_passthrough);
+    TEST_RUN(test_constant_no_bias);
+    TEST_RUN(test_spike_rejection);
+    TEST_RUN(test_noise_reduction);
+    TEST_RUN(test_step_response);
+    TEST_RUN(test_shift_invariant);
+    TEST_RUN(test_prime);
+    return test_summary();
+}
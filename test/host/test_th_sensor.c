@@ -0,0 +1,298 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "th_sensor.h"
+#include <string.h>
+#include "test_util.h"
+
+/* Defines */
+#define BUS_MAX 4
+
+/* Private types */
+/* 总线上的模拟器件: kind 为应答 init 的驱动，读数和错误码由测试设定 */
+struct fake_dev {
+    uint8_t addr;
+    const struct th_sensor_driver *kind;
+    struct th_reading reading;
+    esp_err_t trigger_err;
+    esp_err_t collect_err;
+};
+
+/* Private function declarations */
+static struct fake_dev *dev_at(uint8_t addr);
+static void bus_reset(void);
+static struct fake_dev *bus_add(uint8_t addr, const struct th_sensor_driver *kind,
+                                int16_t temp, uint16_t humi);
+static esp_err_t fake_init(struct th_sensor *s);
+static esp_err_t fake_trigger(struct th_sensor *s);
+static esp_err_t fake_collect(struct th_sensor *s, struct th_reading *out);
+static size_t detect_two(struct th_sensor *s);
+
+/* Private variables */
+static struct fake_dev bus[BUS_MAX];
+static int devices_added;
+static int devices_removed;
+
+/* Fakes */
+/* 与真实驱动相同的地址与转换时间，init 只认自己类型的器件 */
+const struct th_sensor_driver th_sensor_sht4x = {
+    .name = "SHT4x", .addrs = {0x44, 0x45}, .conv_ms = SHT4X_CONV_MS,
+    .init = fake_init, .trigger = fake_trigger, .collect = fake_collect,
+};
+const struct th_sensor_driver th_sensor_sht3x = {
+    .name = "SHT3x", .addrs = {0x44, 0x45}, .conv_ms = SHT3X_CONV_MS,
+    .init = fake_init, .trigger = fake_trigger, .collect = fake_collect,
+};
+const struct th_sensor_driver th_sensor_aht20 = {
+    .name = "AHT20", .addrs = {0x38}, .conv_ms = AHT20_CONV_MS,
+    .init = fake_init, .trigger = fake_trigger, .collect = fake_collect,
+};
+const struct th_sensor_driver th_sensor_bme280 = {
+    .name = "BME280", .addrs = {0x76, 0x77}, .conv_ms = BME280_CONV_MS,
+    .init = fake_init, .trigger = fake_trigger, .collect = fake_collect,
+};
+
+esp_err_t i2c_bus_probe(uint8_t addr) { return dev_at(addr) ? ESP_OK : ESP_ERR_NOT_FOUND; }
+
+esp_err_t i2c_bus_add_device(uint8_t addr, uint32_t scl_hz, i2c_master_dev_handle_t *dev) {
+    *dev = (i2c_master_dev_handle_t)dev_at(addr);
+    devices_added++;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_remove_device(i2c_master_dev_handle_t dev) {
+    devices_removed++;
+    return ESP_OK;
+}
+
+/* Private functions */
+static struct fake_dev *dev_at(uint8_t addr) {
+    for (int i = 0; i < BUS_MAX; i++) {
+        if (bus[i].kind != NULL && bus[i].addr == addr) {
+            return &bus[i];
+        }
+    }
+    return NULL;
+}
+
+static void bus_reset(void) {
+    memset(bus, 0, sizeof(bus));
+    devices_added = 0;
+    devices_removed = 0;
+    stub_delayed_ticks = 0;
+}
+
+static struct fake_dev *bus_add(uint8_t addr, const struct th_sensor_driver *kind,
+                                int16_t temp, uint16_t humi) {
+    for (int i = 0; i < BUS_MAX; i++) {
+        if (bus[i].kind == NULL) {
+            bus[i] = (struct fake_dev){addr, kind, {temp, humi}, ESP_OK, ESP_OK};
+            return &bus[i];
+        }
+    }
+    CHECK(0);
+    return NULL;
+}
+
+static esp_err_t fake_init(struct th_sensor *s) {
+    return dev_at(s->addr)->kind == s->drv ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t fake_trigger(struct th_sensor *s) {
+    return ((struct fake_dev *)s->dev)->trigger_err;
+}
+
+static esp_err_t fake_collect(struct th_sensor *s, struct th_reading *out) {
+    struct fake_dev *d = (struct fake_dev *)s->dev;
+
+    if (d->collect_err != ESP_OK) {
+        /* 失败的驱动也可能写坏输出，融合结果不应受影响 */
+        out->temp = 0x5A5A;
+        out->humi = 0xA5A5;
+        return d->collect_err;
+    }
+    *out = d->reading;
+    return ESP_OK;
+}
+
+/* AHT20 与 SHT4x 的典型双传感器组合 */
+static size_t detect_two(struct th_sensor *s) {
+    bus_reset();
+    bus_add(0x38, &th_sensor_aht20, 2150, 4800);
+    bus_add(0x44, &th_sensor_sht4x, 2170, 4900);
+    return th_sensor_detect(s, TH_SENSOR_MAX);
+}
+
+/* 按驱动表顺序识别；SHT4x 占用 0x44 后 SHT3x 不再重复探测 */
+static void test_detect(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+
+    CHECK_EQ(detect_two(s), 2);
+    CHECK(s[0].drv == &th_sensor_aht20);
+    CHECK_EQ(s[0].addr, 0x38);
+    CHECK(s[1].drv == &th_sensor_sht4x);
+    CHECK_EQ(s[1].addr, 0x44);
+    CHECK_EQ(devices_added, 2);
+    CHECK_EQ(devices_removed, 0);
+
+    /* 最多识别 max 个 */
+    bus_reset();
+    bus_add(0x38, &th_sensor_aht20, 0, 0);
+    bus_add(0x44, &th_sensor_sht4x, 0, 0);
+    CHECK_EQ(th_sensor_detect(s, 1), 1);
+    CHECK(s[0].drv == &th_sensor_aht20);
+
+    bus_reset();
+    CHECK_EQ(th_sensor_detect(s, TH_SENSOR_MAX), 0);
+}
+
+/* 同地址的 SHT3x 先被 SHT4x 驱动尝试，失败后移除设备再交给 SHT3x */
+static void test_detect_shared_address(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+
+    bus_reset();
+    bus_add(0x45, &th_sensor_sht3x, 0, 0);
+    CHECK_EQ(th_sensor_detect(s, TH_SENSOR_MAX), 1);
+    CHECK(s[0].drv == &th_sensor_sht3x);
+    CHECK_EQ(s[0].addr, 0x45);
+    CHECK_EQ(devices_removed, 1);
+}
+
+/* 两个读数取平均，只等待较长的转换时间一次 */
+static void test_fuse_two(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    CHECK_EQ(th_sensor_sample(s, 2, &out), ESP_OK);
+    CHECK_EQ(out.count, 2);
+    CHECK_EQ(out.valid_mask, 0x3);
+    CHECK_EQ(out.each[0].temp, 2150);
+    CHECK_EQ(out.each[1].temp, 2170);
+    CHECK_EQ(out.value.temp, 2160);
+    CHECK_EQ(out.value.humi, 4850);
+    CHECK(!out.disagree);
+    CHECK_EQ(stub_delayed_ticks, th_sensor_delay_ticks(AHT20_CONV_MS));
+}
+
+/* 温度差或湿度差超过阈值才标记不一致，恰好等于阈值不算 */
+static void test_disagree_thresholds(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    bus[1].reading.temp = bus[0].reading.temp + CONFIG_TH_SENSOR_DISAGREE_TEMP;
+    th_sensor_sample(s, 2, &out);
+    CHECK(!out.disagree);
+
+    bus[1].reading.temp = bus[0].reading.temp - CONFIG_TH_SENSOR_DISAGREE_TEMP - 1;
+    th_sensor_sample(s, 2, &out);
+    CHECK(out.disagree);
+
+    bus[1].reading.temp = bus[0].reading.temp;
+    bus[1].reading.humi = bus[0].reading.humi + CONFIG_TH_SENSOR_DISAGREE_HUMI + 1;
+    th_sensor_sample(s, 2, &out);
+    CHECK(out.disagree);
+}
+
+/* 一个传感器读取失败: 结果只取另一个，失败的一路为 0 且不置位 */
+static void test_one_collect_fails(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    bus[0].collect_err = ESP_ERR_INVALID_CRC;
+    memset(&out, 0xAA, sizeof(out));
+    CHECK_EQ(th_sensor_sample(s, 2, &out), ESP_OK);
+    CHECK_EQ(out.valid_mask, 0x2);
+    CHECK_EQ(out.each[0].temp, 0);
+    CHECK_EQ(out.each[0].humi, 0);
+    CHECK_EQ(out.value.temp, 2170);
+    CHECK_EQ(out.value.humi, 4900);
+    CHECK(!out.disagree);
+}
+
+/* 触发失败的传感器不参与等待，只等待其余传感器的转换时间 */
+static void test_one_trigger_fails(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    bus[0].trigger_err = ESP_ERR_TIMEOUT;
+    CHECK_EQ(th_sensor_sample(s, 2, &out), ESP_OK);
+    CHECK_EQ(out.valid_mask, 0x2);
+    CHECK_EQ(out.value.temp, 2170);
+    CHECK_EQ(stub_delayed_ticks, th_sensor_delay_ticks(SHT4X_CONV_MS));
+}
+
+/* 全部失败时返回错误码，输出除 count 外全部为 0 */
+static void test_all_fail(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    bus[0].trigger_err = ESP_ERR_TIMEOUT;
+    bus[1].collect_err = ESP_ERR_INVALID_CRC;
+    memset(&out, 0xAA, sizeof(out));
+    CHECK_EQ(th_sensor_sample(s, 2, &out), ESP_ERR_INVALID_CRC);
+    CHECK_EQ(out.count, 2);
+    CHECK_EQ(out.valid_mask, 0);
+    CHECK(!out.disagree);
+    CHECK_EQ(out.value.temp, 0);
+    CHECK_EQ(out.value.humi, 0);
+    for (int i = 0; i < TH_SENSOR_MAX; i++) {
+        CHECK_EQ(out.each[i].temp, 0);
+        CHECK_EQ(out.each[i].humi, 0);
+    }
+
+    /* 没有传感器 */
+    memset(&out, 0xAA, sizeof(out));
+    CHECK_EQ(th_sensor_sample(s, 0, &out), ESP_ERR_NOT_FOUND);
+    CHECK_EQ(out.count, 0);
+    CHECK_EQ(out.valid_mask, 0);
+}
+
+/* 冰点以下的平均值 */
+static void test_fuse_below_zero(void) {
+    struct th_sensor s[TH_SENSOR_MAX];
+    struct th_fused out;
+
+    CHECK_EQ(detect_two(s), 2);
+    bus[0].reading.temp = -1205;
+    bus[1].reading.temp = -1230;
+    CHECK_EQ(th_sensor_sample(s, 2, &out), ESP_OK);
+    CHECK_EQ(out.value.temp, (-1205 + -1230) / 2);
+    CHECK(!out.disagree);
+}
+
+/* 延时向上取整到节拍，再多等一个节拍 */
+static void test_delay_ticks(void) {
+    CHECK_EQ(th_sensor_delay_ticks(1), 2);
+    CHECK_EQ(th_sensor_delay_ticks(portTICK_PERIOD_MS), 2);
+    CHECK_EQ(th_sensor_delay_ticks(portTICK_PERIOD_MS + 1), 3);
+}
+
+/* Sensirion 数据手册中的校验示例: 0xBEEF -> 0x92 */
+static void test_crc8(void) {
+    static const uint8_t data[] = {0xBE, 0xEF};
+
+    CHECK_EQ(th_sensor_crc8(data, sizeof(data)), 0x92);
+}
+
+/* Public functions */
+int main(void) {
+    TEST_RUN(test_detect);
+    TEST_RUN(test_detect_shared_address);
+    TEST_RUN(test_fuse_two);
+    TEST_RUN(test_disagree_thresholds);
+    TEST_RUN(test_one_collect_fails);
+    TEST_RUN(test_one_trigger_fails);
+    TEST_RUN(test_all_fail);
+    TEST_RUN(test_fuse_below_zero);
+    TEST_RUN(test_delay_ticks);
+    TEST_RUN(test_crc8);
+    return test_summary();
+}
@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/* Includes */
+#include "test_util.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Private function declarations */
+static int fork_and_wait(test_fn fn);
+
+/* Private variables */
+static int passed;
+static int failed;
+
+/* Private functions */
+static int fork_and_wait(test_fn fn) {
+    int status;
+    pid_t pid;
+
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        fn();
+        fflush(NULL);
+        _exit(0);
+    }
+    if (waitpid(pid, &status, 0) != pid) {
+        return -1;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+/* Public functions */
+void test_run(const char *name, test_fn fn) {
+    if (fork_and_wait(fn) == 0) {
+        printf("[通过] %s\n", name);
+        passed++;
+    } else {
+        printf("[失败] %s\n", name);
+        failed++;
+    }
+}
+
+void test_boot(test_fn fn) { CHECK(fork_and_wait(fn) == 0); }
+
+int test_summary(void) {
+    printf("%d 项通过，%d 项失败\n", passed, failed);
+    return failed == 0 ? 0 : 1;
+}
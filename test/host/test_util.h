@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+/* Includes */
+/* STD APIs */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+
+/* Defines */
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                         \
+    do {                                                                       \
+        long long a_ = (long long)(a);                                         \
+        long long b_ = (long long)(b);                                         \
+        if (a_ != b_) {                                                        \
+            fprintf(stderr, "%s:%d: 检查失败: %s == %s (%lld != %lld)\n",     \
+                    __FILE__, __LINE__, #a, #b, a_, b_);                       \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+#define TEST_RUN(fn) test_run(#fn, fn)
+
+/*
+ * 被测模块都把状态放在静态变量里，每个测试在单独的子进程中运行，
+ * 互不影响；子进程中再 fork 一次即相当于设备上电重启(RAM 回到初始状态)。
+ */
+typedef void (*test_fn)(void);
+
+/* Public function declarations */
+void test_run(const char *name, test_fn fn);
+
+/* 在子进程中运行 fn 并等待其结束，fn 失败时当前测试也失败 */
+void test_boot(test_fn fn);
+
+/* 打印结果，返回进程退出码 */
+int test_summary(void);
+
+/* freertos 桩累计的 vTaskDelay 节拍数 */
+extern TickType_t stub_delayed_ticks;
+
+#endif // TEST_UTIL_H